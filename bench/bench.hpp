@@ -0,0 +1,121 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_MVCC_BENCH_BENCH_HPP
+#define LIBBITCOIN_MVCC_BENCH_BENCH_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace libbitcoin {
+namespace database {
+namespace bench {
+
+/**
+ * Passed to each benchmark, which does its setup and then times the
+ * operation under test with measure.
+ */
+class state
+{
+public:
+    state(size_t iterations)
+      : iterations_(iterations), elapsed_(0)
+    {
+    }
+
+    /// Time iterations calls of operation, setup before the call is
+    /// not timed.
+    template <typename function>
+    void measure(function operation)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t iteration = 0; iteration < iterations_; ++iteration)
+            operation();
+
+        elapsed_ += std::chrono::steady_clock::now() - start;
+    }
+
+    size_t iterations() const
+    {
+        return iterations_;
+    }
+
+    std::chrono::nanoseconds elapsed() const
+    {
+        return elapsed_;
+    }
+
+    /// Report a value measured by the benchmark itself, printed after
+    /// the time per operation.
+    void report(const std::string& name, double value)
+    {
+        counters_.emplace_back(name, value);
+    }
+
+    const std::vector<std::pair<std::string, double>>& counters() const
+    {
+        return counters_;
+    }
+
+private:
+    const size_t iterations_;
+    std::chrono::nanoseconds elapsed_;
+    std::vector<std::pair<std::string, double>> counters_;
+};
+
+typedef std::function<void(state&)> benchmark;
+typedef std::vector<std::pair<std::string, benchmark>> benchmark_list;
+
+inline benchmark_list& benchmarks()
+{
+    static benchmark_list list;
+    return list;
+}
+
+struct registrar
+{
+    registrar(const std::string& name, benchmark function)
+    {
+        benchmarks().emplace_back(name, function);
+    }
+};
+
+/// Keep value alive so the compiler cannot drop the code computing it.
+template <typename type>
+inline void do_not_optimize(const type& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+} // namespace bench
+} // namespace database
+} // namespace libbitcoin
+
+/// Define and register a benchmark, the body receives bench::state&
+/// as state.
+#define BENCHMARK(name) \
+    static void name(libbitcoin::database::bench::state&); \
+    static const libbitcoin::database::bench::registrar \
+        name##_registrar(#name, name); \
+    static void name(libbitcoin::database::bench::state& state)
+
+#endif
@@ -0,0 +1,141 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <bitcoin/system.hpp>
+#include <bitcoin/database/container/art_index.hpp>
+#include <bitcoin/database/container/fingerprint_index.hpp>
+#include <bitcoin/database/storage/raw_block.hpp>
+#include <bitcoin/database/storage/slot.hpp>
+
+#include "../bench.hpp"
+
+using namespace bc;
+using namespace bc::database;
+using namespace bc::database::container;
+using namespace bc::database::storage;
+using namespace bc::system;
+
+namespace {
+
+static const size_t key_count = 1000000;
+
+// Distinct digests standing in for records, found by slot. Slots fill
+// one offset at a time across as many blocks as needed.
+struct records
+{
+    records()
+      : hashes(key_count)
+    {
+        for (uint64_t key = 0; key < key_count; ++key)
+        {
+            data_chunk data(sizeof(key));
+            std::memcpy(data.data(), &key, sizeof(key));
+            hashes[key] = bitcoin_hash(data);
+        }
+    }
+
+    static slot slot_of(size_t key)
+    {
+        const auto block = uintptr_t(key / (BLOCK_SIZE - 1) + 1) * BLOCK_SIZE;
+        return { reinterpret_cast<raw_block*>(block),
+            static_cast<uint32_t>(key % (BLOCK_SIZE - 1) + 1) };
+    }
+
+    static size_t key_of(const slot& at)
+    {
+        const auto block = reinterpret_cast<uintptr_t>(at.get_block()) /
+            BLOCK_SIZE - 1;
+        return block * (BLOCK_SIZE - 1) + at.get_offset() - 1;
+    }
+
+    art_index::loader loader() const
+    {
+        return [this](const slot& at) -> const hash_digest&
+        {
+            return hashes[key_of(at)];
+        };
+    }
+
+    std::vector<hash_digest> hashes;
+};
+
+const records& stored()
+{
+    static const records instance;
+    return instance;
+}
+
+template <typename index>
+void insert(bench::state& state)
+{
+    const auto& hashes = stored().hashes;
+    state.measure([&]()
+    {
+        index instance(stored().loader());
+        for (size_t key = 0; key < hashes.size(); ++key)
+            instance.insert(hashes[key], records::slot_of(key));
+
+        bench::do_not_optimize(instance.size());
+    });
+}
+
+template <typename index>
+void find(bench::state& state)
+{
+    const auto& hashes = stored().hashes;
+    index instance(stored().loader());
+    for (size_t key = 0; key < hashes.size(); ++key)
+        instance.insert(hashes[key], records::slot_of(key));
+
+    state.measure([&]()
+    {
+        size_t count = 0;
+        slot out;
+        for (const auto& hash: hashes)
+            count += instance.find(hash, out) ? 1 : 0;
+
+        bench::do_not_optimize(count);
+    });
+}
+
+} // namespace
+
+BENCHMARK(art_index__insert__random_hashes)
+{
+    insert<art_index>(state);
+}
+
+BENCHMARK(fingerprint_index__insert__random_hashes)
+{
+    insert<fingerprint_index>(state);
+}
+
+BENCHMARK(art_index__find__random_hashes)
+{
+    find<art_index>(state);
+}
+
+BENCHMARK(fingerprint_index__find__random_hashes)
+{
+    find<fingerprint_index>(state);
+}
@@ -0,0 +1,122 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <bitcoin/system.hpp>
+#include <bitcoin/database/container/filtered_index.hpp>
+#include <bitcoin/database/container/fingerprint_index.hpp>
+#include <bitcoin/database/storage/raw_block.hpp>
+#include <bitcoin/database/storage/slot.hpp>
+
+#include "../bench.hpp"
+
+using namespace bc;
+using namespace bc::database;
+using namespace bc::database::container;
+using namespace bc::database::storage;
+using namespace bc::system;
+
+namespace {
+
+// The first half is indexed, the second half is looked up and missed.
+static const size_t key_count = 1000000;
+
+typedef filtered_index<fingerprint_index> filtered_fingerprint_index;
+
+const std::vector<hash_digest>& hashes()
+{
+    static const auto instance = []()
+    {
+        std::vector<hash_digest> out(2 * key_count);
+        for (uint64_t key = 0; key < out.size(); ++key)
+        {
+            data_chunk data(sizeof(key));
+            std::memcpy(data.data(), &key, sizeof(key));
+            out[key] = bitcoin_hash(data);
+        }
+
+        return out;
+    }();
+
+    return instance;
+}
+
+slot slot_of(size_t key)
+{
+    return { reinterpret_cast<raw_block*>(uintptr_t(BLOCK_SIZE)),
+        static_cast<uint32_t>(key + 1) };
+}
+
+const hash_digest& load(const slot& at)
+{
+    return hashes()[at.get_offset() - 1];
+}
+
+void find(bench::state& state, bool filter, bool missing)
+{
+    const auto& keys = hashes();
+    filtered_fingerprint_index index(fingerprint_index::loader{ load });
+    if (filter)
+        index.enable_filter(key_count);
+
+    for (size_t key = 0; key < key_count; ++key)
+        index.insert(keys[key], slot_of(key));
+
+    const auto first = missing ? key_count : 0;
+    state.measure([&]()
+    {
+        size_t found = 0;
+        slot out;
+        for (size_t key = first; key < first + key_count; ++key)
+            found += index.find(keys[key], out) ? 1 : 0;
+
+        bench::do_not_optimize(found);
+    });
+
+    const auto counters = index.lookup_counters();
+    state.report("rejected", counters.rejected);
+    state.report("false positives", counters.false_positives);
+    state.report("filter blocks", index.filter().blocks());
+    state.report("saturated blocks", index.filter().saturated_blocks());
+}
+
+} // namespace
+
+BENCHMARK(filtered_index__find__missing_unfiltered)
+{
+    find(state, false, true);
+}
+
+BENCHMARK(filtered_index__find__missing_filtered)
+{
+    find(state, true, true);
+}
+
+BENCHMARK(filtered_index__find__present_unfiltered)
+{
+    find(state, false, false);
+}
+
+BENCHMARK(filtered_index__find__present_filtered)
+{
+    find(state, true, false);
+}
@@ -0,0 +1,110 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <bitcoin/system.hpp>
+#include <bitcoin/database/container/fingerprint_index.hpp>
+#include <bitcoin/database/storage/raw_block.hpp>
+#include <bitcoin/database/storage/slot.hpp>
+
+#include "../bench.hpp"
+
+using namespace bc;
+using namespace bc::database;
+using namespace bc::database::container;
+using namespace bc::database::storage;
+using namespace bc::system;
+
+namespace {
+
+static const size_t key_count = 2000000;
+
+const std::vector<hash_digest>& hashes()
+{
+    static const auto instance = []()
+    {
+        std::vector<hash_digest> out(key_count);
+        for (uint64_t key = 0; key < key_count; ++key)
+        {
+            data_chunk data(sizeof(key));
+            std::memcpy(data.data(), &key, sizeof(key));
+            out[key] = bitcoin_hash(data);
+        }
+
+        return out;
+    }();
+
+    return instance;
+}
+
+slot slot_of(size_t key)
+{
+    return { reinterpret_cast<raw_block*>(uintptr_t(BLOCK_SIZE)),
+        static_cast<uint32_t>(key % (BLOCK_SIZE - 1) + 1) };
+}
+
+// Times the slowest of the inserts, which is the one that grows the
+// index when it is not reserved.
+void insert(bench::state& state, bool reserve)
+{
+    const auto& keys = hashes();
+    const fingerprint_index::verifier any = [](const slot&,
+        const hash_digest&)
+    {
+        return false;
+    };
+
+    std::chrono::nanoseconds slowest(0);
+    state.measure([&]()
+    {
+        fingerprint_index index(any);
+        if (reserve)
+            index.reserve(keys.size());
+
+        for (size_t key = 0; key < keys.size(); ++key)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            index.insert(keys[key], slot_of(key));
+            slowest = std::max(slowest, std::chrono::duration_cast<
+                std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                    start));
+        }
+
+        bench::do_not_optimize(index.size());
+    });
+
+    state.report("slowest insert ns", slowest.count());
+}
+
+} // namespace
+
+BENCHMARK(fingerprint_index__insert__growing)
+{
+    insert(state, false);
+}
+
+BENCHMARK(fingerprint_index__insert__reserved)
+{
+    insert(state, true);
+}
@@ -0,0 +1,119 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <bitcoin/system.hpp>
+#include <bitcoin/database/container/hash_digest_hasher.hpp>
+#include <libcuckoo/cuckoohash_map.hh>
+
+#include "../bench.hpp"
+
+using namespace bc;
+using namespace bc::database;
+using namespace bc::database::container;
+using namespace bc::system;
+
+namespace {
+
+static const size_t key_count = 1000000;
+
+typedef libcuckoo::cuckoohash_map<hash_digest, uint64_t> default_map;
+typedef libcuckoo::cuckoohash_map<hash_digest, uint64_t,
+    hash_digest_hasher<>, hash_digest_equal> digest_map;
+
+// Distinct digests, built once.
+const std::vector<hash_digest>& keys()
+{
+    static const auto instance = []()
+    {
+        std::vector<hash_digest> hashes;
+        hashes.reserve(key_count);
+        for (uint64_t key = 0; key < key_count; ++key)
+        {
+            data_chunk data(sizeof(key));
+            std::memcpy(data.data(), &key, sizeof(key));
+            hashes.push_back(bitcoin_hash(data));
+        }
+
+        return hashes;
+    }();
+
+    return instance;
+}
+
+// Each iteration inserts every key into an empty map.
+template <typename map>
+void insert(bench::state& state)
+{
+    const auto& hashes = keys();
+    state.measure([&]()
+    {
+        map index;
+        for (size_t key = 0; key < hashes.size(); ++key)
+            index.insert(hashes[key], key);
+
+        bench::do_not_optimize(index.size());
+    });
+}
+
+// Each iteration finds every key in a full map.
+template <typename map>
+void find(bench::state& state)
+{
+    const auto& hashes = keys();
+    map index;
+    for (size_t key = 0; key < hashes.size(); ++key)
+        index.insert(hashes[key], key);
+
+    state.measure([&]()
+    {
+        uint64_t sum = 0;
+        uint64_t value;
+        for (const auto& hash: hashes)
+            if (index.find(hash, value))
+                sum += value;
+
+        bench::do_not_optimize(sum);
+    });
+}
+
+} // namespace
+
+BENCHMARK(hash_digest_index__insert__default_hasher)
+{
+    insert<default_map>(state);
+}
+
+BENCHMARK(hash_digest_index__insert__hash_digest_hasher)
+{
+    insert<digest_map>(state);
+}
+
+BENCHMARK(hash_digest_index__find__default_hasher)
+{
+    find<default_map>(state);
+}
+
+BENCHMARK(hash_digest_index__find__hash_digest_hasher)
+{
+    find<digest_map>(state);
+}
@@ -0,0 +1,173 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <bitcoin/database/container/ordered_index.hpp>
+#include <bitcoin/database/storage/raw_block.hpp>
+#include <bitcoin/database/storage/slot.hpp>
+#include <libcuckoo/cuckoohash_map.hh>
+
+#include "../bench.hpp"
+
+using namespace bc::database;
+using namespace bc::database::container;
+using namespace bc::database::storage;
+
+namespace {
+
+static const size_t key_count = 1000000;
+
+typedef ordered_index<uint64_t> ordered_map;
+typedef libcuckoo::cuckoohash_map<uint64_t, slot> hash_map;
+
+slot slot_at(uint64_t key)
+{
+    return { reinterpret_cast<raw_block*>(uintptr_t(BLOCK_SIZE)),
+        static_cast<uint32_t>(key % (BLOCK_SIZE - 1) + 1) };
+}
+
+// Distinct keys in random order, built once.
+const std::vector<uint64_t>& keys()
+{
+    static const auto instance = []()
+    {
+        std::vector<uint64_t> out;
+        out.reserve(key_count);
+        uint64_t state = 0x2545f4914f6cdd1dull;
+        for (size_t key = 0; key < key_count; ++key)
+        {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            out.push_back(state);
+        }
+
+        return out;
+    }();
+
+    return instance;
+}
+
+const ordered_map& full_ordered_map()
+{
+    static const auto instance = []()
+    {
+        auto sorted = keys();
+        std::sort(sorted.begin(), sorted.end());
+
+        ordered_map::value_list values;
+        values.reserve(sorted.size());
+        for (const auto key: sorted)
+            values.emplace_back(key, slot_at(key));
+
+        auto index = new ordered_map;
+        index->bulk_load(values);
+        return index;
+    }();
+
+    return *instance;
+}
+
+} // namespace
+
+BENCHMARK(ordered_index__insert__random_keys)
+{
+    const auto& inserted = keys();
+    state.measure([&]()
+    {
+        ordered_map index;
+        for (const auto key: inserted)
+            index.insert(key, slot_at(key));
+
+        bench::do_not_optimize(index.size());
+    });
+}
+
+BENCHMARK(ordered_index__bulk_load__sorted_keys)
+{
+    auto sorted = keys();
+    std::sort(sorted.begin(), sorted.end());
+
+    ordered_map::value_list values;
+    for (const auto key: sorted)
+        values.emplace_back(key, slot_at(key));
+
+    state.measure([&]()
+    {
+        ordered_map index;
+        index.bulk_load(values);
+        bench::do_not_optimize(index.size());
+    });
+}
+
+BENCHMARK(ordered_index__find__random_keys)
+{
+    const auto& index = full_ordered_map();
+    const auto& found = keys();
+    state.measure([&]()
+    {
+        size_t count = 0;
+        slot out;
+        for (const auto key: found)
+            count += index.find(key, out) ? 1 : 0;
+
+        bench::do_not_optimize(count);
+    });
+}
+
+BENCHMARK(cuckoo_map__find__random_keys)
+{
+    const auto& found = keys();
+    hash_map index;
+    for (const auto key: found)
+        index.insert(key, slot_at(key));
+
+    state.measure([&]()
+    {
+        size_t count = 0;
+        slot out;
+        for (const auto key: found)
+            count += index.find(key, out) ? 1 : 0;
+
+        bench::do_not_optimize(count);
+    });
+}
+
+// Scans of 100 keys from random starting keys, which a hash map cannot
+// do without a full scan.
+BENCHMARK(ordered_index__scan__100_keys)
+{
+    const auto& index = full_ordered_map();
+    const auto& starts = keys();
+    state.measure([&]()
+    {
+        size_t count = 0;
+        for (size_t start = 0; start < starts.size(); start += 100)
+        {
+            auto it = index.lower_bound(starts[start]);
+            for (size_t step = 0; step < 100 && it != index.end(); ++step)
+                count += (it++).value() ? 1 : 0;
+        }
+
+        bench::do_not_optimize(count);
+    });
+}
@@ -0,0 +1,145 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <bitcoin/system.hpp>
+#include <bitcoin/database/container/hash_digest_hasher.hpp>
+#include <bitcoin/database/container/outpoint_index.hpp>
+#include <bitcoin/database/storage/raw_block.hpp>
+#include <bitcoin/database/storage/slot.hpp>
+#include <libcuckoo/cuckoohash_map.hh>
+
+#include "../bench.hpp"
+
+using namespace bc;
+using namespace bc::database;
+using namespace bc::database::container;
+using namespace bc::database::storage;
+using namespace bc::system;
+
+namespace {
+
+static const size_t point_count = 2000000;
+
+// Outpoints of transactions with two outputs each.
+const chain::point::list& points()
+{
+    static const auto instance = []()
+    {
+        chain::point::list out;
+        out.reserve(point_count);
+        for (uint64_t key = 0; key < point_count / 2; ++key)
+        {
+            data_chunk data(sizeof(key));
+            std::memcpy(data.data(), &key, sizeof(key));
+            const auto hash = bitcoin_hash(data);
+            out.emplace_back(hash, 0);
+            out.emplace_back(hash, 1);
+        }
+
+        return out;
+    }();
+
+    return instance;
+}
+
+// Distinct slots that map back to their key, the blocks are never read.
+static const size_t offset_bits = 19;
+
+slot slot_of(size_t key)
+{
+    return { reinterpret_cast<raw_block*>(
+        uintptr_t((key >> offset_bits) + 1) * BLOCK_SIZE),
+        static_cast<uint32_t>(key & ((1u << offset_bits) - 1)) };
+}
+
+size_t key_of(const slot& at)
+{
+    const auto block = reinterpret_cast<uintptr_t>(at.get_block());
+    return ((block / BLOCK_SIZE - 1) << offset_bits) | at.get_offset();
+}
+
+typedef libcuckoo::cuckoohash_map<chain::point, slot, point_hasher>
+    point_map;
+
+// The bytes of a point_map bucket, four entries of point and slot with
+// their partial keys and occupancy flags.
+static const size_t point_bucket_bytes = sizeof(
+    libcuckoo::bucket_container<chain::point, slot,
+        std::allocator<std::pair<const chain::point, slot>>, uint8_t,
+        point_map::slot_per_bucket()>::bucket);
+
+} // namespace
+
+// An index keyed by whole outpoints, 48 bytes an entry.
+BENCHMARK(outpoint_index__insert_find__full_point_keys)
+{
+    const auto& keys = points();
+    size_t bytes = 0;
+    state.measure([&]()
+    {
+        point_map index;
+        index.reserve(keys.size() + keys.size() / 9);
+        for (size_t key = 0; key < keys.size(); ++key)
+            index.insert(keys[key], slot_of(key));
+
+        slot out;
+        for (const auto& key: keys)
+            bench::do_not_optimize(index.find(key, out));
+
+        bytes = index.bucket_count() * point_bucket_bytes;
+    });
+
+    state.report("table bytes per point", double(bytes) / keys.size());
+}
+
+// The compact key index, verified against the outpoint of each slot as
+// the utxo store does from its cold column.
+BENCHMARK(outpoint_index__insert_find__compact_keys)
+{
+    const auto& keys = points();
+    const outpoint_index::verifier verify = [&](const slot& at,
+        const chain::point& point)
+    {
+        return keys[key_of(at)] == point;
+    };
+
+    size_t bytes = 0;
+    size_t overflow = 0;
+    state.measure([&]()
+    {
+        outpoint_index index(verify);
+        index.reserve(keys.size());
+        for (size_t key = 0; key < keys.size(); ++key)
+            index.insert(keys[key], slot_of(key));
+
+        slot out;
+        for (const auto& key: keys)
+            bench::do_not_optimize(index.find(key, out));
+
+        bytes = index.bytes();
+        overflow = index.overflow_size();
+    });
+
+    state.report("table bytes per point", double(bytes) / keys.size());
+    state.report("overflow", overflow);
+}
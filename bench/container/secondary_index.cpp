@@ -0,0 +1,169 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <bitcoin/system.hpp>
+#include <bitcoin/database/container/art_index.hpp>
+#include <bitcoin/database/container/secondary_index.hpp>
+#include <bitcoin/database/storage/raw_block.hpp>
+#include <bitcoin/database/storage/slot.hpp>
+#include <bitcoin/database/storage/util.hpp>
+
+#include "../bench.hpp"
+
+using namespace bc;
+using namespace bc::database;
+using namespace bc::database::container;
+using namespace bc::database::storage;
+using namespace bc::system;
+
+namespace {
+
+static const size_t key_count = 1000000;
+static const size_t batch_size = 64;
+
+typedef secondary_index<uint64_t, hash_digest, art_index> by_number;
+
+// Records are 64 byte lines holding their hash, in blocks.
+struct records
+{
+    records()
+      : lines(key_count)
+    {
+        for (uint64_t key = 0; key < key_count; ++key)
+        {
+            data_chunk data(sizeof(key));
+            std::memcpy(data.data(), &key, sizeof(key));
+            lines[key].hash = bitcoin_hash(data);
+        }
+    }
+
+    static slot slot_of(size_t key)
+    {
+        const auto block = uintptr_t(key / (BLOCK_SIZE - 1) + 1) * BLOCK_SIZE;
+        return { reinterpret_cast<raw_block*>(block),
+            static_cast<uint32_t>(key % (BLOCK_SIZE - 1) + 1) };
+    }
+
+    static size_t key_of(const slot& at)
+    {
+        const auto block = reinterpret_cast<uintptr_t>(at.get_block()) /
+            BLOCK_SIZE - 1;
+        return block * (BLOCK_SIZE - 1) + at.get_offset() - 1;
+    }
+
+    struct alignas(64) line
+    {
+        hash_digest hash;
+    };
+
+    std::vector<line> lines;
+};
+
+struct indexes
+{
+    indexes()
+      : primary(std::make_shared<art_index>(
+            [this](const slot& at) -> const hash_digest&
+            {
+                return stored.lines[records::key_of(at)].hash;
+            })),
+        secondary(primary)
+    {
+        secondary.reserve(key_count);
+        for (size_t key = 0; key < key_count; ++key)
+        {
+            primary->insert(stored.lines[key].hash, records::slot_of(key));
+            secondary.insert(key * 7919 % key_count, stored.lines[key].hash);
+        }
+    }
+
+    records stored;
+    std::shared_ptr<art_index> primary;
+    by_number secondary;
+};
+
+const indexes& shared_indexes()
+{
+    static const indexes instance;
+    return instance;
+}
+
+// The keys of each batch, spread over the whole index.
+std::vector<by_number::key_list> batches()
+{
+    std::vector<by_number::key_list> out(key_count / batch_size);
+    uint64_t key = 0;
+    for (auto& batch: out)
+        for (size_t index = 0; index < batch_size; ++index)
+            batch.push_back((key += 104729) % key_count);
+
+    return out;
+}
+
+} // namespace
+
+BENCHMARK(secondary_index__find__one_at_a_time)
+{
+    const auto& shared = shared_indexes();
+    const auto keys = batches();
+    state.measure([&]()
+    {
+        size_t sum = 0;
+        for (const auto& batch: keys)
+        {
+            for (const auto key: batch)
+            {
+                slot out;
+                if (shared.secondary.find(key, out))
+                    sum += shared.stored.lines[records::key_of(out)].hash[0];
+            }
+        }
+
+        bench::do_not_optimize(sum);
+    });
+}
+
+BENCHMARK(secondary_index__find__batched_with_prefetch)
+{
+    const auto& shared = shared_indexes();
+    const auto keys = batches();
+    state.measure([&]()
+    {
+        size_t sum = 0;
+        std::vector<slot> slots;
+        for (const auto& batch: keys)
+        {
+            shared.secondary.find(batch, slots, [&](const slot& at)
+            {
+                util::prefetch(&shared.stored.lines[records::key_of(at)]);
+            });
+
+            for (const auto& at: slots)
+                if (at)
+                    sum += shared.stored.lines[records::key_of(at)].hash[0];
+        }
+
+        bench::do_not_optimize(sum);
+    });
+}
@@ -0,0 +1,189 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include <bitcoin/system.hpp>
+#include <bitcoin/database/block_state.hpp>
+#include <bitcoin/database/databases/block_database.hpp>
+#include <bitcoin/database/transaction_management/transaction_manager.hpp>
+
+#include "../bench.hpp"
+
+using namespace bc;
+using namespace bc::database;
+using namespace bc::system;
+
+namespace {
+
+static const size_t chain_height = 100000;
+
+// About 650MB resident, well past the last level cache.
+static const size_t large_chain_height = 1000000;
+
+// A candidate chain of height headers, built once.
+struct candidate_chain
+{
+    candidate_chain(size_t height)
+      : instance(height / 1500 + 1, 1, height / 1500 + 1, 1)
+    {
+        static const auto settings = system::settings(
+            system::config::settings::mainnet);
+        const auto genesis = settings.genesis_block.header();
+
+        chain::header::list headers;
+        headers.reserve(height);
+        for (size_t index = 0; index < height; ++index)
+            headers.emplace_back(genesis.version(),
+                index == 0 ? genesis.previous_block_hash() :
+                    headers[index - 1].hash(),
+                genesis.merkle_root(), genesis.timestamp(), genesis.bits(),
+                genesis.nonce() + index);
+
+        hashes.reserve(height);
+        for (const auto& header: headers)
+            hashes.push_back(header.hash());
+
+        auto context = manager.begin_transaction();
+        instance.store_headers(context, headers, 0,
+            std::vector<uint32_t>(height, 0), block_state::missing);
+        for (size_t index = 0; index < height; ++index)
+            instance.promote(context, hashes[index], index, true);
+        context.commit();
+
+        // In an order unrelated to height, as the transactions of a new
+        // block refer to them.
+        shuffled = hashes;
+        std::mt19937_64 random(42);
+        std::shuffle(shuffled.begin(), shuffled.end(), random);
+    }
+
+    transaction_manager manager;
+    block_database instance;
+    hash_list hashes;
+    hash_list shuffled;
+};
+
+candidate_chain& shared_chain()
+{
+    static candidate_chain instance(chain_height);
+    return instance;
+}
+
+candidate_chain& large_chain()
+{
+    static candidate_chain instance(large_chain_height);
+    return instance;
+}
+
+void multi_get(bench::state& state, candidate_chain& chain, size_t width)
+{
+    auto context = chain.manager.begin_transaction();
+
+    std::vector<block_tuple_ptr> out;
+    state.measure([&]()
+    {
+        bench::do_not_optimize(chain.instance.multi_get(context,
+            chain.shuffled, out, width));
+    });
+}
+
+} // namespace
+
+// The locator built from tuples read at each height, as callers did
+// before locator().
+BENCHMARK(block_database__locator__from_tuples)
+{
+    auto& candidate = shared_chain();
+    auto context = candidate.manager.begin_transaction();
+
+    state.measure([&]()
+    {
+        hash_list locator;
+        size_t top;
+        candidate.instance.top(context, top, true);
+
+        size_t step = 1;
+        for (auto height = top; height > 0;
+            height = height > step ? height - step : 0)
+        {
+            if (locator.size() >= 10)
+                step <<= 1;
+
+            const auto block = candidate.instance.get(context, height, true);
+            locator.push_back(chain::header(block->version,
+                block->previous_block_hash, block->merkle_root,
+                block->timestamp, block->bits, block->nonce).hash());
+        }
+
+        bench::do_not_optimize(locator);
+    });
+}
+
+BENCHMARK(block_database__locator__from_hash_column)
+{
+    auto& candidate = shared_chain();
+    auto context = candidate.manager.begin_transaction();
+
+    state.measure([&]()
+    {
+        hash_list locator;
+        candidate.instance.locator(context, true, locator);
+        bench::do_not_optimize(locator);
+    });
+}
+
+BENCHMARK(block_database__get__by_hash)
+{
+    auto& candidate = shared_chain();
+    auto context = candidate.manager.begin_transaction();
+
+    state.measure([&]()
+    {
+        size_t found = 0;
+        for (const auto& hash: candidate.shuffled)
+            found += candidate.instance.get(context, hash) ? 1 : 0;
+
+        bench::do_not_optimize(found);
+    });
+}
+
+BENCHMARK(block_database__multi_get__by_hash)
+{
+    multi_get(state, shared_chain(), 16);
+}
+
+// The sequential path and the interleaved one over a working set much
+// larger than the cache.
+BENCHMARK(block_database__multi_get__large_sequential)
+{
+    multi_get(state, large_chain(), 1);
+}
+
+BENCHMARK(block_database__multi_get__large_interleaved_8)
+{
+    multi_get(state, large_chain(), 8);
+}
+
+BENCHMARK(block_database__multi_get__large_interleaved_16)
+{
+    multi_get(state, large_chain(), 16);
+}
@@ -0,0 +1,263 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <bitcoin/system.hpp>
+#include <bitcoin/database/databases/utxo_database.hpp>
+#include <bitcoin/database/transaction_management/transaction_manager.hpp>
+
+#include "../bench.hpp"
+
+using namespace bc;
+using namespace bc::database;
+using namespace bc::system;
+
+namespace {
+
+// Roughly a recent mainnet block, 3000 transactions of 2.5 inputs and
+// 2.5 outputs on average.
+static const size_t block_transactions = 3000;
+static const size_t block_inputs = 7000;
+
+// Outputs stored before the replay, in blocks that spend nothing.
+static const size_t set_size = 2000000;
+
+// Half of the spends are of outputs of the last few blocks, the rest
+// are of outputs anywhere in the set.
+static const double recent_spends = 0.5;
+static const size_t recent_outputs = 50000;
+
+// Output script sizes, weighted by their share of outputs: p2wpkh,
+// p2tr, p2pkh, p2sh, p2wsh, op_return and bare multisig.
+static const std::vector<size_t> script_sizes{ 22, 34, 25, 23, 34, 40, 105 };
+static const std::vector<double> script_weights{ 40, 20, 15, 13, 6, 5, 1 };
+
+// Synthetic blocks spending outputs of earlier ones, in the order
+// they are connected.
+class block_source
+{
+public:
+    block_source()
+      : random_(42), inputs_(1, 4), outputs_(1, 4),
+        scripts_(script_weights.begin(), script_weights.end())
+    {
+    }
+
+    chain::block next(bool spends)
+    {
+        chain::transaction::list txs(block_transactions);
+        for (size_t tx = 0; tx < txs.size(); ++tx)
+        {
+            auto& inputs = txs[tx].inputs();
+            if (tx == 0 || !spends || unspent_.empty())
+            {
+                // A coinbase, its hash is made unique by the height.
+                inputs.resize(1);
+                hash_digest unique{};
+                std::copy_n(reinterpret_cast<const uint8_t*>(&height_),
+                    sizeof(height_), unique.begin());
+                unique[sizeof(height_)] = uint8_t(tx >> 8);
+                unique[sizeof(height_) + 1] = uint8_t(tx);
+                inputs[0].previous_output() = { unique, 0 };
+            }
+            else
+            {
+                inputs.resize(inputs_(random_));
+                for (auto& input: inputs)
+                    input.previous_output() = take();
+            }
+
+            const auto outputs = outputs_(random_);
+            for (size_t index = 0; index < outputs; ++index)
+            {
+                const auto size = script_sizes[scripts_(random_)];
+                data_chunk script(size, uint8_t(index));
+                if (size == 40)
+                    script[0] = 0x6a;
+
+                txs[tx].outputs().emplace_back(index + 546,
+                    chain::script(script, false));
+            }
+        }
+
+        chain::block block;
+        block.set_transactions(txs);
+
+        for (const auto& tx: block.transactions())
+        {
+            const auto hash = tx.hash();
+            for (uint32_t index = 0; index < tx.outputs().size(); ++index)
+                if (tx.outputs()[index].script().to_data(false)[0] != 0x6a)
+                    unspent_.emplace_back(hash, index);
+        }
+
+        ++height_;
+        return block;
+    }
+
+    // Unspent outputs as a block of count inputs would spend them,
+    // left unspent.
+    chain::point::list sample(size_t count)
+    {
+        chain::point::list points;
+        for (size_t input = 0; input < count; ++input)
+            points.push_back(unspent_[pick()]);
+
+        return points;
+    }
+
+    uint32_t height() const
+    {
+        return height_;
+    }
+
+private:
+    // An unspent output, recent or from anywhere in the set.
+    size_t pick()
+    {
+        std::uniform_real_distribution<double> recent(0, 1);
+        const auto span = recent(random_) < recent_spends ?
+            std::min(recent_outputs, unspent_.size()) : unspent_.size();
+
+        std::uniform_int_distribution<size_t> position(0, span - 1);
+        return unspent_.size() - 1 - position(random_);
+    }
+
+    chain::point take()
+    {
+        const auto position = pick();
+        const auto point = unspent_[position];
+        unspent_[position] = unspent_.back();
+        unspent_.pop_back();
+        return point;
+    }
+
+    std::mt19937_64 random_;
+    std::uniform_int_distribution<size_t> inputs_;
+    std::uniform_int_distribution<size_t> outputs_;
+    std::discrete_distribution<size_t> scripts_;
+    chain::point::list unspent_;
+    uint32_t height_ = 0;
+};
+
+// A set of set_size outputs, with the source of blocks spending them.
+struct utxo_set
+{
+    utxo_set()
+      : instance(set_size / 5000, 1, set_size / 5000, 1)
+    {
+        instance.reserve(set_size);
+        while (instance.size() < set_size)
+        {
+            auto context = manager.begin_transaction();
+            instance.store(context, source.next(false), source.height());
+            context.commit();
+        }
+    }
+
+    transaction_manager manager;
+    utxo_database instance;
+    block_source source;
+};
+
+utxo_set& shared_set()
+{
+    static utxo_set instance;
+    return instance;
+}
+
+chain::point::list previous_outputs(const chain::block& block)
+{
+    chain::point::list points;
+    const auto& txs = block.transactions();
+    for (size_t tx = 1; tx < txs.size(); ++tx)
+        for (const auto& input: txs[tx].inputs())
+            points.push_back(input.previous_output());
+
+    return points;
+}
+
+void multi_get(bench::state& state, size_t width)
+{
+    auto& set = shared_set();
+
+    // Not spent, so every iteration reads the same outputs.
+    const auto points = set.source.sample(block_inputs);
+    auto context = set.manager.begin_transaction();
+
+    std::vector<utxo_tuple_ptr> out;
+    state.measure([&]()
+    {
+        bench::do_not_optimize(set.instance.multi_get(context, points, out,
+            width));
+    });
+
+    state.report("inputs", points.size());
+}
+
+} // namespace
+
+// Fetch the previous outputs of a block's inputs one at a time, as
+// a validator looks them up.
+BENCHMARK(utxo_database__multi_get__block_inputs_sequential)
+{
+    multi_get(state, 1);
+}
+
+BENCHMARK(utxo_database__multi_get__block_inputs_interleaved)
+{
+    multi_get(state, 16);
+}
+
+// Connect a block per iteration, storing its outputs and spending its
+// inputs in one transaction.
+BENCHMARK(utxo_database__connect__block)
+{
+    auto& set = shared_set();
+
+    std::vector<chain::block> blocks;
+    size_t inputs = 0;
+    for (size_t iteration = 0; iteration < state.iterations(); ++iteration)
+    {
+        blocks.push_back(set.source.next(true));
+        inputs += previous_outputs(blocks.back()).size();
+    }
+
+    auto height = set.source.height() - state.iterations();
+    auto block = blocks.begin();
+    size_t failed = 0;
+    state.measure([&]()
+    {
+        auto context = set.manager.begin_transaction();
+        if (!set.instance.store(context, *block, ++height) ||
+            !set.instance.spend(context, *block++))
+            ++failed;
+        else
+            context.commit();
+    });
+
+    state.report("inputs", double(inputs) / state.iterations());
+    state.report("failed", failed);
+    state.report("index bytes per output",
+        double(set.instance.index_bytes()) / set.instance.size());
+}
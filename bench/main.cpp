@@ -0,0 +1,56 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "bench.hpp"
+
+using namespace libbitcoin::database::bench;
+
+// Usage: libbitcoin-mvcc-database-bench [filter [iterations]]
+// Runs every benchmark whose name contains filter.
+int main(int argc, char* argv[])
+{
+    const std::string filter = argc > 1 ? argv[1] : "";
+    const size_t iterations = argc > 2 ? std::strtoull(argv[2], nullptr, 10) :
+        100000;
+
+    for (const auto& entry: benchmarks())
+    {
+        if (entry.first.find(filter) == std::string::npos)
+            continue;
+
+        state measured(iterations);
+        entry.second(measured);
+
+        const auto nanoseconds = double(measured.elapsed().count()) /
+            measured.iterations();
+        std::cout << std::left << std::setw(56) << entry.first
+            << std::right << std::setw(12) << std::fixed
+            << std::setprecision(1) << nanoseconds << " ns/op" << std::endl;
+
+        for (const auto& counter: measured.counters())
+            std::cout << "    " << std::left << std::setw(52) << counter.first
+                << std::right << std::setw(12) << counter.second << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,138 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_MVCC_ART_INDEX_HPP
+#define LIBBITCOIN_MVCC_ART_INDEX_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include <bitcoin/system.hpp>
+#include <bitcoin/database/container/epoch_reclaimer.hpp>
+#include <bitcoin/database/define.hpp>
+#include <bitcoin/database/storage/slot.hpp>
+
+namespace libbitcoin {
+namespace database {
+namespace container {
+
+using namespace storage;
+
+/**
+ * An art_index maps hash digests to slots in an adaptive radix tree,
+ * an alternative to fingerprint_index that never rehashes.
+ *
+ * Inner nodes grow from 4 to 16, 48 and 256 children as needed, one
+ * node at a time, so the index has no resize pause and its memory
+ * follows the number of keys. Leaves are the slots themselves: a key
+ * is placed at the first byte that tells it apart from the others, and
+ * the loader reads the full hash from the record to confirm a match.
+ * Runs of bytes shared by every key below a node are compressed into
+ * the node's prefix, of which the first 8 bytes are kept and the rest
+ * read back through the loader.
+ *
+ * Synchronization is optimistic lock coupling. Every node has a
+ * version, readers take no locks and restart if a node they read
+ * changed. Writers lock only the one or two nodes they change. Nodes
+ * replaced by a writer are freed by an epoch_reclaimer.
+ */
+class BCD_API art_index
+{
+public:
+    /// loader(slot) is the hash of the record at slot.
+    typedef std::function<const system::hash_digest&(const slot&)> loader;
+
+    art_index(loader load);
+    ~art_index();
+
+    art_index(const art_index&) = delete;
+    art_index& operator=(const art_index&) = delete;
+
+    /**
+     * @param hash the hash to look up
+     * @param out set to the slot of hash, if there is one
+     * @return true if hash is indexed
+     */
+    bool find(const system::hash_digest& hash, slot& out) const;
+
+    /**
+     * Index hash at value, unless hash is already indexed. The record
+     * at value must be readable by the loader before the insert.
+     * @return true if hash was indexed
+     */
+    bool insert(const system::hash_digest& hash, const slot& value);
+
+    /**
+     * Remove hash, if it is indexed at value.
+     * @return true if hash was removed
+     */
+    bool erase(const system::hash_digest& hash, const slot& value);
+
+    /// Hint that hash will be looked up soon, loading the node below
+    /// the root on its path.
+    void prefetch(const system::hash_digest& hash) const;
+
+    /// The tree grows a node at a time, there is nothing to reserve.
+    void reserve(size_t count);
+
+    /// Unbounded, the tree never rehashes.
+    size_t capacity() const;
+
+    size_t size() const;
+
+    /// The number of inner nodes, for memory accounting.
+    size_t nodes() const;
+
+private:
+    struct node;
+
+    static void release(void* pointer);
+    static void destroy(uintptr_t child);
+
+    // Each returns false if the operation must restart.
+    bool try_find(const system::hash_digest& hash, slot& out,
+        bool& found) const;
+    bool try_insert(const system::hash_digest& hash, uintptr_t leaf,
+        bool& inserted);
+    bool try_erase(const system::hash_digest& hash, uintptr_t leaf,
+        bool& erased);
+    bool add_and_unlock(node* target, uint64_t version, node* parent,
+        uint64_t parent_version, uint8_t parent_key, uint8_t key,
+        uintptr_t child);
+    bool remove_and_unlock(node* target, uint64_t version, node* parent,
+        uint64_t parent_version, uint8_t parent_key, uint8_t key);
+    bool check_prefix(const node* target, const system::hash_digest& hash,
+        size_t& depth, bool& matched, uint8_t& mismatch,
+        uint64_t& remaining) const;
+    bool any_key(const node* target, const system::hash_digest*& out) const;
+    void retire(node* target);
+
+    const loader load_;
+    node* const root_;
+    mutable epoch_reclaimer reclaimer_;
+    std::atomic<size_t> size_;
+    std::atomic<size_t> nodes_;
+};
+
+} // namespace container
+} // namespace database
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,411 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_MVCC_CUCKOO_FILTER_HPP
+#define LIBBITCOIN_MVCC_CUCKOO_FILTER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <bitcoin/database/storage/util.hpp>
+
+namespace libbitcoin {
+namespace database {
+namespace container {
+
+using namespace storage;
+
+/**
+ * A cuckoo_filter answers whether a 64 bit hash may have been
+ * inserted, with a small rate of false positives and no false
+ * negatives. Unlike a bloom filter, it supports erase.
+ *
+ * The filter is an array of 64 byte blocks. A hash picks one block, and
+ * both of its buckets are inside that block, so a lookup reads one
+ * cache line. A block holds a version word and 7 buckets, and each
+ * bucket holds four 16 bit fingerprints. Readers take no locks and
+ * retry if a version changed while they read. Writers lock the pair of
+ * blocks they may change.
+ *
+ * A full block spills into the other block of its pair, and lookups of
+ * its hashes read both from then on. If the pair is full too, both are
+ * marked saturated and answer maybe for every hash, so a filter that is
+ * too small gets less useful but stays correct. A filter with no blocks
+ * is disabled.
+ */
+class cuckoo_filter
+{
+public:
+    static const size_t buckets_per_block = 7;
+    static const size_t slots_per_bucket = 4;
+
+    // Sized for blocks about 80% full.
+    static const size_t hashes_per_block =
+        buckets_per_block * slots_per_bucket * 4 / 5;
+
+    cuckoo_filter()
+      : mask_(0)
+    {
+    }
+
+    cuckoo_filter(const cuckoo_filter&) = delete;
+    cuckoo_filter& operator=(const cuckoo_filter&) = delete;
+
+    /// Size for count hashes, dropping all hashes. Not safe to call
+    /// alongside other operations. Zero disables the filter.
+    void resize(size_t count)
+    {
+        if (count == 0)
+        {
+            blocks_.reset();
+            mask_ = 0;
+            return;
+        }
+
+        // At least a pair, so that a block can spill.
+        size_t blocks = 2;
+        while (blocks * hashes_per_block < count)
+            blocks <<= 1;
+
+        blocks_.reset(new block[blocks]);
+        mask_ = blocks - 1;
+    }
+
+    bool enabled() const
+    {
+        return blocks_ != nullptr;
+    }
+
+    /// The number of 64 byte blocks.
+    size_t blocks() const
+    {
+        return enabled() ? mask_ + 1 : 0;
+    }
+
+    /// @return false only if hash is not in the filter
+    bool contains(uint64_t hash) const
+    {
+        if (!enabled())
+            return true;
+
+        const auto mixed = mix(hash);
+        const auto& home = blocks_[mixed & mask_];
+        const auto& pair = blocks_[(mixed & mask_) ^ 1];
+        const auto print = fingerprint(mixed);
+        const auto first = first_bucket(mixed);
+        const auto second = other_bucket(first, print);
+
+        while (true)
+        {
+            const auto version = home.version.load(std::memory_order_acquire);
+            if ((version & saturated) != 0)
+                return true;
+
+            if ((version & locked) != 0)
+                continue;
+
+            auto found = has(home, first, print) || has(home, second, print);
+            if (!found && (version & spilled) != 0)
+            {
+                const auto paired = pair.version.load(
+                    std::memory_order_acquire);
+                if ((paired & locked) != 0)
+                    continue;
+
+                found = has(pair, first, print) || has(pair, second, print);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (pair.version.load(std::memory_order_relaxed) != paired)
+                    continue;
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (home.version.load(std::memory_order_relaxed) == version)
+                return found;
+        }
+    }
+
+    /// Hint that hash will be looked up soon.
+    void prefetch(uint64_t hash) const
+    {
+        if (enabled())
+            util::prefetch(&blocks_[mix(hash) & mask_]);
+    }
+
+    void insert(uint64_t hash)
+    {
+        const auto mixed = mix(hash);
+        auto& home = blocks_[mixed & mask_];
+        auto& pair = blocks_[(mixed & mask_) ^ 1];
+        auto print = fingerprint(mixed);
+        auto bucket = first_bucket(mixed);
+
+        lock(home, pair);
+        if ((home.version.load(std::memory_order_relaxed) & saturated) != 0)
+        {
+            unlock(home, pair, 0);
+            return;
+        }
+
+        if (place(home, bucket, print))
+        {
+            unlock(home, pair, 0);
+            return;
+        }
+
+        // print is now whichever fingerprint was kicked out last, any
+        // fingerprint of home may live in pair once home has spilled.
+        if (place(pair, bucket, print))
+        {
+            home.version.fetch_or(spilled, std::memory_order_relaxed);
+            unlock(home, pair, 0);
+            return;
+        }
+
+        // print has no place left, it could belong to either block.
+        unlock(home, pair, saturated);
+    }
+
+    /// Remove one insert of hash. The hash must have been inserted.
+    void erase(uint64_t hash)
+    {
+        const auto mixed = mix(hash);
+        auto& home = blocks_[mixed & mask_];
+        auto& pair = blocks_[(mixed & mask_) ^ 1];
+        const auto print = fingerprint(mixed);
+        const auto first = first_bucket(mixed);
+        const auto second = other_bucket(first, print);
+
+        lock(home, pair);
+        if (!remove(home, first, print) && !remove(home, second, print) &&
+            (home.version.load(std::memory_order_relaxed) & spilled) != 0 &&
+            !remove(pair, first, print))
+            remove(pair, second, print);
+
+        unlock(home, pair, 0);
+    }
+
+    /// The number of blocks that spilled into their pair.
+    size_t spilled_blocks() const
+    {
+        return count_blocks(spilled);
+    }
+
+    /// The number of blocks that answer maybe for every hash.
+    size_t saturated_blocks() const
+    {
+        return count_blocks(saturated);
+    }
+
+private:
+    typedef uint16_t print_type;
+
+    // Version bits, the rest counts writes.
+    static const uint64_t locked = 1;
+    static const uint64_t spilled = 2;
+    static const uint64_t saturated = 4;
+    static const uint64_t increment = 8;
+
+    static const size_t max_kicks = 32;
+    static const uint64_t lanes = 0x0001000100010001ull;
+
+    struct alignas(64) block
+    {
+        block()
+          : version(0)
+        {
+            for (auto& bucket: buckets)
+                bucket.store(0, std::memory_order_relaxed);
+        }
+
+        std::atomic<uint64_t> version;
+        std::atomic<uint64_t> buckets[buckets_per_block];
+    };
+
+    static_assert(sizeof(block) == 64, "A block is one cache line.");
+
+    // Block, bucket and fingerprint take apart bits of the mixed hash,
+    // so the index keys they come from need not be uniform.
+    static uint64_t mix(uint64_t hash)
+    {
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdull;
+        hash ^= hash >> 33;
+        hash *= 0xc4ceb9fe1a85ec53ull;
+        return hash ^ (hash >> 33);
+    }
+
+    // Zero marks an empty slot.
+    static print_type fingerprint(uint64_t mixed)
+    {
+        const auto print = print_type(mixed >> 48);
+        return print == 0 ? 1 : print;
+    }
+
+    static size_t first_bucket(uint64_t mixed)
+    {
+        return size_t(((mixed >> 32) & 0xffff) * buckets_per_block >> 16);
+    }
+
+    // Its own inverse, so either bucket gives the other.
+    static size_t other_bucket(size_t bucket, print_type print)
+    {
+        return (print % buckets_per_block + buckets_per_block - bucket) %
+            buckets_per_block;
+    }
+
+    static print_type lane(uint64_t bucket, size_t slot)
+    {
+        return print_type(bucket >> (16 * slot));
+    }
+
+    // Whether any 16 bit lane of the bucket equals print.
+    static bool has(const block& target, size_t bucket, print_type print)
+    {
+        const auto match = target.buckets[bucket].load(
+            std::memory_order_relaxed) ^ (lanes * print);
+        return ((match - lanes) & ~match & (lanes << 15)) != 0;
+    }
+
+    // Caller holds the block lock.
+    static bool add(block& target, size_t bucket, print_type print)
+    {
+        const auto value = target.buckets[bucket].load(
+            std::memory_order_relaxed);
+        for (size_t slot = 0; slot < slots_per_bucket; ++slot)
+        {
+            if (lane(value, slot) != 0)
+                continue;
+
+            target.buckets[bucket].store(value |
+                (uint64_t(print) << (16 * slot)), std::memory_order_relaxed);
+            return true;
+        }
+
+        return false;
+    }
+
+    static bool remove(block& target, size_t bucket, print_type print)
+    {
+        const auto value = target.buckets[bucket].load(
+            std::memory_order_relaxed);
+        for (size_t slot = 0; slot < slots_per_bucket; ++slot)
+        {
+            if (lane(value, slot) != print)
+                continue;
+
+            target.buckets[bucket].store(value &
+                ~(uint64_t(0xffff) << (16 * slot)),
+                std::memory_order_relaxed);
+            return true;
+        }
+
+        return false;
+    }
+
+    // Put print in slot, returning the fingerprint it replaced.
+    static print_type swap(block& target, size_t bucket, size_t slot,
+        print_type print)
+    {
+        const auto value = target.buckets[bucket].load(
+            std::memory_order_relaxed);
+        const auto shift = 16 * slot;
+        target.buckets[bucket].store((value & ~(uint64_t(0xffff) << shift)) |
+            (uint64_t(print) << shift), std::memory_order_relaxed);
+        return lane(value, slot);
+    }
+
+    // Add print to either of its buckets, moving fingerprints to their
+    // other bucket to make room. On failure bucket and print are left
+    // as the fingerprint kicked out last and one of its buckets.
+    static bool place(block& target, size_t& bucket, print_type& print)
+    {
+        if (add(target, bucket, print))
+            return true;
+
+        bucket = other_bucket(bucket, print);
+        if (add(target, bucket, print))
+            return true;
+
+        for (size_t kick = 0; kick < max_kicks; ++kick)
+        {
+            print = swap(target, bucket, kick % slots_per_bucket, print);
+            bucket = other_bucket(bucket, print);
+            if (add(target, bucket, print))
+                return true;
+        }
+
+        return false;
+    }
+
+    size_t count_blocks(uint64_t flag) const
+    {
+        size_t count = 0;
+        for (size_t index = 0; index < blocks(); ++index)
+            if ((blocks_[index].version.load(std::memory_order_relaxed) &
+                flag) != 0)
+                ++count;
+
+        return count;
+    }
+
+    static void lock(block& target)
+    {
+        while (true)
+        {
+            auto version = target.version.load(std::memory_order_relaxed);
+            if ((version & locked) == 0 &&
+                target.version.compare_exchange_weak(version,
+                    version | locked, std::memory_order_acquire,
+                    std::memory_order_relaxed))
+                break;
+        }
+
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    static void unlock(block& target, uint64_t flags)
+    {
+        const auto version = target.version.load(std::memory_order_relaxed);
+        target.version.store(((version & ~locked) | flags) + increment,
+            std::memory_order_release);
+    }
+
+    // The lower addressed block first, so pairs lock in one order.
+    static void lock(block& home, block& pair)
+    {
+        lock(&home < &pair ? home : pair);
+        lock(&home < &pair ? pair : home);
+    }
+
+    static void unlock(block& home, block& pair, uint64_t flags)
+    {
+        unlock(home, flags);
+        unlock(pair, flags);
+    }
+
+    std::unique_ptr<block[]> blocks_;
+    size_t mask_;
+};
+
+} // namespace container
+} // namespace database
+} // namespace libbitcoin
+
+#endif
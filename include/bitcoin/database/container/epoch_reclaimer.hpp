@@ -0,0 +1,182 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_MVCC_EPOCH_RECLAIMER_HPP
+#define LIBBITCOIN_MVCC_EPOCH_RECLAIMER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <bitcoin/database/transaction_management/spinlatch.hpp>
+
+namespace libbitcoin {
+namespace database {
+namespace container {
+
+/**
+ * An epoch_reclaimer defers freeing memory unlinked from a latch free
+ * structure until no reader can still hold a pointer to it.
+ *
+ * Readers count themselves in the parity of the current epoch for the
+ * duration of an operation. The epoch only advances once no reader of
+ * the previous epoch is left, so memory retired two epochs back is
+ * unreachable. Reader counts are striped by thread so readers do not
+ * share a cache line.
+ */
+class epoch_reclaimer
+{
+public:
+    typedef void (*deleter)(void*);
+    static const size_t stripes = 16;
+
+    /// Counts the calling thread as a reader while in scope.
+    class guard
+    {
+    public:
+        guard(epoch_reclaimer& reclaimer)
+          : reclaimer_(reclaimer), epoch_(reclaimer.enter())
+        {
+        }
+
+        ~guard()
+        {
+            reclaimer_.exit(epoch_);
+        }
+
+        guard(const guard&) = delete;
+        guard& operator=(const guard&) = delete;
+
+    private:
+        epoch_reclaimer& reclaimer_;
+        const uint64_t epoch_;
+    };
+
+    epoch_reclaimer()
+      : latch_(std::make_shared<spinlatch>()), epoch_(2)
+    {
+    }
+
+    ~epoch_reclaimer()
+    {
+        for (const auto& entry: retired_)
+            entry.free(entry.pointer);
+    }
+
+    epoch_reclaimer(const epoch_reclaimer&) = delete;
+    epoch_reclaimer& operator=(const epoch_reclaimer&) = delete;
+
+    uint64_t enter()
+    {
+        auto& readers = counters_[stripe()].readers;
+        while (true)
+        {
+            const auto epoch = epoch_.load();
+            readers[epoch & 1].fetch_add(1);
+
+            // Counted under an epoch that has since moved on, the
+            // reclaimer may not have seen the count, so count again.
+            if (epoch_.load() == epoch)
+                return epoch;
+
+            readers[epoch & 1].fetch_sub(1);
+        }
+    }
+
+    void exit(uint64_t epoch)
+    {
+        counters_[stripe()].readers[epoch & 1].fetch_sub(1,
+            std::memory_order_release);
+    }
+
+    /// Free pointer with free once no reader can reach it. The caller
+    /// has already unlinked pointer.
+    void retire(void* pointer, deleter free)
+    {
+        scopedspinlatch guard(latch_);
+        retired_.push_back({ epoch_.load(), pointer, free });
+        reclaim();
+    }
+
+    /// The number of retired pointers not yet freed.
+    size_t pending() const
+    {
+        scopedspinlatch guard(latch_);
+        return retired_.size();
+    }
+
+private:
+    struct retired
+    {
+        uint64_t epoch;
+        void* pointer;
+        deleter free;
+    };
+
+    struct alignas(64) counter
+    {
+        std::atomic<size_t> readers[2] = {};
+    };
+
+    static size_t stripe()
+    {
+        static std::atomic<size_t> next(0);
+        static thread_local const size_t assigned =
+            next.fetch_add(1, std::memory_order_relaxed) % stripes;
+        return assigned;
+    }
+
+    // Caller holds the latch. Advance while no reader of the previous
+    // epoch is left, freeing what was retired before it.
+    void reclaim()
+    {
+        for (auto advanced = 0; advanced < 2; ++advanced)
+        {
+            const auto epoch = epoch_.load();
+            for (const auto& stripe: counters_)
+                if (stripe.readers[(epoch - 1) & 1].load() != 0)
+                    return;
+
+            epoch_.store(epoch + 1);
+
+            auto kept = retired_.begin();
+            for (const auto& entry: retired_)
+            {
+                if (entry.epoch < epoch)
+                    entry.free(entry.pointer);
+                else
+                    *kept++ = entry;
+            }
+
+            retired_.erase(kept, retired_.end());
+        }
+    }
+
+    const std::shared_ptr<spinlatch> latch_;
+    std::atomic<uint64_t> epoch_;
+    counter counters_[stripes];
+    std::vector<retired> retired_;
+};
+
+} // namespace container
+} // namespace database
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,239 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_MVCC_FILTERED_INDEX_HPP
+#define LIBBITCOIN_MVCC_FILTERED_INDEX_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include <bitcoin/system.hpp>
+#include <bitcoin/database/container/cuckoo_filter.hpp>
+#include <bitcoin/database/container/hash_digest_hasher.hpp>
+#include <bitcoin/database/storage/slot.hpp>
+
+namespace libbitcoin {
+namespace database {
+namespace container {
+
+using namespace storage;
+
+/**
+ * A filtered_index puts a cuckoo_filter in front of an index keyed on
+ * hash digests, so that most lookups of a missing hash end after one
+ * cache line read instead of a probe of the index.
+ *
+ * The filter is off until enabled on an empty index. It pays off when
+ * most lookups miss, a lookup that hits reads the filter line as well
+ * as the index. Index is fingerprint_index or art_index, or any index
+ * with find, insert and erase on hashes.
+ */
+template <typename Index>
+class filtered_index
+{
+public:
+    typedef typename Index::loader loader;
+
+    /// How lookups went, summed over threads.
+    struct counters
+    {
+        /// Lookups while the filter was on.
+        size_t lookups;
+
+        /// Lookups the filter answered without the index.
+        size_t rejected;
+
+        /// Lookups the filter passed that the index then missed.
+        size_t false_positives;
+    };
+
+    template <typename... Args>
+    filtered_index(Args&&... args)
+      : index_(std::forward<Args>(args)...)
+    {
+    }
+
+    /// The filter reads word 1, the index already keys on word 0.
+    static uint64_t to_filter_hash(const system::hash_digest& hash)
+    {
+        return digest_word(hash, 1);
+    }
+
+    bool find(const system::hash_digest& hash, slot& out) const
+    {
+        if (!filter_.enabled())
+            return index_.find(hash, out);
+
+        auto& stripe = counters_[stripe_index()];
+        stripe.lookups.fetch_add(1, std::memory_order_relaxed);
+
+        if (!filter_.contains(to_filter_hash(hash)))
+        {
+            stripe.rejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        if (index_.find(hash, out))
+            return true;
+
+        stripe.false_positives.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    /// The slot find would verify hash against, if Index can tell
+    /// without reading the record.
+    bool candidate(const system::hash_digest& hash, slot& out) const
+    {
+        if constexpr (has_candidate<Index>::value)
+            return filter_.contains(to_filter_hash(hash)) &&
+                index_.candidate(hash, out);
+        else
+            return false;
+    }
+
+    /// Hint that hash will be looked up soon, loading its filter block
+    /// and the start of its path in the index.
+    void prefetch(const system::hash_digest& hash) const
+    {
+        filter_.prefetch(to_filter_hash(hash));
+        index_.prefetch(hash);
+    }
+
+    /// The filter is updated after the index, so a hash may be
+    /// rejected until its insert returns.
+    bool insert(const system::hash_digest& hash, const slot& value)
+    {
+        if (!index_.insert(hash, value))
+            return false;
+
+        if (filter_.enabled())
+            filter_.insert(to_filter_hash(hash));
+
+        return true;
+    }
+
+    bool erase(const system::hash_digest& hash, const slot& value)
+    {
+        if (!index_.erase(hash, value))
+            return false;
+
+        if (filter_.enabled())
+            filter_.erase(to_filter_hash(hash));
+
+        return true;
+    }
+
+    /// Turn the filter on, sized for count hashes. The filter cannot be
+    /// rebuilt from the index, so this fails unless the index is empty.
+    /// Not safe to call alongside other operations.
+    bool enable_filter(size_t count)
+    {
+        if (index_.size() != 0)
+            return false;
+
+        filter_.resize(count);
+        return true;
+    }
+
+    /// Size the index for count hashes, it only grows.
+    void reserve(size_t count)
+    {
+        if (index_.capacity() < count)
+            index_.reserve(count);
+    }
+
+    size_t capacity() const
+    {
+        return index_.capacity();
+    }
+
+    size_t size() const
+    {
+        return index_.size();
+    }
+
+    const Index& index() const
+    {
+        return index_;
+    }
+
+    const cuckoo_filter& filter() const
+    {
+        return filter_;
+    }
+
+    counters lookup_counters() const
+    {
+        counters sum{ 0, 0, 0 };
+        for (const auto& stripe: counters_)
+        {
+            sum.lookups += stripe.lookups.load(std::memory_order_relaxed);
+            sum.rejected += stripe.rejected.load(std::memory_order_relaxed);
+            sum.false_positives += stripe.false_positives.load(
+                std::memory_order_relaxed);
+        }
+
+        return sum;
+    }
+
+private:
+    template <typename Target, typename = void>
+    struct has_candidate
+      : std::false_type
+    {
+    };
+
+    template <typename Target>
+    struct has_candidate<Target, std::void_t<decltype(std::declval<
+        const Target&>().candidate(std::declval<const system::hash_digest&>(),
+            std::declval<slot&>()))>>
+      : std::true_type
+    {
+    };
+
+    static const size_t stripes = 16;
+
+    // Counted by thread so that lookups do not share a cache line.
+    struct alignas(64) counter
+    {
+        std::atomic<size_t> lookups{ 0 };
+        std::atomic<size_t> rejected{ 0 };
+        std::atomic<size_t> false_positives{ 0 };
+    };
+
+    static size_t stripe_index()
+    {
+        static std::atomic<size_t> next(0);
+        static thread_local const size_t assigned =
+            next.fetch_add(1, std::memory_order_relaxed) % stripes;
+        return assigned;
+    }
+
+    Index index_;
+    cuckoo_filter filter_;
+    mutable counter counters_[stripes];
+};
+
+} // namespace container
+} // namespace database
+} // namespace libbitcoin
+
+#endif
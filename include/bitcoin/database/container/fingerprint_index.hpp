@@ -0,0 +1,199 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_MVCC_FINGERPRINT_INDEX_HPP
+#define LIBBITCOIN_MVCC_FINGERPRINT_INDEX_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include <bitcoin/system.hpp>
+#include <bitcoin/database/container/hash_digest_hasher.hpp>
+#include <bitcoin/database/storage/slot.hpp>
+#include <libcuckoo/cuckoohash_map.hh>
+
+namespace libbitcoin {
+namespace database {
+namespace container {
+
+using namespace storage;
+
+/**
+ * A fingerprint_index maps hash digests to slots, keeping only an 8
+ * byte fingerprint of each hash next to its slot.
+ *
+ * The full hash already lives in the record at the slot, so a
+ * fingerprint match is confirmed by the verifier against the record.
+ * A hash whose fingerprint is taken by a different hash is kept in
+ * full in a small overflow map, which is only searched when it is not
+ * empty.
+ *
+ * An entry is 16 bytes against 40 for a full hash key.
+ */
+class fingerprint_index
+{
+public:
+    typedef uint64_t fingerprint;
+
+    /// verifier(slot, hash) is true if the record at slot has hash.
+    typedef std::function<bool(const slot&, const system::hash_digest&)>
+        verifier;
+
+    /// loader(slot) is the hash of the record at slot.
+    typedef std::function<const system::hash_digest&(const slot&)> loader;
+
+    fingerprint_index(verifier verify)
+      : verify_(verify), overflow_size_(0)
+    {
+    }
+
+    /// Verifies against the hash read by load, as art_index does.
+    fingerprint_index(loader load)
+      : fingerprint_index([load](const slot& at, const system::hash_digest& hash)
+        {
+            return load(at) == hash;
+        })
+    {
+    }
+
+    /// The first 8 bytes of the hash, the low order bytes of a block
+    /// hash are the ones not constrained by proof of work.
+    static fingerprint to_fingerprint(const system::hash_digest& hash)
+    {
+        return digest_word(hash, 0);
+    }
+
+    /**
+     * @param hash the hash to look up
+     * @param out set to the slot of hash, if there is one
+     * @return true if hash is indexed
+     */
+    bool find(const system::hash_digest& hash, slot& out) const
+    {
+        if (fingerprints_.find(to_fingerprint(hash), out) &&
+            verify_(out, hash))
+            return true;
+
+        return overflow_size_.load(std::memory_order_acquire) != 0 &&
+            overflow_.find(hash, out);
+    }
+
+    /// The slot find would verify hash against, which may hold a
+    /// different hash. Lets a caller prefetch the record before find.
+    bool candidate(const system::hash_digest& hash, slot& out) const
+    {
+        return fingerprints_.find(to_fingerprint(hash), out);
+    }
+
+    /// Hint that hash will be looked up soon, loading the buckets its
+    /// fingerprint may be in.
+    void prefetch(const system::hash_digest& hash) const
+    {
+        fingerprints_.prefetch(to_fingerprint(hash));
+    }
+
+    /**
+     * Index hash at value, unless hash is already indexed. The record
+     * at value must be readable by the verifier before the insert.
+     * @return true if hash was indexed
+     */
+    bool insert(const system::hash_digest& hash, const slot& value)
+    {
+        const auto key = to_fingerprint(hash);
+        if (fingerprints_.insert(key, value))
+            return true;
+
+        slot existing;
+        if (fingerprints_.find(key, existing) && verify_(existing, hash))
+            return false;
+
+        if (!overflow_.insert(hash, value))
+            return false;
+
+        overflow_size_.fetch_add(1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Remove hash, if it is indexed at value.
+     * @return true if hash was removed
+     */
+    bool erase(const system::hash_digest& hash, const slot& value)
+    {
+        auto erased = false;
+        fingerprints_.erase_fn(to_fingerprint(hash),
+            [&](slot& existing)
+            {
+                return erased = (existing == value && verify_(value, hash));
+            });
+
+        if (erased || overflow_size_.load(std::memory_order_acquire) == 0)
+            return erased;
+
+        overflow_.erase_fn(hash, [&](slot& existing)
+        {
+            return erased = (existing == value);
+        });
+
+        if (erased)
+            overflow_size_.fetch_sub(1, std::memory_order_release);
+
+        return erased;
+    }
+
+    /// Size for count hashes. Cuckoo inserts start to fail before
+    /// every slot is used, so this leaves a tenth of the slots free.
+    void reserve(size_t count)
+    {
+        fingerprints_.reserve(count + count / 9);
+    }
+
+    size_t capacity() const
+    {
+        return fingerprints_.capacity();
+    }
+
+    size_t size() const
+    {
+        return fingerprints_.size() +
+            overflow_size_.load(std::memory_order_acquire);
+    }
+
+    /// The number of hashes kept in full.
+    size_t overflow_size() const
+    {
+        return overflow_size_.load(std::memory_order_acquire);
+    }
+
+private:
+    const verifier verify_;
+    libcuckoo::cuckoohash_map<fingerprint, slot> fingerprints_;
+
+    // Overflow hashes share word 0 with a fingerprint, so hash word 1.
+    libcuckoo::cuckoohash_map<system::hash_digest, slot,
+        hash_digest_hasher<1>, hash_digest_equal> overflow_;
+    std::atomic<size_t> overflow_size_;
+};
+
+} // namespace container
+} // namespace database
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,94 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_MVCC_HASH_DIGEST_HASHER_HPP
+#define LIBBITCOIN_MVCC_HASH_DIGEST_HASHER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <bitcoin/system.hpp>
+
+namespace libbitcoin {
+namespace database {
+namespace container {
+
+/// The 64 bit word of hash at word, read with a single load.
+inline uint64_t digest_word(const system::hash_digest& hash, size_t word)
+{
+    uint64_t value;
+    std::memcpy(&value, hash.data() + word * sizeof(value), sizeof(value));
+    return value;
+}
+
+/**
+ * Hashes a digest to one of its 64 bit words.
+ *
+ * A digest is already uniformly distributed, so unlike the default
+ * hasher this does not read the other 24 bytes. Word 0 holds the low
+ * order bytes of a block hash, which proof of work leaves random. An
+ * index whose keys may share word 0, such as the fingerprint index
+ * overflow, hashes another word.
+ */
+template <size_t Word = 0>
+struct hash_digest_hasher
+{
+    static_assert(Word < sizeof(system::hash_digest) / sizeof(uint64_t),
+        "word out of range");
+
+    size_t operator()(const system::hash_digest& hash) const noexcept
+    {
+        return static_cast<size_t>(digest_word(hash, Word));
+    }
+};
+
+/// Compares digests a word at a time, from word 0 where distinct
+/// digests almost always differ.
+struct hash_digest_equal
+{
+    bool operator()(const system::hash_digest& left,
+        const system::hash_digest& right) const noexcept
+    {
+        return digest_word(left, 0) == digest_word(right, 0) &&
+            digest_word(left, 1) == digest_word(right, 1) &&
+            digest_word(left, 2) == digest_word(right, 2) &&
+            digest_word(left, 3) == digest_word(right, 3);
+    }
+};
+
+/**
+ * Hashes an outpoint to word 0 of its transaction hash, mixed with the
+ * output index. Outputs of one transaction share the hash, the index
+ * is multiplied out to the high bits so they do not share a bucket or
+ * a partial key.
+ */
+struct point_hasher
+{
+    size_t operator()(const system::chain::point& point) const noexcept
+    {
+        return static_cast<size_t>(digest_word(point.hash(), 0) ^
+            (point.index() * 0x9e3779b97f4a7c15ull));
+    }
+};
+
+} // namespace container
+} // namespace database
+} // namespace libbitcoin
+
+#endif
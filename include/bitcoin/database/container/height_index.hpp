@@ -0,0 +1,302 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_MVCC_HEIGHT_INDEX_HPP
+#define LIBBITCOIN_MVCC_HEIGHT_INDEX_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <memory>
+
+#include <bitcoin/database/storage/slot.hpp>
+#include <bitcoin/database/transaction_management/spinlatch.hpp>
+
+namespace libbitcoin {
+namespace database {
+namespace container {
+
+using namespace storage;
+
+/**
+ * A height_index maps the dense heights of a chain to the slots of
+ * their blocks.
+ *
+ * Entries live in fixed size chunks found through a fixed size
+ * directory, so the array grows without moving entries and readers
+ * never take a lock. Readers load the tip, then the chunk and the
+ * entry, all atomically.
+ *
+ * Writers serialize on a latch, the chain has a single writer in
+ * practice. Truncation only moves the tip back, entries above the tip
+ * are cleared when the tip next moves past them.
+ */
+class height_index
+{
+public:
+    // 16k heights per chunk, 16k chunks, 268M heights.
+    static const size_t chunk_bits = 14;
+    static const size_t chunk_size = size_t(1) << chunk_bits;
+    static const size_t directory_size = size_t(1) << 14;
+    static const size_t max_height = chunk_size * directory_size;
+
+    height_index()
+      : latch_(std::make_shared<spinlatch>()),
+        directory_(new std::atomic<std::atomic<slot>*>[directory_size]()),
+        written_(0), size_(0)
+    {
+    }
+
+    ~height_index()
+    {
+        for (size_t chunk = 0; chunk < directory_size; ++chunk)
+            delete[] directory_[chunk].load();
+    }
+
+    height_index(const height_index&) = delete;
+    height_index& operator=(const height_index&) = delete;
+
+    /**
+     * @param height the height to look up
+     * @param out set to the slot at height, if there is one
+     * @return true if a block is indexed at height
+     */
+    bool find(size_t height, slot& out) const
+    {
+        if (height >= size_.load(std::memory_order_acquire))
+            return false;
+
+        const auto chunk = directory_[height >> chunk_bits].load(
+            std::memory_order_acquire);
+        if (chunk == nullptr)
+            return false;
+
+        out = chunk[height & (chunk_size - 1)].load(std::memory_order_acquire);
+        return out;
+    }
+
+    /**
+     * Index a block at height, unless one is already indexed there.
+     * @return true if the block was indexed, false if one is already
+     * indexed or height is not below max_height
+     */
+    bool insert(size_t height, const slot& value)
+    {
+        if (height >= max_height)
+            return false;
+
+        scopedspinlatch guard(latch_);
+        slot existing;
+        if (find(height, existing))
+            return false;
+
+        store(height, value);
+        return true;
+    }
+
+    /**
+     * Index a block at height, replacing any block indexed there.
+     * @return false if height is not below max_height
+     */
+    bool insert_or_assign(size_t height, const slot& value)
+    {
+        if (height >= max_height)
+            return false;
+
+        scopedspinlatch guard(latch_);
+        store(height, value);
+        return true;
+    }
+
+    /**
+     * Remove the block at height. Removing the tip moves the tip back
+     * below height, past any heights already left empty.
+     * @return true if a block was indexed at height
+     */
+    bool erase(size_t height)
+    {
+        scopedspinlatch guard(latch_);
+        slot existing;
+        if (!find(height, existing))
+            return false;
+
+        auto size = size_.load(std::memory_order_relaxed);
+        if (height + 1 != size)
+        {
+            entry(height).store(slot{}, std::memory_order_release);
+            return true;
+        }
+
+        size = height;
+        while (size > 0 && !find(size - 1, existing))
+            --size;
+
+        size_.store(size, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Remove every block at height and above, in constant time.
+     */
+    void truncate(size_t height)
+    {
+        scopedspinlatch guard(latch_);
+        if (height < size_.load(std::memory_order_relaxed))
+            size_.store(height, std::memory_order_release);
+    }
+
+    /**
+     * Apply the changes of a writer in one hold of the latch. Heights
+     * from truncated up read as empty unless changed, an empty slot
+     * in changes erases its height. Entries are written before the tip
+     * moves to size, so a reader never sees the chain cut short part
+     * way through.
+     */
+    void apply(size_t truncated, const std::map<size_t, slot>& changes,
+        size_t size)
+    {
+        BITCOIN_ASSERT_MSG(size <= max_height, "Height index is full");
+
+        scopedspinlatch guard(latch_);
+
+        // Clear truncated heights, and stale entries above the tip,
+        // unless they are changed below.
+        const auto current = size_.load(std::memory_order_relaxed);
+        auto change = changes.begin();
+        for (auto height = std::min(truncated, current);
+            height < std::min(size, written_); ++height)
+        {
+            while (change != changes.end() && change->first < height)
+                ++change;
+
+            if (change == changes.end() || change->first != height)
+                entry(height).store(slot{}, std::memory_order_relaxed);
+        }
+
+        for (const auto& change: changes)
+        {
+            if (change.first >= size)
+                break;
+
+            entry(change.first).store(change.second,
+                std::memory_order_release);
+        }
+
+        written_ = std::max(written_, size);
+        size_.store(size, std::memory_order_release);
+    }
+
+    /**
+     * Allocate the chunks for heights below count up front, so that
+     * appends below count never allocate. Count is capped at
+     * max_height.
+     */
+    void reserve(size_t count)
+    {
+        if (count > max_height)
+            count = max_height;
+
+        scopedspinlatch guard(latch_);
+        for (size_t height = 0; height < count; height += chunk_size)
+            entry(height);
+    }
+
+    /**
+     * @return the heights with allocated chunks, from height zero
+     */
+    size_t capacity() const
+    {
+        size_t chunk = 0;
+        while (chunk < directory_size &&
+            directory_[chunk].load(std::memory_order_acquire) != nullptr)
+            ++chunk;
+
+        return chunk * chunk_size;
+    }
+
+    /**
+     * @param out set to the highest indexed height
+     * @return false if the index is empty
+     */
+    bool top(size_t& out) const
+    {
+        const auto size = size_.load(std::memory_order_acquire);
+        if (size == 0)
+            return false;
+
+        out = size - 1;
+        return true;
+    }
+
+    /**
+     * @return one past the highest indexed height
+     */
+    size_t size() const
+    {
+        return size_.load(std::memory_order_acquire);
+    }
+
+private:
+    // Caller holds the latch and checks height against max_height.
+    void store(size_t height, const slot& value)
+    {
+        BITCOIN_ASSERT_MSG(height < max_height, "Height index is full");
+
+        // Entries between the tip and height may be left by a
+        // truncate, clear them before they become readable.
+        const auto size = size_.load(std::memory_order_relaxed);
+        for (auto stale = size; stale < std::min(height, written_); ++stale)
+            entry(stale).store(slot{}, std::memory_order_relaxed);
+
+        entry(height).store(value, std::memory_order_release);
+        written_ = std::max(written_, height + 1);
+
+        if (height >= size)
+            size_.store(height + 1, std::memory_order_release);
+    }
+
+    // Caller holds the latch, allocates the chunk on first use.
+    std::atomic<slot>& entry(size_t height)
+    {
+        auto& chunk = directory_[height >> chunk_bits];
+        auto entries = chunk.load(std::memory_order_relaxed);
+        if (entries == nullptr)
+        {
+            entries = new std::atomic<slot>[chunk_size]();
+            chunk.store(entries, std::memory_order_release);
+        }
+
+        return entries[height & (chunk_size - 1)];
+    }
+
+    std::shared_ptr<spinlatch> latch_;
+    std::unique_ptr<std::atomic<std::atomic<slot>*>[]> directory_;
+
+    // One past the highest height ever stored, guarded by the latch.
+    size_t written_;
+
+    // The tip, one past the highest indexed height.
+    std::atomic<size_t> size_;
+};
+
+} // namespace container
+} // namespace database
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,504 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_MVCC_ORDERED_INDEX_HPP
+#define LIBBITCOIN_MVCC_ORDERED_INDEX_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <bitcoin/database/storage/slot.hpp>
+
+namespace libbitcoin {
+namespace database {
+namespace container {
+
+using namespace storage;
+
+/**
+ * An ordered_index maps ordered keys to slots, for range scans the
+ * hash indexes cannot do.
+ *
+ * It is a skip list with no locks. A node is linked into a level with
+ * one compare and swap on its predecessor, level 0 first. Readers and
+ * writers never block each other.
+ *
+ * Nodes are never unlinked. Erasing a key clears its slot and leaves
+ * the node in place, and inserting the key again reuses the node.
+ * Erased nodes are freed with the index, so the index suits keys that
+ * are rarely erased, such as timestamps, outpoints or script hashes.
+ */
+template <typename Key, typename Compare = std::less<Key>>
+class ordered_index
+{
+private:
+    struct node;
+
+public:
+    // Each level holds a quarter of the level below, 4^20 keys.
+    static const size_t max_level = 20;
+
+    typedef std::pair<Key, slot> value_type;
+    typedef std::vector<value_type> value_list;
+
+    /**
+     * A bidirectional iterator over the keys with slots, in order.
+     *
+     * Incrementing follows level 0. Decrementing searches for the
+     * previous key, in logarithmic time. A key erased after the
+     * iterator reaches it reads as an empty slot.
+     */
+    class const_iterator
+    {
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef typename ordered_index::value_type value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const value_type* pointer;
+        typedef value_type reference;
+
+        const_iterator()
+          : index_(nullptr), node_(nullptr)
+        {
+        }
+
+        const Key& key() const
+        {
+            return node_->key;
+        }
+
+        slot value() const
+        {
+            return node_->value.load(std::memory_order_acquire);
+        }
+
+        value_type operator*() const
+        {
+            return { key(), value() };
+        }
+
+        const_iterator& operator++()
+        {
+            node_ = index_->next_live(node_->next[0].load(
+                std::memory_order_acquire));
+            return *this;
+        }
+
+        const_iterator operator++(int)
+        {
+            auto copy = *this;
+            ++(*this);
+            return copy;
+        }
+
+        /// Decrementing end() moves to the last key.
+        const_iterator& operator--()
+        {
+            node_ = node_ == nullptr ? index_->last_live() :
+                index_->previous_live(node_->key);
+            return *this;
+        }
+
+        const_iterator operator--(int)
+        {
+            auto copy = *this;
+            --(*this);
+            return copy;
+        }
+
+        bool operator==(const const_iterator& other) const
+        {
+            return node_ == other.node_;
+        }
+
+        bool operator!=(const const_iterator& other) const
+        {
+            return node_ != other.node_;
+        }
+
+    private:
+        friend class ordered_index;
+
+        const_iterator(const ordered_index* index, node* at)
+          : index_(index), node_(at)
+        {
+        }
+
+        const ordered_index* index_;
+        node* node_;
+    };
+
+    ordered_index(const Compare& compare=Compare())
+      : less_(compare), head_(new std::atomic<node*>[max_level]()),
+        level_(1), size_(0)
+    {
+    }
+
+    ~ordered_index()
+    {
+        auto current = head_[0].load(std::memory_order_relaxed);
+        while (current != nullptr)
+        {
+            const auto next = current->next[0].load(std::memory_order_relaxed);
+            delete current;
+            current = next;
+        }
+    }
+
+    ordered_index(const ordered_index&) = delete;
+    ordered_index& operator=(const ordered_index&) = delete;
+
+    /**
+     * @param key the key to look up
+     * @param out set to the slot of key, if there is one
+     * @return true if key is indexed
+     */
+    bool find(const Key& key, slot& out) const
+    {
+        const auto found = lower_node(key);
+        if (found == nullptr || less_(key, found->key))
+            return false;
+
+        out = found->value.load(std::memory_order_acquire);
+        return out;
+    }
+
+    /**
+     * Index key at value, unless key is already indexed.
+     * @return true if key was indexed
+     */
+    bool insert(const Key& key, const slot& value)
+    {
+        return emplace(key, value, false);
+    }
+
+    /**
+     * Index key at value, replacing any slot indexed at key.
+     */
+    void insert_or_assign(const Key& key, const slot& value)
+    {
+        emplace(key, value, true);
+    }
+
+    /**
+     * Remove key, its node stays for a later insert of key.
+     * @return true if key was indexed
+     */
+    bool erase(const Key& key)
+    {
+        const auto found = lower_node(key);
+        if (found == nullptr || less_(key, found->key))
+            return false;
+
+        if (!found->value.exchange(slot{}, std::memory_order_acq_rel))
+            return false;
+
+        size_.fetch_sub(1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Load values, sorted by strictly ascending key, into an empty
+     * index. Towers are linked in one pass without searching. Readers
+     * may run alongside, writers may not.
+     * @return false if the index is not empty or values are not sorted
+     */
+    bool bulk_load(const value_list& values)
+    {
+        if (head_[0].load(std::memory_order_acquire) != nullptr)
+            return false;
+
+        for (size_t position = 1; position < values.size(); ++position)
+            if (!less_(values[position - 1].first, values[position].first))
+                return false;
+
+        std::vector<std::atomic<node*>*> tails(max_level, head_.get());
+        size_t level = 1;
+        size_t count = 0;
+        for (const auto& value: values)
+        {
+            const auto created = new node(value.first, random_height());
+            created->value.store(value.second, std::memory_order_relaxed);
+            count += value.second ? 1 : 0;
+
+            for (size_t link = 0; link < created->height; ++link)
+            {
+                tails[link][link].store(created, std::memory_order_release);
+                tails[link] = created->next.get();
+            }
+
+            level = std::max(level, created->height);
+        }
+
+        raise_level(level);
+        size_.fetch_add(count, std::memory_order_release);
+        return true;
+    }
+
+    /// The first key not less than key.
+    const_iterator lower_bound(const Key& key) const
+    {
+        return { this, next_live(lower_node(key)) };
+    }
+
+    /// The first key greater than key.
+    const_iterator upper_bound(const Key& key) const
+    {
+        auto found = lower_node(key);
+        if (found != nullptr && !less_(key, found->key))
+            found = found->next[0].load(std::memory_order_acquire);
+
+        return { this, next_live(found) };
+    }
+
+    const_iterator begin() const
+    {
+        return { this, next_live(head_[0].load(std::memory_order_acquire)) };
+    }
+
+    const_iterator end() const
+    {
+        return { this, nullptr };
+    }
+
+    /// The number of keys with slots.
+    size_t size() const
+    {
+        return size_.load(std::memory_order_acquire);
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+private:
+    struct node
+    {
+        node(const Key& key, size_t height)
+          : key(key), value(), height(height),
+            next(new std::atomic<node*>[height]())
+        {
+        }
+
+        const Key key;
+        std::atomic<slot> value;
+        const size_t height;
+        const std::unique_ptr<std::atomic<node*>[]> next;
+    };
+
+    // Each level with probability 1/4, from a per thread xorshift.
+    static size_t random_height()
+    {
+        static thread_local uint64_t state = 0x9e3779b97f4a7c15ull ^
+            reinterpret_cast<uintptr_t>(&state);
+
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+
+        size_t height = 1;
+        for (auto bits = state; height < max_level && (bits & 3) == 0;
+            bits >>= 2)
+            ++height;
+
+        return height;
+    }
+
+    void raise_level(size_t level)
+    {
+        auto current = level_.load(std::memory_order_relaxed);
+        while (current < level && !level_.compare_exchange_weak(current,
+            level, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    // Sets the links before and the nodes after key at every level,
+    // returns the first node not less than key. Links are the next
+    // array of a node, or the head.
+    node* search(const Key& key, std::atomic<node*>** previous,
+        node** following) const
+    {
+        const auto level = level_.load(std::memory_order_acquire);
+        auto links = head_.get();
+        for (auto link = max_level; link-- > level;)
+        {
+            previous[link] = links;
+            following[link] = links[link].load(std::memory_order_acquire);
+        }
+
+        for (auto link = level; link-- > 0;)
+        {
+            auto next = links[link].load(std::memory_order_acquire);
+            while (next != nullptr && less_(next->key, key))
+            {
+                links = next->next.get();
+                next = links[link].load(std::memory_order_acquire);
+            }
+
+            previous[link] = links;
+            following[link] = next;
+        }
+
+        return following[0];
+    }
+
+    // The first node not less than key, erased or not.
+    node* lower_node(const Key& key) const
+    {
+        std::atomic<node*>* previous[max_level];
+        node* following[max_level];
+        return search(key, previous, following);
+    }
+
+    node* next_live(node* current) const
+    {
+        while (current != nullptr &&
+            !current->value.load(std::memory_order_acquire))
+            current = current->next[0].load(std::memory_order_acquire);
+
+        return current;
+    }
+
+    // The last node with a slot before key, or null.
+    node* previous_live(const Key& key) const
+    {
+        auto bound = key;
+        while (true)
+        {
+            const auto found = last_before(&bound);
+            if (found == nullptr ||
+                found->value.load(std::memory_order_acquire))
+                return found;
+
+            bound = found->key;
+        }
+    }
+
+    node* last_live() const
+    {
+        const auto last = last_before(nullptr);
+        return last == nullptr || last->value.load(std::memory_order_acquire) ?
+            last : previous_live(last->key);
+    }
+
+    // The last node before key, or the last node if key is null.
+    node* last_before(const Key* key) const
+    {
+        node* last = nullptr;
+        auto links = head_.get();
+        for (auto link = level_.load(std::memory_order_acquire); link-- > 0;)
+        {
+            auto next = links[link].load(std::memory_order_acquire);
+            while (next != nullptr && (key == nullptr || less_(next->key, *key)))
+            {
+                last = next;
+                links = next->next.get();
+                next = links[link].load(std::memory_order_acquire);
+            }
+        }
+
+        return last;
+    }
+
+    bool emplace(const Key& key, const slot& value, bool assign)
+    {
+        BITCOIN_ASSERT_MSG(value, "Cannot index an empty slot.");
+
+        std::atomic<node*>* previous[max_level];
+        node* following[max_level];
+        std::unique_ptr<node> created;
+
+        while (true)
+        {
+            const auto found = search(key, previous, following);
+            if (found != nullptr && !less_(key, found->key))
+            {
+                // Revive an erased key, or assign over a live one.
+                slot empty;
+                if (!found->value.compare_exchange_strong(empty, value,
+                    std::memory_order_acq_rel))
+                {
+                    if (!assign)
+                        return false;
+
+                    if (found->value.exchange(value,
+                        std::memory_order_acq_rel))
+                        return true;
+                }
+
+                size_.fetch_add(1, std::memory_order_release);
+                return true;
+            }
+
+            if (!created)
+            {
+                created.reset(new node(key, random_height()));
+                created->value.store(value, std::memory_order_relaxed);
+            }
+
+            for (size_t link = 0; link < created->height; ++link)
+                created->next[link].store(following[link],
+                    std::memory_order_relaxed);
+
+            auto expected = following[0];
+            if (previous[0][0].compare_exchange_strong(expected, created.get(),
+                std::memory_order_release, std::memory_order_relaxed))
+                break;
+        }
+
+        const auto linked = created.release();
+        size_.fetch_add(1, std::memory_order_release);
+        raise_level(linked->height);
+
+        // Link the upper levels, searching again when a level changed.
+        for (size_t link = 1; link < linked->height; ++link)
+        {
+            while (true)
+            {
+                auto expected = following[link];
+                if (previous[link][link].compare_exchange_strong(expected,
+                    linked, std::memory_order_release,
+                    std::memory_order_relaxed))
+                    break;
+
+                search(key, previous, following);
+                linked->next[link].store(following[link],
+                    std::memory_order_relaxed);
+            }
+        }
+
+        return true;
+    }
+
+    const Compare less_;
+    const std::unique_ptr<std::atomic<node*>[]> head_;
+    std::atomic<size_t> level_;
+    std::atomic<size_t> size_;
+};
+
+} // namespace container
+} // namespace database
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,252 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBBITCOIN_MVCC_OUTPOINT_INDEX_HPP
+#define LIBBITCOIN_MVCC_OUTPOINT_INDEX_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+
+#include <bitcoin/system.hpp>
+#include <bitcoin/database/container/hash_digest_hasher.hpp>
+#include <bitcoin/database/storage/slot.hpp>
+#include <libcuckoo/cuckoohash_map.hh>
+
+namespace libbitcoin {
+namespace database {
+namespace container {
+
+using namespace storage;
+
+/**
+ * Hashes a compact outpoint key. The low bits of a key hold the output
+ * index and pick the bucket, so the txid bits above them are multiplied
+ * down over them. Outputs of one transaction land in unrelated buckets.
+ */
+struct compact_key_hasher
+{
+    size_t operator()(uint64_t key) const noexcept
+    {
+        const auto mixed = key * 0x9e3779b97f4a7c15ull;
+        return static_cast<size_t>(mixed ^ (mixed >> 32));
+    }
+};
+
+/**
+ * An outpoint_index maps outpoints to slots, keeping only an 8 byte
+ * compact key of each outpoint next to its slot.
+ *
+ * The key packs the output index as a varint-like prefix code in its
+ * low bits and fills the rest with the leading bits of the txid:
+ *
+ *   index < 2^7   ...txid (56 bits) | index (7) | 0
+ *   index < 2^14  ...txid (48 bits) | index (14) | 01
+ *   index < 2^29  ...txid (32 bits) | index (29) | 011
+ *
+ * Almost every output has an index below 128, so almost every key
+ * carries 56 bits of txid. The full outpoint lives with the record at
+ * the slot, so a key match is confirmed by the verifier against it. An
+ * outpoint whose key is taken by a different outpoint, or whose index
+ * does not fit, is kept in full in a small overflow map.
+ *
+ * Buckets hold seven 16 byte entries, which with their partial keys
+ * and occupancy flags fill 128 bytes, two cache lines. Tables are
+ * sized in powers of two buckets, seven slots put 200M outpoints in 2^25
+ * buckets at a load of 0.85, where four slots would need 2^26.
+ */
+class outpoint_index
+{
+public:
+    typedef uint64_t compact_key;
+
+    static const size_t slots_per_bucket = 7;
+
+    /// verifier(slot, point) is true if the record at slot has point.
+    typedef std::function<bool(const slot&, const system::chain::point&)>
+        verifier;
+
+    outpoint_index(verifier verify)
+      : verify_(verify), overflow_size_(0)
+    {
+    }
+
+    /// The compact key of point, false if its index does not fit.
+    static bool to_key(const system::chain::point& point, compact_key& out)
+    {
+        const auto txid = digest_word(point.hash(), 0);
+        const compact_key index = point.index();
+
+        if (index < (1u << 7))
+            out = (txid << 8) | (index << 1);
+        else if (index < (1u << 14))
+            out = (txid << 16) | (index << 2) | 0x1;
+        else if (index < (1u << 29))
+            out = (txid << 32) | (index << 3) | 0x3;
+        else
+            return false;
+
+        return true;
+    }
+
+    /**
+     * @param point the outpoint to look up
+     * @param out set to the slot of point, if there is one
+     * @return true if point is indexed
+     */
+    bool find(const system::chain::point& point, slot& out) const
+    {
+        compact_key key;
+        if (to_key(point, key) && keys_.find(key, out) && verify_(out, point))
+            return true;
+
+        return overflow_size_.load(std::memory_order_acquire) != 0 &&
+            overflow_.find(point, out);
+    }
+
+    /// Hint that point will be looked up soon, loading the buckets its
+    /// key may be in.
+    void prefetch(const system::chain::point& point) const
+    {
+        compact_key key;
+        if (to_key(point, key))
+            keys_.prefetch(key);
+    }
+
+    /**
+     * Index point at value, unless point is already indexed. The record
+     * at value must be readable by the verifier before the insert.
+     * @return true if point was indexed
+     */
+    bool insert(const system::chain::point& point, const slot& value)
+    {
+        compact_key key;
+        const auto compact = to_key(point, key);
+        if (compact)
+        {
+            if (keys_.insert(key, value))
+                return true;
+
+            slot existing;
+            if (keys_.find(key, existing) && verify_(existing, point))
+                return false;
+        }
+
+        if (!overflow_.insert(point, value))
+            return false;
+
+        overflow_size_.fetch_add(1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Remove point, if it is indexed at value.
+     * @return true if point was removed
+     */
+    bool erase(const system::chain::point& point, const slot& value)
+    {
+        auto erased = false;
+        compact_key key;
+        if (to_key(point, key))
+            keys_.erase_fn(key, [&](slot& existing)
+            {
+                return erased = (existing == value && verify_(value, point));
+            });
+
+        if (erased || overflow_size_.load(std::memory_order_acquire) == 0)
+            return erased;
+
+        overflow_.erase_fn(point, [&](slot& existing)
+        {
+            return erased = (existing == value);
+        });
+
+        if (erased)
+            overflow_size_.fetch_sub(1, std::memory_order_release);
+
+        return erased;
+    }
+
+    /// Size for count outpoints. Cuckoo inserts start to fail before
+    /// every slot is used, so this leaves a tenth of the slots free.
+    void reserve(size_t count)
+    {
+        keys_.reserve(count + count / 9);
+    }
+
+    /// The bytes of the key table once reserved for count outpoints.
+    static size_t reserved_bytes(size_t count)
+    {
+        const auto needed = (count + count / 9 + slots_per_bucket - 1) /
+            slots_per_bucket;
+
+        size_t buckets = 1;
+        while (buckets < needed)
+            buckets <<= 1;
+
+        return buckets * sizeof(bucket);
+    }
+
+    /// The bytes of the key table as it is now.
+    size_t bytes() const
+    {
+        return keys_.bucket_count() * sizeof(bucket);
+    }
+
+    size_t capacity() const
+    {
+        return keys_.capacity();
+    }
+
+    size_t size() const
+    {
+        return keys_.size() + overflow_size_.load(std::memory_order_acquire);
+    }
+
+    /// The number of outpoints kept in full.
+    size_t overflow_size() const
+    {
+        return overflow_size_.load(std::memory_order_acquire);
+    }
+
+private:
+    typedef std::allocator<std::pair<const compact_key, slot>> allocator;
+    typedef libcuckoo::cuckoohash_map<compact_key, slot, compact_key_hasher,
+        std::equal_to<compact_key>, allocator, slots_per_bucket> key_map;
+    typedef typename libcuckoo::bucket_container<compact_key, slot,
+        allocator, uint8_t, slots_per_bucket>::bucket bucket;
+
+    static_assert(sizeof(bucket) == 128, "bucket is not two cache lines");
+
+    const verifier verify_;
+    key_map keys_;
+
+    libcuckoo::cuckoohash_map<system::chain::point, slot, point_hasher>
+        overflow_;
+    std::atomic<size_t> overflow_size_;
+};
+
+} // namespace container
+} // namespace database
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,153 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_MVCC_PENDING_HEIGHTS_HPP
+#define LIBBITCOIN_MVCC_PENDING_HEIGHTS_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <map>
+
+#include <bitcoin/database/container/height_index.hpp>
+#include <bitcoin/database/storage/slot.hpp>
+
+namespace libbitcoin {
+namespace database {
+namespace container {
+
+using namespace storage;
+
+/**
+ * The uncommitted changes of the single writer of a height_index.
+ *
+ * The writer reads the index through its changes, every other reader
+ * reads the index alone and so sees only committed entries. The
+ * changes are applied to the index when the writer commits, and
+ * dropped when it aborts. Only the writer uses the changes, they are
+ * not thread safe.
+ */
+class pending_heights
+{
+public:
+    pending_heights()
+      : size_(0), truncated_(none)
+    {
+    }
+
+    /// Drop all changes, the writer starts from the committed index.
+    void reset(const height_index& base)
+    {
+        changes_.clear();
+        size_ = base.size();
+        truncated_ = none;
+    }
+
+    /// One past the highest height the writer sees indexed.
+    size_t size() const
+    {
+        return size_;
+    }
+
+    bool find(const height_index& base, size_t height, slot& out) const
+    {
+        if (height >= size_)
+            return false;
+
+        const auto change = changes_.find(height);
+        if (change != changes_.end())
+        {
+            out = change->second;
+            return out;
+        }
+
+        return height < truncated_ && base.find(height, out);
+    }
+
+    /// Index value at height, unless a block is indexed there.
+    bool insert(const height_index& base, size_t height, const slot& value)
+    {
+        slot existing;
+        if (find(base, height, existing))
+            return false;
+
+        return insert_or_assign(height, value);
+    }
+
+    /// Index value at height, false if the base cannot index height.
+    bool insert_or_assign(size_t height, const slot& value)
+    {
+        if (height >= height_index::max_height)
+            return false;
+
+        changes_[height] = value;
+        size_ = std::max(size_, height + 1);
+        return true;
+    }
+
+    /// Remove the block at height, as height_index::erase.
+    bool erase(const height_index& base, size_t height)
+    {
+        slot existing;
+        if (!find(base, height, existing))
+            return false;
+
+        changes_[height] = slot{};
+        if (height + 1 != size_)
+            return true;
+
+        size_ = height;
+        while (size_ > 0 && !find(base, size_ - 1, existing))
+            --size_;
+
+        return true;
+    }
+
+    /// Remove every block at height and above.
+    void truncate(size_t height)
+    {
+        if (height >= size_)
+            return;
+
+        size_ = height;
+        truncated_ = std::min(truncated_, height);
+        changes_.erase(changes_.lower_bound(height), changes_.end());
+    }
+
+    /// Write the changes to base in one step, at commit of the writer.
+    void apply(height_index& base) const
+    {
+        base.apply(truncated_, changes_, size_);
+    }
+
+private:
+    static const size_t none = std::numeric_limits<size_t>::max();
+
+    // Height to slot, an empty slot where the writer erased a block.
+    std::map<size_t, slot> changes_;
+    size_t size_;
+
+    // Heights from here up are not read from the base.
+    size_t truncated_;
+};
+
+} // namespace container
+} // namespace database
+} // namespace libbitcoin
+
+#endif
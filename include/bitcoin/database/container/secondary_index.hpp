@@ -0,0 +1,195 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_MVCC_SECONDARY_INDEX_HPP
+#define LIBBITCOIN_MVCC_SECONDARY_INDEX_HPP
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <bitcoin/database/storage/slot.hpp>
+#include <libcuckoo/cuckoohash_map.hh>
+
+namespace libbitcoin {
+namespace database {
+namespace container {
+
+using namespace storage;
+
+/**
+ * A secondary_index maps a secondary key to the primary key of a
+ * record, and finds the record's slot through the primary index.
+ *
+ * Only the primary index holds slots, so moving a record, for
+ * compaction or eviction, updates the primary index alone. Each key
+ * maps to one primary key.
+ *
+ * The primary index is any type with
+ * bool find(const PrimaryKey&, slot&) const. If it also has
+ * void prefetch(const PrimaryKey&) const, batched lookups call it
+ * ahead of the primary finds.
+ */
+template <typename Key, typename PrimaryKey, typename Primary,
+    typename Hash = std::hash<Key>, typename Equal = std::equal_to<Key>>
+class secondary_index
+{
+public:
+    typedef std::vector<Key> key_list;
+
+    secondary_index(std::shared_ptr<Primary> primary)
+      : primary_(primary)
+    {
+    }
+
+    /**
+     * Map key to primary, unless key is already mapped.
+     * @return true if key was mapped
+     */
+    bool insert(const Key& key, const PrimaryKey& primary)
+    {
+        return keys_.insert(key, primary);
+    }
+
+    /// Map key to primary, replacing any primary key of key.
+    void insert_or_assign(const Key& key, const PrimaryKey& primary)
+    {
+        keys_.insert_or_assign(key, primary);
+    }
+
+    /**
+     * @return true if key was mapped
+     */
+    bool erase(const Key& key)
+    {
+        return keys_.erase(key);
+    }
+
+    /**
+     * @param key the key to look up
+     * @param out set to the primary key of key, if there is one
+     * @return true if key is mapped
+     */
+    bool find_primary(const Key& key, PrimaryKey& out) const
+    {
+        return keys_.find(key, out);
+    }
+
+    /**
+     * @param key the key to look up
+     * @param out set to the slot of the record of key, if there is one
+     * @return true if key is mapped and its primary key is indexed
+     */
+    bool find(const Key& key, slot& out) const
+    {
+        PrimaryKey primary;
+        return keys_.find(key, primary) && primary_->find(primary, out);
+    }
+
+    /**
+     * Resolve a batch of keys, a step at a time across the batch, so
+     * that the lookups of each step overlap in memory. The buckets of
+     * every key are prefetched first, then primary keys are prefetched
+     * in the primary index, if it can, before they are found.
+     * prefetch(slot) is called as each slot is found, so the
+     * records load while the rest of the batch resolves.
+     * @param out set to the slot of each key, empty where not found
+     * @return the number of keys found
+     */
+    template <typename prefetcher>
+    size_t find(const key_list& keys, std::vector<slot>& out,
+        prefetcher prefetch) const
+    {
+        const auto count = keys.size();
+        for (const auto& key: keys)
+            keys_.prefetch(key);
+
+        std::vector<PrimaryKey> primaries(count);
+        std::vector<bool> mapped(count);
+        for (size_t index = 0; index < count; ++index)
+            mapped[index] = keys_.find(keys[index], primaries[index]);
+
+        prefetch_primaries(primaries, mapped);
+
+        size_t found = 0;
+        out.assign(count, slot{});
+        for (size_t index = 0; index < count; ++index)
+        {
+            if (!mapped[index] ||
+                !primary_->find(primaries[index], out[index]))
+                continue;
+
+            prefetch(out[index]);
+            ++found;
+        }
+
+        return found;
+    }
+
+    size_t find(const key_list& keys, std::vector<slot>& out) const
+    {
+        return find(keys, out, [](const slot&) {});
+    }
+
+    void reserve(size_t count)
+    {
+        keys_.reserve(count + count / 9);
+    }
+
+    size_t size() const
+    {
+        return keys_.size();
+    }
+
+private:
+    template <typename Index, typename = void>
+    struct can_prefetch
+      : std::false_type
+    {
+    };
+
+    template <typename Index>
+    struct can_prefetch<Index, std::void_t<decltype(std::declval<
+        const Index&>().prefetch(std::declval<const PrimaryKey&>()))>>
+      : std::true_type
+    {
+    };
+
+    void prefetch_primaries(const std::vector<PrimaryKey>& primaries,
+        const std::vector<bool>& mapped) const
+    {
+        if constexpr (can_prefetch<Primary>::value)
+        {
+            for (size_t index = 0; index < primaries.size(); ++index)
+                if (mapped[index])
+                    primary_->prefetch(primaries[index]);
+        }
+    }
+
+    const std::shared_ptr<Primary> primary_;
+    libcuckoo::cuckoohash_map<Key, PrimaryKey, Hash, Equal> keys_;
+};
+
+} // namespace container
+} // namespace database
+} // namespace libbitcoin
+
+#endif
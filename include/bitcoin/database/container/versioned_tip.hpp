@@ -0,0 +1,187 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_MVCC_VERSIONED_TIP_HPP
+#define LIBBITCOIN_MVCC_VERSIONED_TIP_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+#include <bitcoin/database/transaction_management/spinlatch.hpp>
+
+namespace libbitcoin {
+namespace database {
+namespace container {
+
+/**
+ * A versioned_tip holds the size of a chain, one past its tip, as of
+ * each of its last changes, so a transaction reads the tip of its own
+ * snapshot.
+ *
+ * Versions live in a ring, each stamped with the timestamp of the
+ * transaction that wrote it. A reader loads the newest version and
+ * steps back only while the version is newer than its snapshot, so
+ * the usual read is the newest version. A version is validated with
+ * its sequence number, if the ring wrapped under the reader, or the
+ * snapshot is older than every version kept, the read fails.
+ *
+ * One transaction at a time may write the tip. It reads its own
+ * uncommitted tip from the index it writes, the tip is published
+ * when it commits.
+ */
+class versioned_tip
+{
+public:
+    typedef uint64_t timestamp_t;
+
+    static const size_t versions = 256;
+
+    versioned_tip()
+      : latch_(std::make_shared<spinlatch>()), head_(0), writer_(no_writer)
+    {
+        ring_[0].sequence.store(0, std::memory_order_relaxed);
+        ring_[0].timestamp.store(0, std::memory_order_relaxed);
+        ring_[0].size.store(0, std::memory_order_relaxed);
+    }
+
+    versioned_tip(const versioned_tip&) = delete;
+    versioned_tip& operator=(const versioned_tip&) = delete;
+
+    /**
+     * @param snapshot the timestamp of the reading transaction
+     * @param out set to the size visible at snapshot
+     * @return false if the version visible at snapshot is not kept
+     */
+    bool find(timestamp_t snapshot, size_t& out) const
+    {
+        const auto head = head_.load(std::memory_order_acquire);
+        const auto oldest = head < versions ? 0 : head - versions + 1;
+
+        for (auto sequence = head; ; --sequence)
+        {
+            const auto& version = ring_[sequence % versions];
+            const auto before = version.sequence.load(
+                std::memory_order_acquire);
+            const auto timestamp = version.timestamp.load(
+                std::memory_order_relaxed);
+            const auto size = version.size.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            // Overwritten since the head was read.
+            if (before != sequence ||
+                version.sequence.load(std::memory_order_relaxed) != sequence)
+                return false;
+
+            if (timestamp <= snapshot)
+            {
+                out = size;
+                return true;
+            }
+
+            if (sequence == oldest)
+                return false;
+        }
+    }
+
+    /**
+     * Make the transaction at timestamp the writer of the tip.
+     * @return false if another transaction is writing the tip
+     */
+    bool begin_write(timestamp_t timestamp)
+    {
+        auto expected = no_writer;
+        return writer_.compare_exchange_strong(expected, timestamp,
+            std::memory_order_acq_rel) || expected == timestamp;
+    }
+
+    /// True if the transaction at timestamp is writing the tip.
+    bool is_writer(timestamp_t timestamp) const
+    {
+        return writer_.load(std::memory_order_acquire) == timestamp;
+    }
+
+    /**
+     * Publish size as the tip of the writer at timestamp and end its
+     * write. A version is never older than the one before it, a
+     * writer committing behind a newer version is stamped with the
+     * newer timestamp.
+     */
+    void commit_write(timestamp_t timestamp, size_t size)
+    {
+        publish(timestamp, size);
+        end_write(timestamp);
+    }
+
+    /// End the write of the transaction at timestamp, if it writes.
+    void end_write(timestamp_t timestamp)
+    {
+        auto expected = timestamp;
+        writer_.compare_exchange_strong(expected, no_writer,
+            std::memory_order_acq_rel);
+    }
+
+    /// Publish size without a writer, as on recovery.
+    void publish(timestamp_t timestamp, size_t size)
+    {
+        scopedspinlatch guard(latch_);
+        const auto head = head_.load(std::memory_order_relaxed);
+        const auto& newest = ring_[head % versions];
+        const auto stamp = std::max(timestamp,
+            newest.timestamp.load(std::memory_order_relaxed));
+
+        // Unchanged, every snapshot already reads size.
+        if (size == newest.size.load(std::memory_order_relaxed))
+            return;
+
+        const auto sequence = head + 1;
+        auto& version = ring_[sequence % versions];
+        version.sequence.store(invalid, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        version.timestamp.store(stamp, std::memory_order_relaxed);
+        version.size.store(size, std::memory_order_relaxed);
+        version.sequence.store(sequence, std::memory_order_release);
+        head_.store(sequence, std::memory_order_release);
+    }
+
+private:
+    static const timestamp_t no_writer =
+        std::numeric_limits<timestamp_t>::max();
+    static const uint64_t invalid = std::numeric_limits<uint64_t>::max();
+
+    struct entry
+    {
+        std::atomic<uint64_t> sequence{ invalid };
+        std::atomic<timestamp_t> timestamp{ 0 };
+        std::atomic<size_t> size{ 0 };
+    };
+
+    std::shared_ptr<spinlatch> latch_;
+    entry ring_[versions];
+    std::atomic<uint64_t> head_;
+    std::atomic<timestamp_t> writer_;
+};
+
+} // namespace container
+} // namespace database
+} // namespace libbitcoin
+
+#endif
@@ -19,12 +19,24 @@
 #ifndef LIBBITCOIN_MVCC_DATABASE_BLOCK_DATABASE_HPP
 #define LIBBITCOIN_MVCC_DATABASE_BLOCK_DATABASE_HPP
 
+#include <array>
 #include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <vector>
 
 #include <bitcoin/system.hpp>
 #include <bitcoin/database/define.hpp>
 
+#include <bitcoin/database/container/art_index.hpp>
+#include <bitcoin/database/container/filtered_index.hpp>
+#include <bitcoin/database/container/fingerprint_index.hpp>
+#include <bitcoin/database/container/height_index.hpp>
+#include <bitcoin/database/container/pending_heights.hpp>
+#include <bitcoin/database/container/versioned_tip.hpp>
+#include <bitcoin/database/durability/checkpointer.hpp>
+#include <bitcoin/database/durability/log_manager.hpp>
+#include <bitcoin/database/durability/redo_record.hpp>
 #include <bitcoin/database/mvto/accessor.hpp>
 #include <bitcoin/database/storage/storage.hpp>
 #include <bitcoin/database/transaction_management/transaction_context.hpp>
@@ -32,8 +44,6 @@
 #include <bitcoin/database/tuples/block_tuple_delta.hpp>
 #include <bitcoin/database/tuples/mvcc_record.hpp>
 
-#include <libcuckoo/cuckoohash_map.hh>
-
 namespace libbitcoin {
 namespace database {
 
@@ -41,13 +51,46 @@ using namespace mvto;
 using namespace tuples;
 using namespace storage;
 
-/// index by height
-typedef
-libcuckoo::cuckoohash_map<size_t, slot> height_index_map;
+/// index by height, dense from the genesis block
+typedef container::height_index height_index_map;
 
-/// index by block hash
-typedef
-libcuckoo::cuckoohash_map<system::hash_digest, slot> hash_digest_index_map;
+/// committed tip of a height index, by transaction timestamp
+typedef container::versioned_tip chain_tip;
+
+#ifdef WITH_ART_INDEX
+/// index by block hash, in an adaptive radix tree
+typedef container::filtered_index<container::art_index>
+    hash_digest_index_map;
+#else
+/// index by block hash, keyed on a fingerprint of the hash
+typedef container::filtered_index<container::fingerprint_index>
+    hash_digest_index_map;
+#endif
+
+/// Cumulative proof of work, big endian so that byte order is
+/// numeric order.
+typedef std::array<uint8_t, 32> chain_work;
+
+/// Per block data that never changes once written, kept in the cold
+/// column of the block store. The links are slots, so they are rebuilt
+/// on recovery and never logged.
+struct block_cold_column
+{
+    system::hash_digest hash;
+
+    // The previous block.
+    slot parent;
+
+    // An exponentially distant ancestor, see skip_height.
+    slot skip;
+
+    // Work of the block and every linked ancestor.
+    chain_work work;
+
+    // Timestamp of the transaction that stored the block, until it
+    // commits. Readers skip the block's hash index entry while set.
+    std::atomic<uint64_t> pending;
+};
 
 typedef
 std::shared_ptr<storage::store<block_mvcc_record>> block_store_ptr;
@@ -67,6 +110,10 @@ public:
     /// Construct the database.
     block_database(uint64_t, uint64_t, uint64_t, uint64_t);
 
+    /// Construct the database, made durable by the redo log.
+    block_database(durability::log_manager_ptr, uint64_t, uint64_t,
+        uint64_t, uint64_t);
+
     /// TODO: Take a snapshot.
     /// TODO: Free all used memory - requires us to switch to object
     /// pool first.
@@ -75,22 +122,57 @@ public:
     // Startup and shutdown.
     // ------------------------------------------------------------------------
 
-    /// Initialize a new block database.
+    /// Size the indexes for a chain of expected_height blocks, so
+    /// that they do not grow while the chain stays below it. Call at
+    /// startup, before create or open, as growing the hash index
+    /// locks all of it.
+    void reserve(size_t expected_height);
+
+    /// Put a filter in front of the hash index, sized for
+    /// expected_count blocks, so that most lookups of unknown hashes
+    /// do not probe the index. Lookups of known hashes read one more
+    /// cache line. Call at startup, before create or open.
+    bool filter_hashes(size_t expected_count);
+
+    /// Initialize a new block database, starting a new redo log.
     bool create();
 
-    /// Call before using the database.
+    /// Call before using the database. Loads the latest checkpoint
+    /// and replays the redo log after it, on all hardware threads.
     bool open();
 
-    /// Commit latest inserts.
+    /// Open, recovering on the given number of threads. The
+    /// checkpoint is restored in batches split across threads, the
+    /// log is replayed partitioned by block hash, then the height
+    /// indexes are rebuilt from the store blocks in parallel.
+    bool open(size_t threads);
+
+    /// Make all committed transactions durable.
     void commit();
 
-    /// Compact and write latest snapshot
+    /// Flush and close the redo log.
     bool close();
 
+    /// Write a checkpoint of the committed blocks and truncate the
+    /// redo log. Runs alongside writers, does not block them.
+    bool checkpoint(transaction_manager& manager);
+
+    /// Apply a redo record read from the log. Inserts of known
+    /// blocks are skipped and updates write absolute values, so
+    /// applying a record more than once is harmless. Height indexes
+    /// are not updated, open rebuilds them once replay is done.
+    bool apply(transaction_context& context,
+        const durability::redo_record& record);
+
     // Queries.
     //-------------------------------------------------------------------------
 
-    /// The height of the highest candidate|confirmed block.
+    /// The height of the highest candidate|confirmed block as of the
+    /// context's snapshot, read without locking. The transaction
+    /// writing the chain sees its own uncommitted tip. False if the
+    /// chain is empty, which does not abort the context. False and
+    /// the context is aborted if its snapshot is older than every tip
+    /// kept.
     bool top(transaction_context& context, size_t& out_height,
         bool candidate) const;
 
@@ -98,10 +180,70 @@ public:
     block_tuple_ptr get(transaction_context& context, size_t height,
         bool candidate) const;
 
+    /// The hash of the block at height of the candidate|confirmed
+    /// chain, read from the hash column without hashing the header.
+    bool get_hash(transaction_context& context, size_t height,
+        bool candidate, system::hash_digest& out) const;
+
+    /// The block locator of the candidate|confirmed chain, hashes of
+    /// the top ten blocks then at doubling steps down to genesis.
+    /// Hashes are read from the height index and the hash column, out
+    /// is sized once and no tuple is read. False and out is empty if
+    /// the chain is empty, which does not abort the context.
+    bool locator(transaction_context& context, bool candidate,
+        system::hash_list& out) const;
+
+    /// The hash of the ancestor at height of the block with hash,
+    /// following skip links in O(log n) record reads. Links are not
+    /// versioned, they are set when a block is stored and its parent
+    /// is already stored.
+    bool get_ancestor(transaction_context& context,
+        const system::hash_digest& hash, size_t height,
+        system::hash_digest& out) const;
+
+    /// The work of the block with hash and all of its ancestors, set
+    /// with its links when it is stored.
+    bool get_work(transaction_context& context,
+        const system::hash_digest& hash, system::uint256_t& out) const;
+
+    /// Compare the cumulative work of two blocks without walking
+    /// either branch, out is negative, zero or positive as left has
+    /// less, equal or more work than right.
+    bool compare_work(transaction_context& context,
+        const system::hash_digest& left, const system::hash_digest& right,
+        int& out) const;
+
+    /// Read the blocks at heights [from, to) of the candidate|confirmed
+    /// chain into out, all at the context's timestamp. Stops at the
+    /// first height not indexed or not readable, returns the number of
+    /// blocks read. Records are prefetched ahead of the reads.
+    size_t get(transaction_context& context, size_t from, size_t to,
+        bool candidate, std::vector<block_tuple>& out) const;
+
+    /// Read as above, appending 80 byte wire encoded headers to out.
+    size_t get_headers(transaction_context& context, size_t from, size_t to,
+        bool candidate, system::data_chunk& out) const;
+
     // /// Fetch block by hash.
     block_tuple_ptr get(transaction_context& context,
         const system::hash_digest& hash) const;
 
+    /// Fetch the blocks with hashes, out[i] is null if hashes[i] is not
+    /// found. Lookups are interleaved on the calling thread, each one
+    /// suspending after it prefetches index buckets, its record and the
+    /// record's first delta, so that the cache misses of lookups in
+    /// flight overlap. Returns the number found, missing hashes do not
+    /// abort the context.
+    size_t multi_get(transaction_context& context,
+        const system::hash_list& hashes,
+        std::vector<block_tuple_ptr>& out) const;
+
+    /// As above, with width lookups in flight. A width of one runs
+    /// the lookups in sequence.
+    size_t multi_get(transaction_context& context,
+        const system::hash_list& hashes, std::vector<block_tuple_ptr>& out,
+        size_t width) const;
+
     /// get error from the state field of block_tuple_ptr
     code get_error(block_tuple_ptr) const;
 
@@ -109,6 +251,10 @@ public:
     void get_header_metadata(transaction_context& context,
         const system::chain::header& header) const;
 
+    /// How hash lookups went through the filter of the hash index,
+    /// zero unless filter_hashes was called.
+    hash_digest_index_map::counters hash_lookup_counters() const;
+
     // Writers.
     // ------------------------------------------------------------------------
 
@@ -120,6 +266,14 @@ public:
         const size_t height, const uint32_t median_time_past,
         const uint32_t checksum, const uint8_t state);
 
+    /// Store a run of headers at consecutive heights from
+    /// start_height, with median_time_pasts holding one entry per
+    /// header. Headers are hashed in parallel, their tuple slots are
+    /// taken in bulk and the hash index is grown once for the batch.
+    bool store_headers(transaction_context& context,
+        const system::chain::header::list& headers, size_t start_height,
+        const std::vector<uint32_t>& median_time_pasts, uint8_t state);
+
     /// Populate pooled block transaction references, state is unchanged.
     bool update_transactions(transaction_context& context,
         const system::chain::block& block);
@@ -137,7 +291,19 @@ public:
     bool demote(transaction_context& context, const system::hash_digest& hash,
         size_t height, bool candidate);
 
+    /// Replace the candidate|confirmed chain above fork_height in one
+    /// step. outgoing holds the blocks currently above the fork and
+    /// incoming the blocks replacing them, both in height order. All
+    /// slots are resolved before any delta is written, and an abort of
+    /// the context restores the outgoing chain in the height index.
+    bool reorganize(transaction_context& context, size_t fork_height,
+        const system::hash_list& outgoing, const system::hash_list& incoming,
+        bool candidate);
+
 private:
+    // A resumable lookup by hash, interleaved by multi_get.
+    class hash_lookup;
+
     block_pool_ptr block_store_pool_;
     block_store_ptr block_store_;
 
@@ -156,9 +322,78 @@ private:
     std::shared_ptr<height_index_map> candidate_index_;
     std::shared_ptr<height_index_map> confirmed_index_;
     std::shared_ptr<hash_digest_index_map> hash_digest_index_;
+    std::shared_ptr<chain_tip> candidate_tip_;
+    std::shared_ptr<chain_tip> confirmed_tip_;
+
+    // Uncommitted height index changes of each chain's writer.
+    std::shared_ptr<container::pending_heights> candidate_pending_;
+    std::shared_ptr<container::pending_heights> confirmed_pending_;
 
     bool promote(transaction_context& context,const system::hash_digest& hash,
         size_t height, bool candidate, bool promote_or_demote);
+
+    block_cold_column& cold(const slot& at_slot) const;
+
+    // Construct the cold column of a new block stored by the
+    // transaction at pending, zero if it is already committed.
+    void make_cold(const slot& at_slot, const system::hash_digest& hash,
+        uint64_t pending);
+
+    // Hash and height index lookups, as seen by the context. Entries of
+    // other transactions' uncommitted writes are skipped.
+    bool find_hash(const transaction_context& context,
+        const system::hash_digest& hash, slot& out) const;
+    bool find_height(const transaction_context& context, size_t height,
+        bool candidate, slot& out) const;
+    bool is_visible(const transaction_context& context,
+        const slot& at_slot) const;
+
+    // Commit or drop the hash index entries of stored blocks along
+    // with the context.
+    void register_stored(transaction_context& context,
+        const std::vector<system::hash_digest>& hashes,
+        const std::vector<slot>& slots);
+    size_t height_of(const slot& at_slot) const;
+
+    // Set the parent and skip links and the cumulative work of the
+    // block at at_slot, parent is null if it is not stored.
+    void link(const slot& at_slot, const slot& parent);
+
+    // The ancestor at height of the block at at_slot, null if a link
+    // on the way is missing.
+    slot get_ancestor(slot at_slot, size_t height) const;
+
+    // Rebuild the links of recovered blocks, in height order.
+    void link_blocks(size_t threads);
+
+    // Make the context the writer of the candidate|confirmed chain,
+    // its tip is published when it commits.
+    bool write_tip(transaction_context& context, bool candidate);
+
+    bool update_state(transaction_context& context,
+        const system::hash_digest& hash, slot at_slot, bool candidate,
+        bool promote_or_demote);
+
+    // Read [from, to) and call visit(const block_tuple&) for each block.
+    template <typename visitor>
+    size_t read_range(transaction_context& context, size_t from, size_t to,
+        bool candidate, visitor visit) const;
+
+    // Rebuild the height indexes from the state of recovered blocks,
+    // false if a recovered height does not fit the index.
+    bool index_heights(size_t threads);
+
+    // Store and hash index a block read from a checkpoint or the log.
+    bool restore(transaction_context& context,
+        const system::hash_digest& hash, block_tuple_ptr block);
+
+    bool save(durability::checkpoint_writer& writer,
+        timestamp_t snapshot) const;
+
+    bool load(durability::checkpoint_reader& reader, size_t threads);
+
+    durability::log_manager_ptr log_;
+    durability::checkpointer checkpointer_;
 };
 
 } // namespace database
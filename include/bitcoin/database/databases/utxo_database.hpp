@@ -0,0 +1,267 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBBITCOIN_MVCC_DATABASE_UTXO_DATABASE_HPP
+#define LIBBITCOIN_MVCC_DATABASE_UTXO_DATABASE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <bitcoin/system.hpp>
+#include <bitcoin/database/define.hpp>
+
+#include <bitcoin/database/container/hash_digest_hasher.hpp>
+#include <bitcoin/database/container/outpoint_index.hpp>
+#include <bitcoin/database/durability/checkpointer.hpp>
+#include <bitcoin/database/durability/log_manager.hpp>
+#include <bitcoin/database/durability/redo_record.hpp>
+#include <bitcoin/database/mvto/accessor.hpp>
+#include <bitcoin/database/storage/object_pool.hpp>
+#include <bitcoin/database/storage/storage.hpp>
+#include <bitcoin/database/transaction_management/transaction_context.hpp>
+#include <bitcoin/database/transaction_management/spinlatch.hpp>
+#include <bitcoin/database/transaction_management/transaction_manager.hpp>
+#include <bitcoin/database/tuples/mvcc_record.hpp>
+#include <bitcoin/database/tuples/utxo_tuple.hpp>
+#include <bitcoin/database/tuples/utxo_tuple_delta.hpp>
+#include <libcuckoo/cuckoohash_map.hh>
+
+namespace libbitcoin {
+namespace database {
+
+using namespace mvto;
+using namespace tuples;
+using namespace storage;
+
+/// index by outpoint, keyed on a compact encoding of the outpoint
+typedef container::outpoint_index outpoint_index_map;
+
+/// scripts too long for the tuple, by outpoint
+typedef libcuckoo::cuckoohash_map<system::chain::point, system::data_chunk,
+    container::point_hasher> script_overflow_map;
+
+/// The outpoint of a stored output, kept in the cold column of the
+/// utxo store and keying its redo records. It never changes, so the
+/// index verifies its compact keys against it without a transaction.
+struct utxo_cold_column
+{
+    system::hash_digest hash;
+    uint32_t index;
+};
+
+typedef
+std::shared_ptr<storage::store<utxo_mvcc_record>> utxo_store_ptr;
+
+typedef
+std::shared_ptr<storage::store<utxo_delta_mvcc_record>> utxo_delta_store_ptr;
+
+/// Access utxo storage
+typedef
+accessor<utxo_mvcc_record, utxo_delta_mvcc_record> utxo_mvto_accessor;
+
+/// Stores transaction outputs by outpoint, with the height of their
+/// block. A spend is a delta of the output's state, so a context reads
+/// the output as unspent until the spend is visible to it.
+///
+/// Once no transaction can read a spent output as unspent, reclaim
+/// drops it from the index and the long script map. The store is
+/// append only, its records of spent outputs are left out of
+/// checkpoints and so dropped when the database is next opened.
+class BCD_API utxo_database
+{
+public:
+    /// Construct the database.
+    utxo_database(uint64_t, uint64_t, uint64_t, uint64_t);
+
+    /// Construct the database, made durable by the redo log.
+    utxo_database(durability::log_manager_ptr, uint64_t, uint64_t,
+        uint64_t, uint64_t);
+
+    ~utxo_database() = default;
+
+    // Startup and shutdown.
+    // ------------------------------------------------------------------------
+
+    /// Size the index for expected_count outputs, unspent or spent
+    /// since the last reclaim, so that it does not grow while the set
+    /// stays below it. Call at startup, before create or open, as
+    /// growing the index locks all of it.
+    void reserve(size_t expected_count);
+
+    /// Initialize a new utxo database, starting a new redo log.
+    bool create();
+
+    /// Call before using the database. Loads the latest checkpoint
+    /// and replays the redo log after it, on all hardware threads.
+    bool open();
+
+    /// Open, recovering on the given number of threads. The
+    /// checkpoint is restored in batches split across threads, the
+    /// log is replayed partitioned by outpoint.
+    bool open(size_t threads);
+
+    /// Make all committed transactions durable.
+    void commit();
+
+    /// Flush and close the redo log.
+    bool close();
+
+    /// Write a checkpoint of the unspent outputs and truncate the
+    /// redo log. Runs alongside writers, does not block them.
+    bool checkpoint(transaction_manager& manager);
+
+    /// Apply a redo record read from the log. Stores of known outputs
+    /// are skipped, and a spent output is dropped from the index at
+    /// once, so applying a record more than once is harmless.
+    bool apply(transaction_context& context,
+        const durability::redo_record& record);
+
+    /// Drop the outputs spent before the oldest active transaction of
+    /// manager from the index and the long script map, return the
+    /// number dropped. Call periodically, as checkpoint.
+    size_t reclaim(const transaction_manager& manager);
+
+    // Queries.
+    //-------------------------------------------------------------------------
+
+    /// Fetch the unspent output at point, null and the context is
+    /// aborted if it is missing or spent.
+    utxo_tuple_ptr get(transaction_context& context,
+        const system::chain::point& point) const;
+
+    /// Fetch the outputs at points, out[i] is null if points[i] is
+    /// missing or spent. Lookups are interleaved on the calling thread
+    /// as by block_database::multi_get. Returns the number found,
+    /// missing outputs do not abort the context.
+    size_t multi_get(transaction_context& context,
+        const system::chain::point::list& points,
+        std::vector<utxo_tuple_ptr>& out) const;
+
+    /// As above, with width lookups in flight.
+    size_t multi_get(transaction_context& context,
+        const system::chain::point::list& points,
+        std::vector<utxo_tuple_ptr>& out, size_t width) const;
+
+    /// The script of the output at point, read from the tuple or from
+    /// the long script map.
+    bool get_script(const system::chain::point& point,
+        const utxo_tuple& output, system::data_chunk& out) const;
+
+    /// The number of outputs indexed, unspent or not yet reclaimed.
+    size_t size() const;
+
+    /// The bytes taken by the compact keys of the outpoint index.
+    size_t index_bytes() const;
+
+    // Writers.
+    // ------------------------------------------------------------------------
+
+    /// Store output at point, unspent at height. False and the context
+    /// is aborted if point is already stored.
+    bool store(transaction_context& context,
+        const system::chain::point& point,
+        const system::chain::output& output, uint32_t height);
+
+    /// Store the outputs of every transaction of block at height, in
+    /// one batch. Provably unspendable outputs are not stored.
+    bool store(transaction_context& context,
+        const system::chain::block& block, uint32_t height);
+
+    /// Spend the output at point. False and the context is aborted if
+    /// it is missing or already spent.
+    bool spend(transaction_context& context,
+        const system::chain::point& point);
+
+    /// Spend the outputs at points, after an interleaved lookup of all
+    /// of their slots. False and the context is aborted if any is
+    /// missing or already spent.
+    bool spend(transaction_context& context,
+        const system::chain::point::list& points);
+
+    /// Spend the previous outputs of the inputs of every transaction of
+    /// block but the coinbase. Store the block first if it spends its
+    /// own outputs.
+    bool spend(transaction_context& context,
+        const system::chain::block& block);
+
+private:
+    // A resumable lookup by outpoint, interleaved by multi_get and
+    // spend.
+    class point_lookup;
+
+    // An output spent by a committed transaction, not yet reclaimed.
+    struct spent_output
+    {
+        slot at_slot;
+        timestamp_t timestamp;
+        bool long_script;
+    };
+
+    block_pool_ptr utxo_store_pool_;
+    utxo_store_ptr utxo_store_;
+
+    block_pool_ptr delta_store_pool_;
+    utxo_delta_store_ptr delta_store_;
+
+    utxo_mvto_accessor accessor_;
+
+    std::shared_ptr<outpoint_index_map> outpoint_index_;
+    std::shared_ptr<script_overflow_map> script_overflow_;
+
+    utxo_cold_column& cold(const slot& at_slot) const;
+
+    // Index the outputs stored at slots, dropping the entries if the
+    // context aborts.
+    bool index(transaction_context& context,
+        const system::chain::point::list& points,
+        const std::vector<slot>& slots);
+
+    // Spend the output at slot, adding it to spent.
+    bool spend(transaction_context& context, const slot& at_slot,
+        std::vector<spent_output>& spent);
+
+    // Queue the outputs spent by context for reclaim once it commits.
+    void register_spent(transaction_context& context,
+        std::vector<spent_output>&& spent);
+
+    // Store and index an output read from a checkpoint or the log.
+    bool restore(transaction_context& context,
+        const system::chain::point& point, const utxo_tuple& data,
+        system::data_chunk&& script);
+
+    bool save(durability::checkpoint_writer& writer,
+        timestamp_t snapshot) const;
+
+    bool load(durability::checkpoint_reader& reader, size_t threads);
+
+    // Outputs spent by committed transactions, appended to by their
+    // commit actions.
+    std::shared_ptr<spinlatch> spent_latch_;
+    std::shared_ptr<std::vector<spent_output>> spent_;
+
+    durability::log_manager_ptr log_;
+    durability::checkpointer checkpointer_;
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,138 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_MVCC_DATABASE_CHECKPOINT_FILE_HPP
+#define LIBBITCOIN_MVCC_DATABASE_CHECKPOINT_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <type_traits>
+
+#include <bitcoin/system.hpp>
+#include <bitcoin/database/define.hpp>
+#include <bitcoin/database/durability/redo_record.hpp>
+
+namespace libbitcoin {
+namespace database {
+namespace durability {
+
+///////////////////////////////////////////////////////////////////////////////
+// Layout of a checkpoint file
+// magic          4 bytes
+// reserved       4 bytes
+// snapshot       8 bytes, timestamp the stores were read at
+// segment        8 bytes, first log segment to replay after loading
+// table sections written by each database
+///////////////////////////////////////////////////////////////////////////////
+
+const uint32_t checkpoint_magic = 0x4d564350;
+const size_t checkpoint_header_size = 24;
+
+/// Writes a checkpoint to a temporary file next to path, the file
+/// only replaces path on commit. A checkpoint that is interrupted
+/// leaves the previous one in place.
+class BCD_API checkpoint_writer
+{
+public:
+    checkpoint_writer(const std::string& path);
+
+    /// Remove the temporary file unless committed.
+    ~checkpoint_writer();
+
+    checkpoint_writer(const checkpoint_writer&) = delete;
+    checkpoint_writer& operator=(const checkpoint_writer&) = delete;
+
+    /// Create the temporary file and write the header.
+    bool open(timestamp_t snapshot, size_t segment);
+
+    bool write(const uint8_t* data, size_t size);
+
+    template <typename value_type>
+    bool write(const value_type& value)
+    {
+        static_assert(std::is_trivially_copyable<value_type>::value,
+            "checkpoint values are copied as bytes");
+        return write(reinterpret_cast<const uint8_t*>(&value),
+            sizeof(value_type));
+    }
+
+    /// Overwrite bytes already written, used to fill in counts.
+    bool write_at(uint64_t position, const uint8_t* data, size_t size);
+
+    template <typename value_type>
+    bool write_at(uint64_t position, const value_type& value)
+    {
+        static_assert(std::is_trivially_copyable<value_type>::value,
+            "checkpoint values are copied as bytes");
+        return write_at(position, reinterpret_cast<const uint8_t*>(&value),
+            sizeof(value_type));
+    }
+
+    /// Bytes written so far, including the header.
+    uint64_t position() const;
+
+    /// Write out, sync and rename the temporary file to path.
+    bool commit();
+
+private:
+    bool flush_buffer();
+
+    const std::string path_;
+    const std::string temporary_path_;
+    int file_;
+    uint64_t position_;
+    system::data_chunk buffer_;
+};
+
+/// Reads a checkpoint written by checkpoint_writer.
+class BCD_API checkpoint_reader
+{
+public:
+    checkpoint_reader(const std::string& path);
+
+    /// Open the file and read the header.
+    bool open();
+
+    timestamp_t snapshot() const;
+
+    size_t segment() const;
+
+    bool read(uint8_t* data, size_t size);
+
+    template <typename value_type>
+    bool read(value_type& value)
+    {
+        static_assert(std::is_trivially_copyable<value_type>::value,
+            "checkpoint values are copied as bytes");
+        return read(reinterpret_cast<uint8_t*>(&value), sizeof(value_type));
+    }
+
+private:
+    const std::string path_;
+    std::ifstream file_;
+    timestamp_t snapshot_;
+    size_t segment_;
+};
+
+} // namespace durability
+} // namespace database
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,83 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_MVCC_DATABASE_CHECKPOINTER_HPP
+#define LIBBITCOIN_MVCC_DATABASE_CHECKPOINTER_HPP
+
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+
+#include <bitcoin/system.hpp>
+#include <bitcoin/database/define.hpp>
+#include <bitcoin/database/durability/checkpoint_file.hpp>
+#include <bitcoin/database/durability/log_manager.hpp>
+#include <bitcoin/database/transaction_management/transaction_manager.hpp>
+
+namespace libbitcoin {
+namespace database {
+namespace durability {
+
+// Write every version committed at the snapshot timestamp.
+typedef std::function<bool(checkpoint_writer&, timestamp_t)> checkpoint_saver;
+
+// Restore the versions written by a checkpoint_saver.
+typedef std::function<bool(checkpoint_reader&)> checkpoint_loader;
+
+/// checkpointer writes fuzzy checkpoints next to the redo log and
+/// truncates the log segments they cover.
+///
+/// A checkpoint starts a new log segment, waits for the commits
+/// that logged to earlier segments to install their versions, then
+/// reads the stores at a snapshot timestamp taken after that. Writers
+/// are not blocked, versions they commit during the scan may or may
+/// not be in the checkpoint, but are always in the log from the new
+/// segment on. Replay is idempotent, so restart loads the checkpoint
+/// and replays the log from that segment.
+class BCD_API checkpointer
+{
+public:
+    checkpointer(log_manager_ptr log);
+
+    /// Remove existing checkpoints.
+    bool create();
+
+    /// Write a checkpoint using save, then remove the log segments
+    /// and checkpoints it replaces.
+    bool checkpoint(transaction_manager& manager,
+        const checkpoint_saver& save);
+
+    /// Load the latest checkpoint, if there is one, using load. Set
+    /// segment to the first log segment to replay.
+    bool load(const checkpoint_loader& load, size_t& segment) const;
+
+    std::string checkpoint_path(size_t segment) const;
+
+private:
+    log_manager_ptr log_;
+
+    // One checkpoint at a time.
+    std::mutex mutex_;
+};
+
+} // namespace durability
+} // namespace database
+} // namespace libbitcoin
+
+#endif
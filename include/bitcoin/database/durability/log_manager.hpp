@@ -0,0 +1,217 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_MVCC_DATABASE_LOG_MANAGER_HPP
+#define LIBBITCOIN_MVCC_DATABASE_LOG_MANAGER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <bitcoin/system.hpp>
+#include <bitcoin/database/define.hpp>
+#include <bitcoin/database/durability/redo_record.hpp>
+#include <bitcoin/database/transaction_management/spinlatch.hpp>
+
+namespace libbitcoin {
+namespace database {
+namespace durability {
+
+// Position in the redo log, in bytes appended since the log was
+// created or opened.
+typedef uint64_t log_sequence_number;
+
+// Versions restored from a checkpoint or the log begin at this
+// timestamp. A transaction manager writing to a log starts after it,
+// so recovered versions are readable by, and distinct from, every
+// later transaction.
+const timestamp_t recovery_timestamp = 1;
+
+// Called for each redo record found while replaying the log, with
+// the timestamp of the transaction that wrote it.
+typedef std::function<void(timestamp_t, const redo_record&)> redo_handler;
+
+///////////////////////////////////////////////////////////////////////////////
+// Layout of a commit frame in a log segment
+// payload size 4 bytes
+// checksum     4 bytes, crc32 of timestamp and payload
+// timestamp    8 bytes
+// payload      redo records of the transaction
+///////////////////////////////////////////////////////////////////////////////
+
+const size_t commit_frame_header_size = 16;
+
+/// log_manager writes the redo records of committing transactions to
+/// an append only log, using plain write and fdatasync, no mmap.
+///
+/// Group commit: commits append their frame to an in memory buffer
+/// and a flusher thread writes and syncs the buffer once per
+/// flush_interval, or as soon as flush_bytes are waiting. A commit
+/// waits for its frame to be durable only if synchronous is set.
+/// A longer interval batches more transactions into each fsync, at
+/// the cost of commit latency.
+///
+/// The log is split into numbered segment files in directory, so
+/// that old segments can be dropped once a checkpoint covers them.
+/// Commits that append a frame report when their versions are
+/// installed, so a checkpoint can tell when every frame before a
+/// segment is reflected in the stores.
+///
+/// A write or sync error fails the log. Frames are never written
+/// after a failure, as the file may end in part of a frame, and
+/// waiting commits return false instead of blocking.
+class BCD_API log_manager
+{
+public:
+    log_manager(const std::string& directory,
+        std::chrono::microseconds flush_interval, size_t flush_bytes,
+        bool synchronous);
+
+    ~log_manager();
+
+    log_manager(const log_manager&) = delete;
+    log_manager& operator=(const log_manager&) = delete;
+
+    /// Remove any existing log segments and start a new log.
+    bool create();
+
+    /// Start appending to a new segment after the existing ones.
+    /// Replay the log before calling open.
+    bool open();
+
+    /// Flush all appended frames and stop the flusher, false if the
+    /// log has failed.
+    bool close();
+
+    /// Replay every complete frame, in log order, from segments
+    /// numbered from_segment and later. A torn or corrupt frame ends
+    /// its segment, each start after a crash begins a new segment.
+    bool replay(size_t from_segment, const redo_handler& handler) const;
+
+    /// Replay as above on threads, with the records of each segment
+    /// partitioned by key. Records with the same key reach handler in
+    /// log order on one thread, handler must be thread safe.
+    bool replay(size_t from_segment, const redo_handler& handler,
+        size_t threads) const;
+
+    /// Append the redo payload of a transaction, return the log
+    /// sequence number at the end of its frame, or zero if the log is
+    /// failed or not open.
+    log_sequence_number append(timestamp_t timestamp,
+        const system::data_chunk& payload);
+
+    /// Append as above, and track the commit as in flight in the
+    /// returned segment until release is called. Nothing is tracked
+    /// if zero is returned.
+    log_sequence_number append(timestamp_t timestamp,
+        const system::data_chunk& payload, size_t& segment);
+
+    /// The commit that appended to segment has installed its versions.
+    void release(size_t segment);
+
+    /// Flush the current segment and start appending to the next,
+    /// return the number of the new segment. Fails the log and returns
+    /// the current segment if the next can't be opened.
+    size_t rotate();
+
+    /// Block until no commit that appended to a segment before
+    /// segment is still installing its versions.
+    void wait_for_commits(size_t segment);
+
+    /// Remove the segments numbered before segment.
+    bool truncate(size_t segment);
+
+    /// Block until the frame ending at lsn is durable. Returns
+    /// immediately unless commits are synchronous. False if the log
+    /// has failed before the frame is durable.
+    bool wait(log_sequence_number lsn);
+
+    /// Write and sync everything appended so far.
+    void flush();
+
+    log_sequence_number durable_lsn() const;
+
+    bool is_synchronous() const;
+
+    /// A write or sync of the log has failed, nothing more is written.
+    bool is_failed() const;
+
+    const std::string& directory() const;
+
+    std::string segment_path(size_t segment) const;
+
+private:
+    void run_flusher();
+
+    // write the pending buffer to the current segment and sync it.
+    // Caller must hold write_mutex_.
+    void write_pending();
+
+    // write the swapped out buffer, ending at lsn, and sync it.
+    // Caller must hold write_mutex_.
+    void write_writing(log_sequence_number lsn);
+
+    // Stop writing and wake the commit waiters.
+    void fail();
+
+    bool open_segment(size_t segment);
+    void close_segment();
+
+    const std::string directory_;
+    const std::chrono::microseconds flush_interval_;
+    const size_t flush_bytes_;
+    const bool synchronous_;
+
+    // Appends to pending_ hold the latch, it is never held during
+    // file io.
+    std::shared_ptr<spinlatch> latch_;
+    system::data_chunk pending_;
+    log_sequence_number appended_lsn_;
+    std::map<size_t, size_t> inflight_;
+
+    // Serializes writes to the segment file. segment_ only changes
+    // while holding both write_mutex_ and latch_.
+    std::mutex write_mutex_;
+    system::data_chunk writing_;
+    int file_;
+    size_t segment_;
+
+    // Flusher wake up and commit waiters.
+    std::mutex wait_mutex_;
+    std::condition_variable flush_requested_;
+    std::condition_variable flushed_;
+    std::atomic<log_sequence_number> durable_lsn_;
+    std::atomic<bool> failed_;
+    std::atomic<bool> stopped_;
+    std::thread flusher_;
+};
+
+typedef std::shared_ptr<log_manager> log_manager_ptr;
+
+} // namespace durability
+} // namespace database
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,93 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_MVCC_DATABASE_PARALLEL_FOR_HPP
+#define LIBBITCOIN_MVCC_DATABASE_PARALLEL_FOR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+
+#include <bitcoin/database/durability/thread_pool.hpp>
+
+namespace libbitcoin {
+namespace database {
+namespace durability {
+
+/// Split [0, count) into one contiguous range per thread and call
+/// work(begin, end) for each range. The calling thread and the shared
+/// thread_pool take ranges until none is left, so a call made from a
+/// pool worker completes even with every worker busy. Returns once
+/// every range is done.
+template <typename work_type>
+void parallel_for(size_t count, size_t threads, work_type work)
+{
+    struct job
+    {
+        std::atomic<size_t> next{ 0 };
+        size_t done = 0;
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+
+    if (count == 0)
+        return;
+
+    threads = std::max<size_t>(1, std::min(threads, count));
+    const auto step = (count + threads - 1) / threads;
+    const auto ranges = (count + step - 1) / step;
+
+    // Helpers may start after the last range is taken, they share the
+    // job but only touch work while a range is outstanding.
+    const auto state = std::make_shared<job>();
+    const auto take = [state, ranges, step, count, &work]()
+    {
+        size_t range;
+        while ((range = state->next++) < ranges)
+        {
+            const auto begin = range * step;
+            work(begin, std::min(count, begin + step));
+
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (++state->done == ranges)
+                state->finished.notify_one();
+        }
+    };
+
+    auto& pool = thread_pool::shared();
+    const auto helpers = std::min(ranges - 1, pool.size());
+    for (size_t helper = 0; helper < helpers; ++helper)
+        pool.post(take);
+
+    take();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&]()
+    {
+        return state->done == ranges;
+    });
+}
+
+} // namespace durability
+} // namespace database
+} // namespace libbitcoin
+
+#endif
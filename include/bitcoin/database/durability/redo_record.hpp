@@ -0,0 +1,152 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_MVCC_DATABASE_REDO_RECORD_HPP
+#define LIBBITCOIN_MVCC_DATABASE_REDO_RECORD_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include <bitcoin/system.hpp>
+#include <bitcoin/database/define.hpp>
+
+typedef uint64_t timestamp_t;
+
+namespace libbitcoin {
+namespace database {
+namespace durability {
+
+// Tables that write to the redo log.
+enum class table_id : uint8_t
+{
+    block = 0,
+    utxo = 1
+};
+
+// Logical operations recorded in the redo log. Values are absolute
+// (whole tuples and whole deltas), so replaying a record twice
+// leaves the same state as replaying it once.
+enum class redo_operation : uint8_t
+{
+    insert = 0,
+    update = 1
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Layout of a redo record in the log
+// table      1 byte
+// operation  1 byte
+// key size   2 bytes
+// value size 4 bytes
+// key        key size bytes
+// value      value size bytes
+///////////////////////////////////////////////////////////////////////////////
+
+const size_t redo_record_header_size = 8;
+
+/// A redo record as read back from the log. key and value point into
+/// the buffer the record was parsed from.
+struct redo_record
+{
+    table_id table;
+    redo_operation operation;
+    const uint8_t* key;
+    uint16_t key_size;
+    const uint8_t* value;
+    uint32_t value_size;
+
+    /// Copy the value into a trivially copyable tuple or delta.
+    template <typename value_type>
+    bool read_value(value_type& out) const
+    {
+        static_assert(std::is_trivially_copyable<value_type>::value,
+            "redo values are copied as bytes");
+
+        if (value_size != sizeof(value_type))
+            return false;
+
+        std::memcpy(&out, value, sizeof(value_type));
+        return true;
+    }
+};
+
+/// Serialize a redo record with a value of value_size bytes onto the
+/// end of buffer.
+template <typename key_type>
+void write_redo_record(system::data_chunk& buffer, table_id table,
+    redo_operation operation, const key_type& key, const uint8_t* value,
+    uint32_t value_size)
+{
+    static_assert(std::is_trivially_copyable<key_type>::value,
+        "redo keys are copied as bytes");
+
+    const uint16_t key_size = sizeof(key_type);
+
+    const auto start = buffer.size();
+    buffer.resize(start + redo_record_header_size + key_size + value_size);
+    auto out = buffer.data() + start;
+
+    out[0] = static_cast<uint8_t>(table);
+    out[1] = static_cast<uint8_t>(operation);
+    std::memcpy(out + 2, &key_size, sizeof(key_size));
+    std::memcpy(out + 4, &value_size, sizeof(value_size));
+    std::memcpy(out + redo_record_header_size, &key, key_size);
+    std::memcpy(out + redo_record_header_size + key_size, value, value_size);
+}
+
+/// Serialize a redo record onto the end of buffer.
+template <typename key_type, typename value_type>
+void write_redo_record(system::data_chunk& buffer, table_id table,
+    redo_operation operation, const key_type& key, const value_type& value)
+{
+    static_assert(std::is_trivially_copyable<value_type>::value,
+        "redo values are copied as bytes");
+
+    write_redo_record(buffer, table, operation, key,
+        reinterpret_cast<const uint8_t*>(&value), sizeof(value_type));
+}
+
+/// Parse the redo record at data, set size to the bytes it used.
+/// Returns false if the record does not fit in the available bytes.
+inline bool read_redo_record(const uint8_t* data, size_t available,
+    redo_record& out, size_t& size)
+{
+    if (available < redo_record_header_size)
+        return false;
+
+    out.table = static_cast<table_id>(data[0]);
+    out.operation = static_cast<redo_operation>(data[1]);
+    std::memcpy(&out.key_size, data + 2, sizeof(out.key_size));
+    std::memcpy(&out.value_size, data + 4, sizeof(out.value_size));
+
+    size = redo_record_header_size + out.key_size + out.value_size;
+    if (available < size)
+        return false;
+
+    out.key = data + redo_record_header_size;
+    out.value = out.key + out.key_size;
+    return true;
+}
+
+} // namespace durability
+} // namespace database
+} // namespace libbitcoin
+
+#endif
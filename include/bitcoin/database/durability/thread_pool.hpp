@@ -0,0 +1,72 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_MVCC_DATABASE_THREAD_POOL_HPP
+#define LIBBITCOIN_MVCC_DATABASE_THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <bitcoin/database/define.hpp>
+
+namespace libbitcoin {
+namespace database {
+namespace durability {
+
+/// Worker threads shared by every parallel_for of the process, so that
+/// repeated calls, such as bulk header stores, do not start threads
+/// each time. Started on first use, one worker fewer than the
+/// hardware threads as the caller of parallel_for works too.
+class BCD_API thread_pool
+{
+public:
+    static thread_pool& shared();
+
+    explicit thread_pool(size_t workers);
+
+    /// Finish the queued tasks and join the workers.
+    ~thread_pool();
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    /// Run task on a worker, in the order posted.
+    void post(std::function<void()> task);
+
+    size_t size() const;
+
+private:
+    void run();
+
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<std::function<void()>> tasks_;
+    bool stopped_;
+    std::vector<std::thread> workers_;
+};
+
+} // namespace durability
+} // namespace database
+} // namespace libbitcoin
+
+#endif
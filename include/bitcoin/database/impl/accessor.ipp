@@ -44,50 +44,43 @@ slot accessor<mvcc_tuple, mvcc_delta>::put(transaction_context& context,
     if (!record_ptr->install(context))
         return slot{};
 
-    context.register_commit_action([record_ptr, context]()
+    context.register_insert_action(record_ptr);
+    return record_slot;
+}
+
+template <typename mvcc_tuple, typename mvcc_delta>
+bool accessor<mvcc_tuple, mvcc_delta>::put(transaction_context& context,
+    const typename mvcc_tuple::tuple_type* tuples, size_t count, slot* slots)
+{
+    tuple_store_->insert(context, count, slots, [&](size_t index)
     {
-        // commit to context timestamp
-        record_ptr->commit(context, context.get_timestamp());
+        return mvcc_tuple{context, tuples[index]};
     });
 
-    auto end_ts = record_ptr->get_end_timestamp();
-    auto next = record_ptr->get_next();
-    context.register_abort_action([record_ptr, context, end_ts, next]()
+    for (size_t index = 0; index < count; ++index)
     {
-        // reset next
-        record_ptr->set_next(next);
-        // reset end timestamp and release latch, using commit
-        record_ptr->commit(context, end_ts);
-    });
-    return record_slot;
+        auto record_ptr = tuple_store_->get_bytes_at(slots[index]);
+        if (!record_ptr->install(context))
+            return false;
+
+        context.register_insert_action(record_ptr);
+    }
+
+    return true;
 }
 
 template <typename mvcc_tuple, typename mvcc_delta>
 bool accessor<mvcc_tuple, mvcc_delta>::insert_after_head(
     transaction_context& context, mvcc_tuple* head, mvcc_delta* delta_record)
 {
-    if (!head->install_next_version(delta_record, context))
-        return false;
-
-    context.register_commit_action([delta_record, head, context]()
-    {
-        // commit to infinity
-        delta_record->commit(context);
-
-        // commit to context
-        head->commit(context, context.get_timestamp());
-    });
-
+    // capture values before the install, abort restores them
     auto end_ts = head->get_end_timestamp();
     auto next = head->get_next();
-    context.register_abort_action([head, context, end_ts, next]()
-    {
-        // reset end timestamp and release latch, that is what commit
-        // does
-        head->set_next(next);
-        head->commit(context, end_ts);
-    });
 
+    if (!head->install_next_version(delta_record, context))
+        return false;
+
+    context.register_append_action(head, delta_record, end_ts, next);
     return true;
 }
 
@@ -95,28 +88,14 @@ template <typename mvcc_tuple, typename mvcc_delta>
 bool accessor<mvcc_tuple, mvcc_delta>::insert_after_tail(
     transaction_context& context, mvcc_delta* tail, mvcc_delta* delta_record)
 {
-    if (!tail->install_next_version(delta_record, context))
-        return false;
-
-    context.register_commit_action([delta_record, tail, context]()
-    {
-      // commit to infinity
-      delta_record->commit(context);
-
-      // commit to context
-      tail->commit(context, context.get_timestamp());
-    });
-
+    // capture values before the install, abort restores them
     auto end_ts = tail->get_end_timestamp();
     auto next = tail->get_next();
-    context.register_abort_action([tail, context, end_ts, next]()
-    {
-        // reset end timestamp and release latch, that is what commit
-        // does
-        tail->set_next(next);
-        tail->commit(context, end_ts);
-    });
 
+    if (!tail->install_next_version(delta_record, context))
+        return false;
+
+    context.register_append_action(tail, delta_record, end_ts, next);
     return true;
 }
 
@@ -154,6 +133,31 @@ accessor<mvcc_tuple, mvcc_delta>::get(transaction_context& context,
     return tuple_store_->read(from, context, reader);
 }
 
+template <typename mvcc_tuple, typename mvcc_delta>
+bool accessor<mvcc_tuple, mvcc_delta>::get(transaction_context& context,
+    const slot& from, typename mvcc_tuple::reader reader,
+    typename mvcc_tuple::tuple_type& out) const
+{
+    return tuple_store_->get_bytes_at(from)->read_record(context, reader,
+        out);
+}
+
+template <typename mvcc_tuple, typename mvcc_delta>
+void accessor<mvcc_tuple, mvcc_delta>::prefetch(const slot& at_slot,
+    bool deltas) const
+{
+    const auto record = tuple_store_->get_bytes_at(at_slot);
+    if (!deltas)
+    {
+        util::prefetch(record);
+        return;
+    }
+
+    const auto next = record->get_next();
+    if (next != mvcc_tuple::no_next)
+        util::prefetch(next);
+}
+
 } // namespace libbitcoin
 } // namespace database
 } // namespace mvto
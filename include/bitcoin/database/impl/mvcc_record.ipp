@@ -50,37 +50,26 @@ mvcc_record<tuple, delta>::mvcc_record(
 template <typename tuple, typename delta>
 mvcc_record<tuple, delta>::mvcc_record(
     const transaction_context& tx_context)
-    : read_timestamp_(none_read), begin_timestamp_(tx_context.get_timestamp()),
-      end_timestamp_(infinity), next_(no_next)
+    : mvcc_columns(tx_context)
 {
-    txn_id_.store(tx_context.get_timestamp());
+    next_ = no_next;
 }
 
 template <typename tuple, typename delta>
 mvcc_record<tuple, delta>::mvcc_record(
     const transaction_context& tx_context,
     typename mvcc_record<tuple, delta>::tuple_ptr data)
-    : read_timestamp_(none_read), begin_timestamp_(tx_context.get_timestamp()),
-      end_timestamp_(infinity), data_(*data), next_(no_next)
+    : mvcc_columns(tx_context), data_(*data)
 {
-    txn_id_.store(tx_context.get_timestamp());
+    next_ = no_next;
 }
 
 template <typename tuple, typename delta>
-bool mvcc_record<tuple, delta>::get_latch_for_write(
-    const transaction_context& context)
+mvcc_record<tuple, delta>::mvcc_record(
+    const transaction_context& tx_context, const tuple& data)
+    : mvcc_columns(tx_context), data_(data)
 {
-    auto old_tid = txn_id_.load();
-    auto tid = context.get_timestamp();
-
-    // already locked by tid
-    if (old_tid == tid)
-        return true;
-
-    // try to get the lock
-    auto unlatched = not_latched;
-    auto latched = txn_id_.compare_exchange_strong(unlatched, tid);
-    return latched;
+    next_ = no_next;
 }
 
 template <typename tuple, typename delta>
@@ -96,21 +85,6 @@ void mvcc_record<tuple, delta>::write_to(mvcc_record<tuple, delta>* to,
     to->next_ = next_;
 }
 
-template <typename tuple, typename delta>
-bool mvcc_record<tuple, delta>::release_latch(
-    const transaction_context& context)
-{
-    auto old_tid = txn_id_.load();
-    auto tid = context.get_timestamp();
-
-    // locked by tid, try to release the latch
-    if (old_tid == tid)
-        return txn_id_.compare_exchange_strong(tid, not_latched);
-
-    // Locked by another txn or already not_latched
-    return false;
-}
-
 template <typename tuple, typename delta>
 typename mvcc_record<tuple, delta>::delta_mvcc_record*
 mvcc_record<tuple, delta>::find_last_delta(
@@ -133,65 +107,59 @@ typename mvcc_record<tuple, delta>::tuple_ptr
 mvcc_record<tuple, delta>::read_record(
     const transaction_context &context, void (*reader)(tuple&, delta&))
 {
-    if (!is_visible(context) || !can_read(context))
+    tuple_ptr result = std::make_shared<tuple>();
+    if (!read_record(context, reader, *result))
         return not_found;
 
-    tuple_ptr result = std::make_shared<tuple>(data_);
-    set_read_timestamp(context);
+    return result;
+}
 
+template <typename tuple, typename delta>
+bool mvcc_record<tuple, delta>::read_record(
+    const transaction_context &context, void (*reader)(tuple&, delta&),
+    tuple& out)
+{
+    if (!is_visible(context) || !can_read(context))
+        return false;
+
+    out = data_;
+    set_read_timestamp(context);
 
     for (auto delta_record = begin(); delta_record != end(); ++delta_record) {
         if ((*delta_record)->is_visible(context) &&
             (*delta_record)->can_read(context))
         {
-            reader(*result, delta_record->get_data());
+            reader(out, delta_record->get_data());
             delta_record->set_read_timestamp(context);
         }
         else
-            return result;
+            return true;
     }
 
-    return result;
-}
-
-// Uses MVTO protocol
-template <typename tuple, typename delta>
-bool mvcc_record<tuple, delta>::can_read(
-    const transaction_context &context) const
-{
-    return read_timestamp_ <= context.get_timestamp();
+    return true;
 }
 
-// Uses MVTO protocol
 template <typename tuple, typename delta>
-bool mvcc_record<tuple, delta>::is_visible(
-    const transaction_context &context) const
+typename mvcc_record<tuple, delta>::tuple_ptr
+mvcc_record<tuple, delta>::read_snapshot(timestamp_t snapshot,
+    void (*reader)(tuple&, delta&))
 {
-    auto timestamp = context.get_timestamp();
-
-    // No write lock held by any other transaction
-    auto old_tid = txn_id_.load();
-    if (old_tid != not_latched && old_tid != timestamp)
-        return false;
+    if (!is_committed_at(snapshot))
+        return not_found;
 
-    // can't read if context.timestamp is less than begin ts
-    if (timestamp < begin_timestamp_)
-        return false;
+    tuple_ptr result = std::make_shared<tuple>(data_);
 
-    return true;
-}
+    // Deltas commit in chain order, stop at the first one that is
+    // not committed at snapshot.
+    for (auto delta_record = begin(); delta_record != end(); ++delta_record)
+    {
+        if (!(*delta_record)->is_committed_at(snapshot))
+            break;
 
-template <typename tuple, typename delta>
-bool mvcc_record<tuple, delta>::is_latched_by(
-    const transaction_context& context) const
-{
-    return txn_id_.load() == context.get_timestamp();
-}
+        reader(*result, delta_record->get_data());
+    }
 
-template <typename tuple, typename delta>
-timestamp_t mvcc_record<tuple, delta>::get_txn_id() const
-{
-    return txn_id_.load();
+    return result;
 }
 
 template <typename tuple, typename delta>
@@ -204,36 +172,6 @@ mvcc_record<tuple, delta>::allocate_next(
     return std::make_shared<delta_mvcc_record>(context);
 }
 
-template <typename tuple, typename delta>
-bool mvcc_record<tuple, delta>::install(
-    const transaction_context &context)
-{
-    if (!is_latched_by(context))
-        return false;
-
-    // set end ts
-    end_timestamp_ = context.get_timestamp();
-    return true;
-}
-
-template <typename tuple, typename delta>
-bool mvcc_record<tuple, delta>::commit(
-    const transaction_context &context)
-{
-    return commit(context, infinity);
-}
-
-template <typename tuple, typename delta>
-bool mvcc_record<tuple, delta>::commit(
-    const transaction_context &context, const timestamp_t ts)
-{
-    BITCOIN_ASSERT_MSG(!is_latched_by(context),
-        "Trying to install a version without latching it first");
-
-    end_timestamp_ = ts;
-    return release_latch(context);
-}
-
 template <typename tuple, typename delta>
 bool mvcc_record<tuple, delta>::install_next_version(
     delta_mvcc_record_ptr delta_record, const transaction_context& context)
@@ -264,7 +202,7 @@ template <typename tuple, typename delta>
 typename mvcc_record<tuple, delta>::iterator
 mvcc_record<tuple, delta>::begin() const
 {
-    return { next_ };
+    return { get_next() };
 }
 
 template <typename tuple, typename delta>
@@ -278,7 +216,8 @@ template <typename tuple, typename delta>
 typename mvcc_record<tuple, delta>::delta_mvcc_record*
 mvcc_record<tuple, delta>::get_next() const
 {
-    return next_;
+    // next_ always holds a delta record of this chain
+    return static_cast<delta_mvcc_record*>(next_);
 }
 
 template <typename tuple, typename delta>
@@ -293,37 +232,6 @@ void mvcc_record<tuple, delta>::set_next(delta_mvcc_record* next)
     next_ = next;
 }
 
-template <typename tuple, typename delta>
-mvcc_column mvcc_record<tuple, delta>::get_read_timestamp() const
-{
-    return read_timestamp_;
-}
-
-template <typename tuple, typename delta>
-void mvcc_record<tuple, delta>::set_read_timestamp(const transaction_context& context)
-{
-    if (read_timestamp_ < context.get_timestamp())
-        read_timestamp_ = context.get_timestamp();
-}
-
-template <typename tuple, typename delta>
-mvcc_column mvcc_record<tuple, delta>::get_begin_timestamp() const
-{
-    return begin_timestamp_;
-}
-
-template <typename tuple, typename delta>
-mvcc_column mvcc_record<tuple, delta>::get_end_timestamp() const
-{
-    return end_timestamp_;
-}
-
-template <typename tuple, typename delta>
-void mvcc_record<tuple, delta>::set_end_timestamp(const timestamp_t ts)
-{
-    end_timestamp_ = ts;
-}
-
 template <typename tuple, typename delta>
 tuple& mvcc_record<tuple, delta>::get_data()
 {
@@ -341,6 +249,17 @@ typedef mvcc_record<block_tuple_delta, block_tuple_delta> block_delta_mvcc_recor
 template class mvcc_record<block_tuple, block_tuple_delta>;
 typedef mvcc_record<block_tuple, block_tuple_delta> block_mvcc_record;
 
+// utxo delta tuple
+// 40 bytes from mvcc record, 1 from utxo_tuple_delta (padded
+// with 7 bytes)
+template class mvcc_record<utxo_tuple_delta, utxo_tuple_delta>;
+typedef mvcc_record<utxo_tuple_delta, utxo_tuple_delta> utxo_delta_mvcc_record;
+
+// utxo tuple wrapped in mvcc record
+// 40 bytes from mvcc record, 64 from utxo_tuple
+template class mvcc_record<utxo_tuple, utxo_tuple_delta>;
+typedef mvcc_record<utxo_tuple, utxo_tuple_delta> utxo_mvcc_record;
+
 } // database
 } // libbitcoin
 } // namespace tuples
@@ -30,14 +30,33 @@ namespace database {
 namespace storage {
 
 template <typename record>
-store<record>::store(const block_pool_ptr pool)
-    : block_pool_(pool)
+store<record>::store(const block_pool_ptr pool, uint32_t cold_size)
+    : block_pool_(pool), record_size_(sizeof(record)), num_slots_in_block_(0),
+      slots_offset_(0), cold_size_(cold_size), cold_offset_(0)
 {
     blocks_latch_ = std::make_shared<spinlatch>();
+    insert_head_latch_ = std::make_shared<spinlatch>();
     if (block_pool_ != nullptr)
     {
-        record_size_ = sizeof(record);
-        num_slots_in_block_ = BLOCK_SIZE / record_size_;
+        // Slots follow the insert head and the slot bitmap, both
+        // padded to 8 bytes so records stay aligned. Fit as many slots
+        // as leave room for their bitmap.
+        const auto slots_offset = [](uint32_t slots)
+        {
+            const uint32_t mask = sizeof(uint64_t) - 1;
+            return uint32_t(sizeof(uint64_t)) +
+                ((raw_bitmap::size_in_bytes(slots) + mask) & ~mask);
+        };
+
+        // The cold column of each slot follows all the records.
+        const auto slot_size = record_size_ + cold_size_;
+        num_slots_in_block_ = (BLOCK_SIZE - sizeof(uint64_t)) / slot_size;
+        while (slots_offset(num_slots_in_block_) +
+            num_slots_in_block_ * slot_size > BLOCK_SIZE)
+            --num_slots_in_block_;
+
+        slots_offset_ = slots_offset(num_slots_in_block_);
+        cold_offset_ = slots_offset_ + num_slots_in_block_ * record_size_;
         raw_block* new_block = get_new_block();
         // insert block
         blocks_.push_back(new_block);
@@ -151,17 +170,99 @@ slot store<record>::insert(transaction_context& context,
     return result;
 }
 
+template <typename record>
+template <typename factory>
+void store<record>::insert(transaction_context& context, size_t count,
+    slot* slots, factory make)
+{
+    BITCOIN_ASSERT_MSG(!context.is_committed(),
+        "Can't insert using a committed transaction");
+
+    size_t allocated = 0;
+    auto block = insertion_head_;
+
+    while (allocated < count)
+    {
+        if (block == blocks_.end())
+        {
+            raw_block *new_block = get_new_block();
+            [[maybe_unused]] const auto busy = new_block->set_busy_status();
+            BITCOIN_ASSERT_MSG(busy, "Status of new block should not be busy");
+
+            // take latch
+            scopedspinlatch guard(blocks_latch_);
+
+            // insert block
+            blocks_.push_back(new_block);
+            block = --blocks_.end();
+        }
+        else if (!(*block)->set_busy_status())
+        {
+            // The block is being inserted by other txn, try next block
+            ++block;
+            continue;
+        }
+
+        // Take as many slots as the batch needs from this block
+        while (allocated < count && allocate_in(*block, &slots[allocated]))
+            ++allocated;
+
+        (*block)->clear_busy_status();
+
+        if (allocated < count)
+        {
+            // The block is full, move the insertion_header past it
+            check_move_head(block);
+            ++block;
+        }
+    }
+
+    for (size_t index = 0; index < count; ++index)
+        insert_into(context, make(index), slots[index]);
+}
+
 template <typename record>
 record* store<record>::get_bytes_at(const slot& slot) const
 {
-    // skip the insert head to and slot bitmap
+    // skip the insert head and slot bitmap
     return reinterpret_cast<record *>(
         reinterpret_cast<uintptr_t>(slot.get_block())
-        + sizeof(uint32_t) // insert_head_
-        + sizeof(uint64_t) // slot bitmap
+        + slots_offset_
         + (slot.get_offset() * sizeof(record)));
 }
 
+template <typename record>
+template <typename column>
+column* store<record>::get_cold_at(const slot& slot) const
+{
+    BITCOIN_ASSERT_MSG(sizeof(column) <= cold_size_,
+        "Column must fit in the cold area of a slot.");
+
+    return reinterpret_cast<column *>(
+        reinterpret_cast<uintptr_t>(slot.get_block())
+        + cold_offset_
+        + (slot.get_offset() * cold_size_));
+}
+
+template <typename record>
+std::vector<raw_block*> store<record>::get_blocks() const
+{
+    scopedspinlatch guard(blocks_latch_);
+    return { blocks_.begin(), blocks_.end() };
+}
+
+template <typename record>
+template <typename handler>
+void store<record>::for_each_in(raw_block* block, handler visit) const
+{
+    const auto allocated = block->get_insert_head();
+    for (uint32_t offset = 0; offset < allocated; ++offset)
+    {
+        const slot at_slot{ block, offset };
+        visit(at_slot, get_bytes_at(at_slot));
+    }
+}
+
 template <typename record>
 bool store<record>::allocate_in(raw_block* block, slot* use_slot)
 {
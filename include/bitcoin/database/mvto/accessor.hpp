@@ -49,6 +49,11 @@ public:
     // Inserts a tuple into the store.
     slot put(transaction_context&, typename mvcc_tuple::tuple_ptr);
 
+    // Inserts count tuples into the store, setting slots to their
+    // locations. Returns false if any could not be installed.
+    bool put(transaction_context&, const typename mvcc_tuple::tuple_type*,
+        size_t count, slot* slots);
+
     // Write a delta record in the version chain pointed to by the
     // slot.
     bool update(transaction_context&, slot&, typename mvcc_tuple::delta_ptr);
@@ -58,6 +63,15 @@ public:
     typename mvcc_tuple::tuple_ptr get(transaction_context&, slot&,
         typename mvcc_tuple::reader) const;
 
+    // Same as above, reading into out. Returns false if no version
+    // is readable by the context.
+    bool get(transaction_context&, const slot&, typename mvcc_tuple::reader,
+        typename mvcc_tuple::tuple_type& out) const;
+
+    // Prefetch the record at slot, and its first delta if the record
+    // is already cached.
+    void prefetch(const slot&, bool deltas) const;
+
   private:
     bool insert_after_head(transaction_context&, mvcc_tuple*, mvcc_delta*);
     bool insert_after_tail(transaction_context&, mvcc_delta*, mvcc_delta*);
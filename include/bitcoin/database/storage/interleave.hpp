@@ -0,0 +1,81 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_MVCC_DATABASE_INTERLEAVE_HPP
+#define LIBBITCOIN_MVCC_DATABASE_INTERLEAVE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace libbitcoin {
+namespace database {
+namespace storage {
+
+/**
+ * Run count lookups on the calling thread, width of them in flight at
+ * once, so that the cache misses of one overlap with the work of the
+ * others.
+ *
+ * A lookup is a resumable state machine. start(index, lookup) resets
+ * lookup to begin lookup number index. lookup.step() runs it up to its
+ * next suspension point, prefetching what it reads next before it
+ * returns true, or returns false once the lookup is done. Lookups are
+ * stepped round robin, and a finished lookup's place is taken by the
+ * next one to start. A width of one runs them in sequence.
+ */
+template <typename lookup_type, typename start_type>
+void interleave(size_t count, size_t width, start_type start)
+{
+    if (count == 0)
+        return;
+
+    width = std::max<size_t>(1, std::min(width, count));
+
+    std::vector<lookup_type> lookups(width);
+    std::vector<uint8_t> running(width, 1);
+    for (size_t index = 0; index < width; ++index)
+        start(index, lookups[index]);
+
+    auto next = width;
+    auto active = width;
+    while (active != 0)
+    {
+        for (size_t index = 0; index < width; ++index)
+        {
+            if (running[index] == 0 || lookups[index].step())
+                continue;
+
+            if (next < count)
+            {
+                start(next++, lookups[index]);
+                continue;
+            }
+
+            running[index] = 0;
+            --active;
+        }
+    }
+}
+
+} // namespace storage
+} // namespace database
+} // namespace libbitcoin
+
+#endif
@@ -21,6 +21,7 @@
 #define LIBBITCOIN_MVCC_STORAGE_HPP
 
 #include <atomic>
+#include <vector>
 #include <bitcoin/system.hpp>
 
 #include <bitcoin/database/transaction_management/spinlatch.hpp>
@@ -45,9 +46,14 @@ public:
      * Constructs a new storage for the give type record, using the
      * given block_stre as the source of its storage blocks.
      *
+     * Each slot may have cold_size bytes of a cold column, kept
+     * apart from the records at the end of the block so scans over
+     * the records do not pull it into cache.
+     *
      * @param store the block store to use.
+     * @param cold_size bytes of cold column per slot.
      */
-    store(const block_pool_ptr store);
+    store(const block_pool_ptr store, uint32_t cold_size=0);
 
     /**
      * Destructs store, releases all its blocks to block pool
@@ -67,6 +73,20 @@ public:
      */
     slot insert(transaction_context&, const record &);
 
+    /**
+     * Inserts count records, filling each block it takes before
+     * moving on, so a batch pays for block selection once per block
+     * rather than once per record.
+     *
+     * @param count number of records
+     * @param slots set to the slot allocated for each record
+     * @param make make(index) returns the record to copy into slot
+     * index
+     */
+    template <typename factory>
+    void insert(transaction_context&, size_t count, slot* slots,
+        factory make);
+
     // Given a slot and a transaction context, read the entire version
     // chain, build the final state of the mvcc version chain into a
     // single mvcc record and return it. The record does not
@@ -78,6 +98,20 @@ public:
 
     record* get_bytes_at(const slot&) const;
 
+    // The cold column of the slot, column must fit in cold_size.
+    // Written once before the slot is published, and not versioned.
+    template <typename column>
+    column* get_cold_at(const slot&) const;
+
+    // Blocks in the store, in insertion order, for sequential scans.
+    std::vector<raw_block*> get_blocks() const;
+
+    // Call handler(slot, record*) for every slot allocated so far in
+    // block. A slot may be allocated before its record is written,
+    // handler must check the record's timestamps.
+    template <typename handler>
+    void for_each_in(raw_block*, handler) const;
+
 private:
 
     // get a new block from block pool
@@ -109,6 +143,13 @@ private:
 
     uint32_t record_size_;
     uint32_t num_slots_in_block_;
+
+    // offset of the first slot from the start of a block
+    uint32_t slots_offset_;
+
+    // size of, and offset to, the cold column of the slots
+    uint32_t cold_size_;
+    uint32_t cold_offset_;
 };
 
 } // namespace storage
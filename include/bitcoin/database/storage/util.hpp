@@ -50,6 +50,17 @@ public:
    * @return modified version of address padded to align to word_size
    */
   uint32_t pad_upto_size(const uint8_t, const uint32_t);
+
+  /**
+   * Hint that the cache line holding address will be read soon.
+   * @param address the address to prefetch
+   */
+  static inline void prefetch(const void* address)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+      __builtin_prefetch(address, 0, 3);
+#endif
+  }
 };
 
 } // namespace storage
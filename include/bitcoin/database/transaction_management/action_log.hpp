@@ -0,0 +1,108 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_DATABASE_ACTION_LOG_HPP
+#define LIBBITCOIN_DATABASE_ACTION_LOG_HPP
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <bitcoin/database/define.hpp>
+
+typedef uint64_t timestamp_t;
+
+namespace libbitcoin {
+namespace database {
+
+namespace tuples {
+class mvcc_columns;
+}
+
+// The kind of write a transaction made to a version chain.
+enum class action_type : uint8_t
+{
+    // A new master record, installed into a store.
+    insert,
+
+    // A delta version appended after the master record or the
+    // current tail of the version chain.
+    append
+};
+
+/// A typed entry in the undo/commit log of a transaction.
+///
+/// record is the version latched by the transaction, that is, the
+/// inserted record or the version the delta was appended to. next
+/// is the delta version installed by an append.
+///
+/// old_end_timestamp and old_next hold the values of record before
+/// the transaction wrote to it, so an abort can restore them.
+struct version_action
+{
+    tuples::mvcc_columns* record;
+    tuples::mvcc_columns* next;
+    tuples::mvcc_columns* old_next;
+    timestamp_t old_end_timestamp;
+    action_type type;
+};
+
+/// action_log holds the version actions of a transaction in an
+/// arena owned by the transaction. The first inline_capacity entries
+/// are stored inline, so small transactions never allocate. Larger
+/// transactions grow the arena a chunk at a time, entries are never
+/// moved once written.
+class BCD_API action_log
+{
+public:
+    static const size_t inline_capacity = 16;
+    static const size_t chunk_capacity = 256;
+
+    action_log();
+
+    action_log(const action_log&);
+    action_log& operator=(const action_log&);
+
+    action_log(action_log&&) = default;
+    action_log& operator=(action_log&&) = default;
+
+    void push_back(const version_action&);
+
+    size_t size() const;
+
+    bool empty() const;
+
+    void clear();
+
+    version_action& operator[](size_t);
+
+    const version_action& operator[](size_t) const;
+
+private:
+    typedef std::array<version_action, chunk_capacity> chunk;
+
+    std::array<version_action, inline_capacity> inline_;
+    std::vector<std::unique_ptr<chunk>> chunks_;
+    size_t size_;
+};
+
+} // namespace database
+} // namespace libbitcoin
+
+#endif
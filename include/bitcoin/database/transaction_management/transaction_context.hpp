@@ -23,12 +23,18 @@
 
 #include <bitcoin/system.hpp>
 #include <bitcoin/database/define.hpp>
+#include <bitcoin/database/durability/redo_record.hpp>
+#include <bitcoin/database/transaction_management/action_log.hpp>
 
 typedef uint64_t timestamp_t;
 
 namespace libbitcoin {
 namespace database {
 
+namespace durability {
+class log_manager;
+}
+
 // transaction states, for now, active and committed are place
 // holders.
 enum class state
@@ -49,14 +55,59 @@ public:
     /// Constructor
     transaction_context(timestamp_t timestamp, state state);
 
-    /// Commit the transaction, calling all commit transaction functions
-    /// registered
+    /// Constructor for a transaction that writes redo records to log.
+    transaction_context(timestamp_t timestamp, state state,
+        durability::log_manager* log);
+
+    /// Commit the transaction, committing all versions in the action
+    /// log and then calling all commit transaction functions
+    /// registered.
+    /// The redo records of the transaction are appended to the log
+    /// before any version is released, and commit waits for them to
+    /// be durable if the log is synchronous. Returns false if the log
+    /// has failed, the versions are installed but not durable.
     bool commit();
 
-    /// Abort the transaction, calling all abort transaction functions
-    /// registered
+    /// Abort the transaction, undoing all versions in the action log
+    /// in reverse order and then calling all abort transaction
+    /// functions registered
     bool abort();
 
+    // Record an installed master record. On commit the record is
+    // released, on abort it is released to begin at infinity, so no
+    // one can read it.
+    void register_insert_action(tuples::mvcc_columns* record);
+
+    // Record a delta version appended after record. end_timestamp
+    // and next are the values of record before the append, and are
+    // restored on abort.
+    void register_append_action(tuples::mvcc_columns* record,
+        tuples::mvcc_columns* appended, timestamp_t end_timestamp,
+        tuples::mvcc_columns* next);
+
+    // Record a logical redo record, written to the log on commit.
+    // Does nothing for a transaction without a log.
+    template <typename key_type, typename value_type>
+    void register_redo(durability::table_id table,
+        durability::redo_operation operation, const key_type& key,
+        const value_type& value)
+    {
+        if (log_ != nullptr)
+            durability::write_redo_record(redo_, table, operation, key,
+                value);
+    }
+
+    // As above, with a value of value_size bytes.
+    template <typename key_type>
+    void register_redo(durability::table_id table,
+        durability::redo_operation operation, const key_type& key,
+        const uint8_t* value, uint32_t value_size)
+    {
+        if (log_ != nullptr)
+            durability::write_redo_record(redo_, table, operation, key,
+                value, value_size);
+    }
+
     // Actions to execute when transaction commits
     void register_commit_action(const transaction_end_action&);
 
@@ -75,6 +126,14 @@ private:
     timestamp_t timestamp_;
     state state_;
 
+    // Typed log of version writes, replayed without type erasure.
+    action_log actions_;
+
+    // Redo records of this transaction, serialized in log format.
+    durability::log_manager* log_;
+    system::data_chunk redo_;
+
+    // Generic actions for anything that is not a version write.
     std::forward_list<transaction_end_action> commit_actions_;
     std::forward_list<transaction_end_action> abort_actions_;
 };
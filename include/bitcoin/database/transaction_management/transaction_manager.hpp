@@ -23,6 +23,7 @@
 #include <bitcoin/database/define.hpp>
 #include <bitcoin/system.hpp>
 
+#include <bitcoin/database/durability/log_manager.hpp>
 #include <bitcoin/database/transaction_management/spinlatch.hpp>
 #include <bitcoin/database/transaction_management/transaction_context.hpp>
 #include <bitcoin/database/tuples/mvcc_record.hpp>
@@ -50,6 +51,9 @@ public:
     /// Constructor
     transaction_manager();
 
+    /// Constructor, transactions write their redo records to log.
+    transaction_manager(durability::log_manager_ptr log);
+
     /// Begin a transaction. Caller synchronously waits for a
     /// transaction_context.
     transaction_context begin_transaction();
@@ -57,14 +61,22 @@ public:
     /// Commit transaction. Transaction context is released.
     /// Global state transaction table entry for this context
     /// is removed.
-    void commit_transaction(transaction_context& context) const;
+    /// Returns false if the redo log has failed or is closed, the
+    /// versions are installed but the commit is not durable.
+    bool commit_transaction(transaction_context& context) const;
 
     void remove_transaction(const transaction_context& context);
 
     bool is_active(const transaction_context& context) const;
 
+    /// The timestamp of the oldest transaction not yet removed, or of
+    /// the next transaction to begin if there is none. No transaction
+    /// reads a snapshot older than this.
+    timestamp_t oldest_active() const;
+
 private:
     std::shared_ptr<spinlatch> latch_;
+    durability::log_manager_ptr log_;
 
     /// TODO: time_ needs to wrap around. We need to handle that when we get
     // to concurrency control protocols that depend on these timestamps.
@@ -0,0 +1,130 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBBITCOIN_MVCC_DATABASE_MVCC_COLUMNS_HPP
+#define LIBBITCOIN_MVCC_DATABASE_MVCC_COLUMNS_HPP
+
+#include <atomic>
+
+#include <bitcoin/database/define.hpp>
+#include <bitcoin/database/transaction_management/transaction_context.hpp>
+
+namespace libbitcoin {
+namespace database {
+namespace tuples {
+
+typedef uint64_t mvcc_column;
+
+// Define infinity to be -1. Might have to change this.
+const uint64_t infinity = -1;
+
+// not_latched used as the sentinel to mark record is not latched.
+
+const uint64_t not_latched = 0;
+
+// No one has read this version yet.
+const uint64_t none_read = 0;
+
+// MVCC columns shared by every mvcc_record, independent of the tuple
+// type. Keeping these in a non template base lets the transaction
+// action log commit and undo versions of any table without knowing
+// the tuple type.
+//
+// The layout is the same for all records, the tuple data follows
+// these columns.
+class BCD_API mvcc_columns {
+public:
+    // Get a latch on the record
+    // TODO - do we need to specify memory order?
+    bool get_latch_for_write(const transaction_context&);
+
+    // release the latch on this record
+    bool release_latch(const transaction_context&);
+
+    // returns true if this tuple is latched by context
+    bool is_latched_by(const transaction_context&) const;
+
+    timestamp_t get_txn_id() const;
+
+    // install this version, return true on success.
+    bool install(const transaction_context&);
+
+    // commit releases latch and sets timestamp
+    bool commit(const transaction_context&, const timestamp_t);
+
+    // commit releases latch and sets timestamp to context's ts
+    bool commit(const transaction_context&);
+
+    // abort releases the latch of an aborted insert, which begins at
+    // infinity so that no transaction reads it
+    bool abort(const transaction_context&);
+
+    // returns true if this tuple is visible to transaction
+    bool is_visible(const transaction_context&) const;
+
+    // returns true if this tuple can be read by this transaction
+    // check for visibility is separate
+    bool can_read(const transaction_context&) const;
+
+    // returns true if the version was written by a transaction that
+    // began at or before snapshot and has committed.
+    bool is_committed_at(timestamp_t snapshot) const;
+
+    mvcc_column get_read_timestamp() const;
+
+    void set_read_timestamp(const transaction_context&);
+
+    mvcc_column get_begin_timestamp() const;
+
+    mvcc_column get_end_timestamp() const;
+
+    void set_end_timestamp(const timestamp_t);
+
+    // untyped access to the version chain, used by the action log
+    mvcc_columns* get_next_version() const;
+
+    void set_next_version(mvcc_columns*);
+
+protected:
+    mvcc_columns() = default;
+
+    mvcc_columns(const transaction_context&);
+
+    // Compare and swap on txn_id_ "installs" the new version
+    // txn_id_ acts as a local latch on this record.
+    std::atomic<timestamp_t> txn_id_;
+
+    // read_timestamp_ tracks the largest timestamp of transactions
+    // reading from the record
+    mvcc_column read_timestamp_;
+
+    // begin and end timestamps determine which transactions can read
+    // this version
+    mvcc_column begin_timestamp_;
+    mvcc_column end_timestamp_;
+
+    // next_ points to the next version
+    mvcc_columns* next_;
+};
+
+} // namespace tuples
+} // namespace database
+} // namespace libbitcoin
+
+#endif
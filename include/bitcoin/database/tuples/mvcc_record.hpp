@@ -27,31 +27,24 @@
 #include <bitcoin/database/tuples/block_tuple.hpp>
 #include <bitcoin/database/tuples/block_tuple_delta.hpp>
 #include <bitcoin/database/tuples/delta_iterator.hpp>
+#include <bitcoin/database/tuples/mvcc_columns.hpp>
+#include <bitcoin/database/tuples/utxo_tuple.hpp>
+#include <bitcoin/database/tuples/utxo_tuple_delta.hpp>
 
 namespace libbitcoin {
 namespace database {
 namespace tuples {
 
-typedef uint64_t mvcc_column;
-
-// Define infinity to be -1. Might have to change this.
-const uint64_t infinity = -1;
-
-// not_latched used as the sentinel to mark record is not latched.
-
-const uint64_t not_latched = 0;
-
-// No one has read this version yet.
-const uint64_t none_read = 0;
-
 // Template for providing MVCC record keeping for tuple
 // Each record containts MVCC data and a pointed to next
 // version record.
 // tuple is block_tuple, utxo_tuple, etc.
 // delta is the equivalent delta data struct.
+// The MVCC columns are in the mvcc_columns base, data follows them.
 template <typename tuple, typename delta>
-class mvcc_record {
+class mvcc_record : public mvcc_columns {
 public:
+    typedef tuple tuple_type;
     typedef std::shared_ptr<tuple> tuple_ptr;
     typedef std::shared_ptr<const tuple> const_tuple_ptr;
     typedef std::shared_ptr<delta> delta_ptr;
@@ -76,12 +69,24 @@ public:
     // sets the data
     mvcc_record(const transaction_context&, tuple_ptr);
 
+    // sets the data, without a shared tuple
+    mvcc_record(const transaction_context&, const tuple&);
+
     // Return a tuple with attributes set from the delta records.
     // Finds version that is readable by context and sets
     // the value appropriate in tuple. If can't read any version, then
     // returns nullptr - the caller should check for this.
     tuple_ptr read_record(const transaction_context&, reader);
 
+    // Same as above, reading into out instead of allocating a tuple.
+    // Returns false if no version is readable by context.
+    bool read_record(const transaction_context&, reader, tuple& out);
+
+    // Return the tuple as committed at snapshot timestamp, or
+    // not_found. Does not set read timestamps or check latches held
+    // by writers, so writers never wait or abort for the snapshot.
+    tuple_ptr read_snapshot(timestamp_t snapshot, reader);
+
     // bool insert_delta(const transaction_context&, delta_mvcc_record*);
 
     // sets up a new version using the transaction context and the
@@ -99,9 +104,6 @@ public:
     // Does not install the allocated record.
     delta_mvcc_record_ptr allocate_next(const transaction_context&);
 
-    // install this version, return true on success.
-    bool install(const transaction_context&);
-
     // install the next record from this version, return true on
     // success. The new version or this are not committed, i.e. the
     // latches are still acquired by current txn.
@@ -110,36 +112,6 @@ public:
     // overloaded to work with naked pointer to memory in block object pool
     bool install_next_version(delta_mvcc_record*, const transaction_context&);
 
-    // commit releases latch and sets timestamp
-    bool commit(const transaction_context&, const timestamp_t);
-
-    // commit releases latch and sets timestamp to context's ts
-    bool commit(const transaction_context&);
-
-    // Get a latch on the record
-    // TODO - do we need to specify memory order?
-    bool get_latch_for_write(const transaction_context&);
-
-    // release the latch on this record
-    bool release_latch(const transaction_context&);
-
-    // returns true if this tuple is visible to transaction
-    bool is_visible(const transaction_context&) const;
-
-    // returns true if this tuple can be read by this transaction
-    // check for visibility is separate
-    bool can_read(const transaction_context&) const;
-
-    mvcc_column get_read_timestamp() const;
-
-    void set_read_timestamp(const transaction_context&);
-
-    mvcc_column get_begin_timestamp() const;
-
-    mvcc_column get_end_timestamp() const;
-
-    void set_end_timestamp(const timestamp_t);
-
     tuple& get_data();
 
     delta_mvcc_record* get_next() const;
@@ -156,35 +128,14 @@ public:
     // copies all the data fields to destination
     void write_to(mvcc_record<tuple, delta>*, const transaction_context&) const;
 
-    // returns true if this tuple is latched by context
-    bool is_latched_by(const transaction_context&) const;
-
-    timestamp_t get_txn_id() const;
-
     // Find last version to append new version to
     // Used by update.
     // Returns not_found if there is a conflict
     delta_mvcc_record* find_last_delta(const transaction_context&);
 
 private:
-    // Compare and swap on txn_id_ "installs" the new version
-    // txn_id_ acts as a local latch on this record.
-    std::atomic<timestamp_t> txn_id_;
-
-    // read_timestamp_ tracks the largest timestamp of transactions
-    // reading from the record
-    mvcc_column read_timestamp_;
-
-    // begin and end timestamps determine which transactions can read
-    // this version
-    mvcc_column begin_timestamp_;
-    mvcc_column end_timestamp_;
-
     // data is the tuple being wrapped in mvcc
     tuple data_;
-
-    // next_ points to the next version
-    delta_mvcc_record* next_;
 };
 
 } // namespace tuples
@@ -0,0 +1,89 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBBITCOIN_MVCC_DATABASE_UTXO_TUPLE_HPP
+#define LIBBITCOIN_MVCC_DATABASE_UTXO_TUPLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <bitcoin/system.hpp>
+#include <bitcoin/database/define.hpp>
+#include <bitcoin/database/tuples/utxo_tuple_delta.hpp>
+
+namespace libbitcoin {
+namespace database {
+namespace tuples {
+
+using namespace system;
+
+/*
+ * Struct to hold an output in memory, without its outpoint.
+ * Attributes ordered for alignment, the inline script fills the tuple
+ * to 64 bytes.
+ *
+ * Standard output scripts (p2pkh, p2sh, p2wpkh, p2wsh, p2tr and
+ * compressed p2pk) are at most 35 bytes and are kept inline. Longer
+ * scripts are kept by the database, script_size is still set.
+ */
+class utxo_tuple {
+public:
+
+    static const uint32_t not_found = -1;
+
+    static const size_t script_capacity = 47;
+
+    // states
+    static const uint8_t unspent = 0;
+    static const uint8_t spent = 1;
+
+    utxo_tuple();
+
+    operator bool() const;
+
+    /// The script is in the tuple.
+    bool is_inline() const;
+
+    static void read_from_delta(utxo_tuple&, utxo_tuple_delta&);
+
+    static void write_to_delta(const utxo_tuple&, utxo_tuple_delta&);
+
+//-------------------------------------------------------------
+// data stored
+
+    // 8 bytes
+    uint64_t value;
+    // 4 bytes
+    uint32_t height;
+    // 4 bytes
+    uint32_t script_size;
+    // 1 byte
+    uint8_t state;
+    // 47 bytes
+    uint8_t script[script_capacity];
+};
+
+typedef std::shared_ptr<utxo_tuple> utxo_tuple_ptr;
+
+} // namespace tuples
+} // namespace database
+} // namespace libbitcoin
+
+#endif
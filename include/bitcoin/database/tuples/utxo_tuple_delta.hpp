@@ -0,0 +1,66 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBBITCOIN_MVCC_DATABASE_UTXO_TUPLE_DELTA_HPP
+#define LIBBITCOIN_MVCC_DATABASE_UTXO_TUPLE_DELTA_HPP
+
+#include <cstdint>
+#include <memory>
+
+#include <bitcoin/database/define.hpp>
+
+namespace libbitcoin {
+namespace database {
+namespace tuples {
+
+/*
+ * The only value of an output that changes is whether it is spent, so
+ * a spend is recorded as a delta of the state alone.
+ */
+class alignas(8) utxo_tuple_delta {
+public:
+    // 1 byte
+    uint8_t state;
+
+    static const uint8_t not_found_ = -1;
+
+    utxo_tuple_delta()
+      : state(not_found_)
+    {
+    }
+
+    bool operator==(utxo_tuple_delta& other)
+    {
+        return state == other.state;
+    }
+
+    bool operator!=(utxo_tuple_delta& other)
+    {
+        return state != other.state;
+    }
+
+};
+
+typedef std::shared_ptr<utxo_tuple_delta> utxo_delta_ptr;
+
+} // namespace tuples
+} // namespace database
+} // namespace libbitcoin
+
+#endif
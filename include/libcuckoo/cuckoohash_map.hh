@@ -585,6 +585,35 @@ public:
     return find_fn(key, [&val](const mapped_type &v) mutable { val = v; });
   }
 
+  /** Hints that @p key will be looked up soon, prefetching the locks and
+   * the two buckets a lookup would read. It takes no locks, so if the
+   * table is resized meanwhile it may prefetch the wrong lines.
+   *
+   * @tparam K type of the key
+   * @param key the key that will be looked up
+   */
+  template <typename K> void prefetch(const K &key) const {
+#if defined(__GNUC__) || defined(__clang__)
+    const hash_value hv = hashed_key(key);
+    const size_type hp = hashpower();
+    const size_type i1 = index_hash(hp, hv.hash);
+    const size_type i2 = alt_index(hp, hv.partial, i1);
+    const locks_t &locks = get_current_locks();
+    __builtin_prefetch(&locks[lock_ind(i1)], 0, 3);
+    __builtin_prefetch(&locks[lock_ind(i2)], 0, 3);
+    // a bucket may span more than one cache line
+    const auto b1 = reinterpret_cast<const char *>(&buckets_[i1]);
+    const auto b2 = reinterpret_cast<const char *>(&buckets_[i2]);
+    for (size_type line = 0; line < sizeof(typename buckets_t::bucket);
+         line += 64) {
+      __builtin_prefetch(b1 + line, 0, 3);
+      __builtin_prefetch(b2 + line, 0, 3);
+    }
+#else
+    static_cast<void>(key);
+#endif
+  }
+
   /** Searches the table for @p key, and returns the associated value it
    * finds. @c mapped_type must be @c CopyConstructible.
    *
@@ -0,0 +1,1110 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/database/container/art_index.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <tuple>
+
+#include <bitcoin/database/storage/util.hpp>
+
+namespace libbitcoin {
+namespace database {
+namespace container {
+
+using namespace bc::system;
+
+static_assert(sizeof(uintptr_t) == sizeof(uint64_t),
+    "Leaves are tagged in bit 63.");
+static_assert(sizeof(slot) == sizeof(uintptr_t),
+    "A leaf holds a slot in one word.");
+
+static const size_t key_size = std::tuple_size<hash_digest>::value;
+
+// Prefix bytes kept in the node, the rest are read from a leaf.
+static const size_t stored_prefix = sizeof(uint64_t);
+
+// A child is a node pointer, or a slot tagged in the high bit, which
+// user space pointers never set. Zero is no child.
+static const uintptr_t leaf_flag = uintptr_t(1) << 63;
+
+static bool is_leaf(uintptr_t child)
+{
+    return (child & leaf_flag) != 0;
+}
+
+static uintptr_t to_leaf(const slot& value)
+{
+    uintptr_t bytes;
+    std::memcpy(&bytes, &value, sizeof(bytes));
+    return bytes | leaf_flag;
+}
+
+static slot to_slot(uintptr_t leaf)
+{
+    const auto bytes = leaf & ~leaf_flag;
+    slot value;
+    std::memcpy(static_cast<void*>(&value), &bytes, sizeof(value));
+    return value;
+}
+
+// Byte i of the prefix is at bits 8i.
+static uint64_t pack(const uint8_t* bytes, size_t count)
+{
+    uint64_t packed = 0;
+    for (size_t byte = 0; byte < std::min(count, stored_prefix); ++byte)
+        packed |= uint64_t(bytes[byte]) << (8 * byte);
+
+    return packed;
+}
+
+enum class kind : uint8_t
+{
+    node4,
+    node16,
+    node48,
+    node256
+};
+
+// Nodes
+// ----------------------------------------------------------------------------
+// Every field is atomic because readers read nodes while a writer may
+// change them, the version tells readers whether what they read holds.
+
+struct art_index::node
+{
+    template <size_t Capacity>
+    struct small;
+    struct indirect;
+    struct direct;
+
+    typedef small<4> node4;
+    typedef small<16> node16;
+    typedef indirect node48;
+    typedef direct node256;
+
+    node(kind type)
+      : version(0), type(type), count(0), prefix_length(0), prefix(0)
+    {
+    }
+
+    // The version is a counter above an obsolete bit 0 and a lock
+    // bit 1.
+    bool read_lock(uint64_t& out) const
+    {
+        out = version.load(std::memory_order_acquire);
+        return (out & 3) == 0;
+    }
+
+    bool validate(uint64_t expected) const
+    {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return version.load(std::memory_order_relaxed) == expected;
+    }
+
+    // Lock for writing if unchanged since read_lock returned expected.
+    bool upgrade(uint64_t expected)
+    {
+        if (!version.compare_exchange_strong(expected, expected + 2,
+            std::memory_order_acquire, std::memory_order_relaxed))
+            return false;
+
+        std::atomic_thread_fence(std::memory_order_release);
+        return true;
+    }
+
+    // Lock for writing, false if the node was replaced.
+    bool lock()
+    {
+        while (true)
+        {
+            const auto current = version.load(std::memory_order_acquire);
+            if ((current & 1) != 0)
+                return false;
+
+            if ((current & 2) == 0 && upgrade(current))
+                return true;
+        }
+    }
+
+    void unlock()
+    {
+        version.fetch_add(2, std::memory_order_release);
+    }
+
+    void unlock_obsolete()
+    {
+        version.fetch_add(3, std::memory_order_release);
+    }
+
+    uint8_t prefix_at(size_t position) const
+    {
+        return uint8_t(prefix.load(std::memory_order_relaxed) >>
+            (8 * position));
+    }
+
+    void set_prefix(uint64_t packed, size_t length)
+    {
+        prefix.store(packed, std::memory_order_relaxed);
+        prefix_length.store(static_cast<uint32_t>(length),
+            std::memory_order_relaxed);
+    }
+
+    // Put the prefix of above and key before this prefix, when above
+    // is removed from between this node and its parent.
+    void prepend_prefix(const node* above, uint8_t key)
+    {
+        const auto above_length = above->prefix_length.load(
+            std::memory_order_relaxed);
+        const auto length = prefix_length.load(std::memory_order_relaxed);
+
+        uint8_t bytes[2 * stored_prefix + 1];
+        size_t used = 0;
+        for (size_t position = 0;
+            position < std::min<size_t>(above_length, stored_prefix);
+            ++position)
+            bytes[used++] = above->prefix_at(position);
+
+        bytes[used++] = key;
+        for (size_t position = 0;
+            position < std::min<size_t>(length, stored_prefix); ++position)
+            bytes[used++] = prefix_at(position);
+
+        set_prefix(pack(bytes, used), above_length + 1 + length);
+    }
+
+    size_t child_count() const
+    {
+        return count.load(std::memory_order_relaxed);
+    }
+
+    uintptr_t find(uint8_t key) const;
+    bool full() const;
+    bool underfull() const;
+    void add(uint8_t key, uintptr_t child);
+    void change(uint8_t key, uintptr_t child);
+    void remove(uint8_t key);
+    uintptr_t any_child() const;
+    uintptr_t other_child(uint8_t key, uint8_t& other_key) const;
+    node* resize(kind type) const;
+
+    template <typename visitor>
+    void for_each(visitor visit) const;
+
+    static node* create(kind type);
+    static void destroy(node* target);
+
+    static node* from_child(uintptr_t child)
+    {
+        return reinterpret_cast<node*>(child);
+    }
+
+    uintptr_t to_child() const
+    {
+        return reinterpret_cast<uintptr_t>(this);
+    }
+
+    // Calls function with the node cast to its type.
+    template <typename function>
+    static auto dispatch(const node* target, function call);
+
+    template <typename function>
+    static auto dispatch(node* target, function call);
+
+    std::atomic<uint64_t> version;
+    const kind type;
+    std::atomic<uint16_t> count;
+    std::atomic<uint32_t> prefix_length;
+    std::atomic<uint64_t> prefix;
+};
+
+// 4 or 16 children, keys unsorted and searched in order.
+template <size_t Capacity>
+struct art_index::node::small
+  : art_index::node
+{
+    small(kind type)
+      : node(type)
+    {
+        for (size_t position = 0; position < Capacity; ++position)
+        {
+            keys[position].store(0, std::memory_order_relaxed);
+            children[position].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    size_t used() const
+    {
+        return std::min(child_count(), Capacity);
+    }
+
+    uintptr_t find(uint8_t key) const
+    {
+        for (size_t position = 0; position < used(); ++position)
+            if (keys[position].load(std::memory_order_relaxed) == key)
+                return children[position].load(std::memory_order_acquire);
+
+        return 0;
+    }
+
+    void add(uint8_t key, uintptr_t child)
+    {
+        const auto position = child_count();
+        keys[position].store(key, std::memory_order_relaxed);
+        children[position].store(child, std::memory_order_release);
+        count.store(uint16_t(position + 1), std::memory_order_release);
+    }
+
+    void change(uint8_t key, uintptr_t child)
+    {
+        for (size_t position = 0; position < used(); ++position)
+            if (keys[position].load(std::memory_order_relaxed) == key)
+                children[position].store(child, std::memory_order_release);
+    }
+
+    // Moves the last child into the gap.
+    void remove(uint8_t key)
+    {
+        const auto last = used() - 1;
+        for (size_t position = 0; position <= last; ++position)
+        {
+            if (keys[position].load(std::memory_order_relaxed) != key)
+                continue;
+
+            keys[position].store(keys[last].load(std::memory_order_relaxed),
+                std::memory_order_relaxed);
+            children[position].store(children[last].load(
+                std::memory_order_relaxed), std::memory_order_release);
+            count.store(uint16_t(last), std::memory_order_release);
+            return;
+        }
+    }
+
+    template <typename visitor>
+    void for_each(visitor visit) const
+    {
+        for (size_t position = 0; position < used(); ++position)
+            visit(keys[position].load(std::memory_order_relaxed),
+                children[position].load(std::memory_order_acquire));
+    }
+
+    std::atomic<uint8_t> keys[Capacity];
+    std::atomic<uintptr_t> children[Capacity];
+};
+
+// 48 children, found through a 256 entry table of positions.
+struct art_index::node::indirect
+  : art_index::node
+{
+    static const size_t capacity = 48;
+
+    indirect()
+      : node(kind::node48)
+    {
+        for (auto& position: positions)
+            position.store(0, std::memory_order_relaxed);
+
+        for (auto& child: children)
+            child.store(0, std::memory_order_relaxed);
+    }
+
+    // Positions are one based, zero is no child.
+    uintptr_t find(uint8_t key) const
+    {
+        const auto position = positions[key].load(std::memory_order_relaxed);
+        return position == 0 ? 0 :
+            children[position - 1].load(std::memory_order_acquire);
+    }
+
+    void add(uint8_t key, uintptr_t child)
+    {
+        size_t position = child_count();
+        if (children[position].load(std::memory_order_relaxed) != 0)
+            for (position = 0; children[position].load(
+                std::memory_order_relaxed) != 0; ++position);
+
+        children[position].store(child, std::memory_order_release);
+        positions[key].store(uint8_t(position + 1), std::memory_order_release);
+        count.fetch_add(1, std::memory_order_release);
+    }
+
+    void change(uint8_t key, uintptr_t child)
+    {
+        const auto position = positions[key].load(std::memory_order_relaxed);
+        children[position - 1].store(child, std::memory_order_release);
+    }
+
+    void remove(uint8_t key)
+    {
+        const auto position = positions[key].load(std::memory_order_relaxed);
+        children[position - 1].store(0, std::memory_order_release);
+        positions[key].store(0, std::memory_order_release);
+        count.fetch_sub(1, std::memory_order_release);
+    }
+
+    template <typename visitor>
+    void for_each(visitor visit) const
+    {
+        for (size_t key = 0; key < 256; ++key)
+        {
+            const auto position = positions[key].load(
+                std::memory_order_relaxed);
+            if (position != 0)
+                visit(uint8_t(key), children[position - 1].load(
+                    std::memory_order_acquire));
+        }
+    }
+
+    std::atomic<uint8_t> positions[256];
+    std::atomic<uintptr_t> children[capacity];
+};
+
+// 256 children, indexed by key.
+struct art_index::node::direct
+  : art_index::node
+{
+    direct()
+      : node(kind::node256)
+    {
+        for (auto& child: children)
+            child.store(0, std::memory_order_relaxed);
+    }
+
+    uintptr_t find(uint8_t key) const
+    {
+        return children[key].load(std::memory_order_acquire);
+    }
+
+    void add(uint8_t key, uintptr_t child)
+    {
+        children[key].store(child, std::memory_order_release);
+        count.fetch_add(1, std::memory_order_release);
+    }
+
+    void change(uint8_t key, uintptr_t child)
+    {
+        children[key].store(child, std::memory_order_release);
+    }
+
+    void remove(uint8_t key)
+    {
+        children[key].store(0, std::memory_order_release);
+        count.fetch_sub(1, std::memory_order_release);
+    }
+
+    template <typename visitor>
+    void for_each(visitor visit) const
+    {
+        for (size_t key = 0; key < 256; ++key)
+        {
+            const auto child = children[key].load(std::memory_order_acquire);
+            if (child != 0)
+                visit(uint8_t(key), child);
+        }
+    }
+
+    std::atomic<uintptr_t> children[256];
+};
+
+template <typename function>
+auto art_index::node::dispatch(const node* target, function call)
+{
+    switch (target->type)
+    {
+        case kind::node4:
+            return call(static_cast<const node4*>(target));
+        case kind::node16:
+            return call(static_cast<const node16*>(target));
+        case kind::node48:
+            return call(static_cast<const node48*>(target));
+        default:
+            return call(static_cast<const node256*>(target));
+    }
+}
+
+template <typename function>
+auto art_index::node::dispatch(node* target, function call)
+{
+    switch (target->type)
+    {
+        case kind::node4:
+            return call(static_cast<node4*>(target));
+        case kind::node16:
+            return call(static_cast<node16*>(target));
+        case kind::node48:
+            return call(static_cast<node48*>(target));
+        default:
+            return call(static_cast<node256*>(target));
+    }
+}
+
+uintptr_t art_index::node::find(uint8_t key) const
+{
+    return dispatch(this, [=](auto typed) { return typed->find(key); });
+}
+
+bool art_index::node::full() const
+{
+    switch (type)
+    {
+        case kind::node4:
+            return child_count() >= 4;
+        case kind::node16:
+            return child_count() >= 16;
+        case kind::node48:
+            return child_count() >= node48::capacity;
+        default:
+            return false;
+    }
+}
+
+// Would fit the next smaller node after a removal.
+bool art_index::node::underfull() const
+{
+    switch (type)
+    {
+        case kind::node16:
+            return child_count() <= 3;
+        case kind::node48:
+            return child_count() <= 12;
+        case kind::node256:
+            return child_count() <= 37;
+        default:
+            return false;
+    }
+}
+
+void art_index::node::add(uint8_t key, uintptr_t child)
+{
+    dispatch(this, [=](auto typed) { typed->add(key, child); });
+}
+
+void art_index::node::change(uint8_t key, uintptr_t child)
+{
+    dispatch(this, [=](auto typed) { typed->change(key, child); });
+}
+
+void art_index::node::remove(uint8_t key)
+{
+    dispatch(this, [=](auto typed) { typed->remove(key); });
+}
+
+template <typename visitor>
+void art_index::node::for_each(visitor visit) const
+{
+    dispatch(this, [&](auto typed) { typed->for_each(visit); });
+}
+
+uintptr_t art_index::node::any_child() const
+{
+    uintptr_t any = 0;
+    for_each([&](uint8_t, uintptr_t child)
+    {
+        if (any == 0 || is_leaf(child))
+            any = child;
+    });
+
+    return any;
+}
+
+uintptr_t art_index::node::other_child(uint8_t key, uint8_t& other_key) const
+{
+    uintptr_t other = 0;
+    for_each([&](uint8_t child_key, uintptr_t child)
+    {
+        if (child_key != key)
+        {
+            other = child;
+            other_key = child_key;
+        }
+    });
+
+    return other;
+}
+
+// A copy of this node's prefix and children in a node of type.
+art_index::node* art_index::node::resize(kind type) const
+{
+    const auto resized = create(type);
+    resized->set_prefix(prefix.load(std::memory_order_relaxed),
+        prefix_length.load(std::memory_order_relaxed));
+
+    for_each([&](uint8_t key, uintptr_t child)
+    {
+        resized->add(key, child);
+    });
+
+    return resized;
+}
+
+art_index::node* art_index::node::create(kind type)
+{
+    switch (type)
+    {
+        case kind::node4:
+            return new node4(kind::node4);
+        case kind::node16:
+            return new node16(kind::node16);
+        case kind::node48:
+            return new node48();
+        default:
+            return new node256();
+    }
+}
+
+void art_index::node::destroy(node* target)
+{
+    dispatch(target, [](auto typed) { delete typed; });
+}
+
+static kind larger(kind type)
+{
+    return type == kind::node4 ? kind::node16 :
+        type == kind::node16 ? kind::node48 : kind::node256;
+}
+
+static kind smaller(kind type)
+{
+    return type == kind::node256 ? kind::node48 :
+        type == kind::node48 ? kind::node16 : kind::node4;
+}
+
+// Index
+// ----------------------------------------------------------------------------
+
+// The root is a 256 child node that is never replaced and has no
+// prefix, so every other node has a parent.
+art_index::art_index(loader load)
+  : load_(load), root_(node::create(kind::node256)), size_(0), nodes_(1)
+{
+}
+
+art_index::~art_index()
+{
+    destroy(root_->to_child());
+}
+
+void art_index::release(void* pointer)
+{
+    node::destroy(static_cast<node*>(pointer));
+}
+
+void art_index::destroy(uintptr_t child)
+{
+    if (child == 0 || is_leaf(child))
+        return;
+
+    const auto target = node::from_child(child);
+    target->for_each([](uint8_t, uintptr_t below)
+    {
+        destroy(below);
+    });
+
+    node::destroy(target);
+}
+
+void art_index::retire(node* target)
+{
+    reclaimer_.retire(target, &art_index::release);
+}
+
+bool art_index::find(const hash_digest& hash, slot& out) const
+{
+    epoch_reclaimer::guard guard(reclaimer_);
+    auto found = false;
+    while (!try_find(hash, out, found));
+    return found;
+}
+
+bool art_index::insert(const hash_digest& hash, const slot& value)
+{
+    BITCOIN_ASSERT_MSG(value, "Cannot index an empty slot.");
+
+    epoch_reclaimer::guard guard(reclaimer_);
+    auto inserted = false;
+    while (!try_insert(hash, to_leaf(value), inserted));
+
+    if (inserted)
+        size_.fetch_add(1, std::memory_order_relaxed);
+
+    return inserted;
+}
+
+bool art_index::erase(const hash_digest& hash, const slot& value)
+{
+    epoch_reclaimer::guard guard(reclaimer_);
+    auto erased = false;
+    while (!try_erase(hash, to_leaf(value), erased));
+
+    if (erased)
+        size_.fetch_sub(1, std::memory_order_relaxed);
+
+    return erased;
+}
+
+// A node freed since the load is harmless to prefetch.
+void art_index::prefetch(const hash_digest& hash) const
+{
+    const auto child = root_->find(hash[0]);
+    if (child != 0 && !is_leaf(child))
+        util::prefetch(node::from_child(child));
+}
+
+void art_index::reserve(size_t)
+{
+}
+
+size_t art_index::capacity() const
+{
+    return std::numeric_limits<size_t>::max();
+}
+
+size_t art_index::size() const
+{
+    return size_.load(std::memory_order_relaxed);
+}
+
+size_t art_index::nodes() const
+{
+    return nodes_.load(std::memory_order_relaxed);
+}
+
+// Readers compare the stored prefix bytes and skip the rest, the leaf
+// comparison covers them.
+bool art_index::try_find(const hash_digest& hash, slot& out,
+    bool& found) const
+{
+    found = false;
+    const node* target = root_;
+    uint64_t version;
+    if (!target->read_lock(version))
+        return false;
+
+    size_t depth = 0;
+    while (true)
+    {
+        const auto length = target->prefix_length.load(
+            std::memory_order_relaxed);
+        for (size_t position = 0;
+            position < std::min<size_t>(length, stored_prefix); ++position)
+            if (depth + position >= key_size ||
+                target->prefix_at(position) != hash[depth + position])
+                return target->validate(version);
+
+        depth += length;
+        if (depth >= key_size)
+            return target->validate(version);
+
+        const auto child = target->find(hash[depth]);
+        if (!target->validate(version))
+            return false;
+
+        if (child == 0)
+            return true;
+
+        if (is_leaf(child))
+        {
+            out = to_slot(child);
+            found = load_(out) == hash;
+            return true;
+        }
+
+        const auto next = node::from_child(child);
+        uint64_t next_version;
+        if (!next->read_lock(next_version) || !target->validate(version))
+            return false;
+
+        target = next;
+        version = next_version;
+        ++depth;
+    }
+}
+
+// Writers compare the whole prefix, reading bytes past the stored ones
+// from any leaf below, since a mismatch there splits the node.
+bool art_index::check_prefix(const node* target, const hash_digest& hash,
+    size_t& depth, bool& matched, uint8_t& mismatch,
+    uint64_t& remaining) const
+{
+    matched = true;
+    const auto length = target->prefix_length.load(std::memory_order_relaxed);
+    const hash_digest* full = nullptr;
+    for (size_t position = 0; position < length; ++position, ++depth)
+    {
+        if (depth >= key_size)
+            return false;
+
+        if (position >= stored_prefix && full == nullptr &&
+            !any_key(target, full))
+            return false;
+
+        const auto byte = position < stored_prefix ?
+            target->prefix_at(position) : (*full)[depth];
+        if (byte == hash[depth])
+            continue;
+
+        matched = false;
+        mismatch = byte;
+        const auto after = length - position - 1;
+        if (length <= stored_prefix)
+            remaining = after == 0 ? 0 :
+                target->prefix.load(std::memory_order_relaxed) >>
+                    (8 * (position + 1));
+        else if (full != nullptr || any_key(target, full))
+            remaining = pack(full->data() + depth + 1, after);
+        else
+            return false;
+
+        return true;
+    }
+
+    return true;
+}
+
+// The key of any leaf below target, which shares its prefix.
+bool art_index::any_key(const node* target, const hash_digest*& out) const
+{
+    while (true)
+    {
+        uint64_t version;
+        if (!target->read_lock(version))
+            return false;
+
+        const auto child = target->any_child();
+        if (!target->validate(version) || child == 0)
+            return false;
+
+        if (is_leaf(child))
+        {
+            out = &load_(to_slot(child));
+            return true;
+        }
+
+        target = node::from_child(child);
+    }
+}
+
+bool art_index::try_insert(const hash_digest& hash, uintptr_t leaf,
+    bool& inserted)
+{
+    inserted = false;
+    node* parent = nullptr;
+    node* target = nullptr;
+    node* next = root_;
+    uint64_t parent_version = 0;
+    uint64_t version = 0;
+    uint8_t parent_key = 0;
+    uint8_t key = 0;
+    size_t depth = 0;
+
+    while (true)
+    {
+        parent = target;
+        parent_key = key;
+        parent_version = version;
+        target = next;
+        if (!target->read_lock(version))
+            return false;
+
+        auto next_depth = depth;
+        auto matched = true;
+        uint8_t mismatch = 0;
+        uint64_t remaining = 0;
+        if (!check_prefix(target, hash, next_depth, matched, mismatch,
+            remaining))
+            return false;
+
+        // Split the prefix with a new parent above target.
+        if (!matched)
+        {
+            if (!parent->upgrade(parent_version))
+                return false;
+
+            if (!target->upgrade(version))
+            {
+                parent->unlock();
+                return false;
+            }
+
+            const auto common = next_depth - depth;
+            const auto length = target->prefix_length.load(
+                std::memory_order_relaxed);
+            const auto split = node::create(kind::node4);
+            split->set_prefix(common >= stored_prefix ?
+                target->prefix.load(std::memory_order_relaxed) :
+                target->prefix.load(std::memory_order_relaxed) &
+                    ((uint64_t(1) << (8 * common)) - 1), common);
+            split->add(hash[next_depth], leaf);
+            split->add(mismatch, target->to_child());
+
+            parent->change(parent_key, split->to_child());
+            parent->unlock();
+
+            target->set_prefix(remaining, length - common - 1);
+            target->unlock();
+            nodes_.fetch_add(1, std::memory_order_relaxed);
+            inserted = true;
+            return true;
+        }
+
+        depth = next_depth;
+        key = hash[depth];
+        const auto child = target->find(key);
+        if (!target->validate(version))
+            return false;
+
+        if (child == 0)
+        {
+            if (!add_and_unlock(target, version, parent, parent_version,
+                parent_key, key, leaf))
+                return false;
+
+            inserted = true;
+            return true;
+        }
+
+        if (parent != nullptr && !parent->validate(parent_version))
+            return false;
+
+        // Replace the leaf with a node holding both leaves, below the
+        // bytes the two keys share.
+        if (is_leaf(child))
+        {
+            if (!target->upgrade(version))
+                return false;
+
+            const auto& existing = load_(to_slot(child));
+            if (existing == hash)
+            {
+                target->unlock();
+                return true;
+            }
+
+            auto differs = depth + 1;
+            while (existing[differs] == hash[differs])
+                ++differs;
+
+            const auto split = node::create(kind::node4);
+            split->set_prefix(pack(hash.data() + depth + 1,
+                differs - depth - 1), differs - depth - 1);
+            split->add(hash[differs], leaf);
+            split->add(existing[differs], child);
+
+            target->change(key, split->to_child());
+            target->unlock();
+            nodes_.fetch_add(1, std::memory_order_relaxed);
+            inserted = true;
+            return true;
+        }
+
+        next = node::from_child(child);
+        ++depth;
+    }
+}
+
+// A full target is replaced by a larger copy, which needs the parent.
+bool art_index::add_and_unlock(node* target, uint64_t version, node* parent,
+    uint64_t parent_version, uint8_t parent_key, uint8_t key,
+    uintptr_t child)
+{
+    if (!target->full())
+    {
+        if (!target->upgrade(version))
+            return false;
+
+        if (parent != nullptr && !parent->validate(parent_version))
+        {
+            target->unlock();
+            return false;
+        }
+
+        target->add(key, child);
+        target->unlock();
+        return true;
+    }
+
+    if (!parent->upgrade(parent_version))
+        return false;
+
+    if (!target->upgrade(version))
+    {
+        parent->unlock();
+        return false;
+    }
+
+    const auto grown = target->resize(larger(target->type));
+    grown->add(key, child);
+    parent->change(parent_key, grown->to_child());
+    parent->unlock();
+
+    target->unlock_obsolete();
+    retire(target);
+    return true;
+}
+
+bool art_index::try_erase(const hash_digest& hash, uintptr_t leaf,
+    bool& erased)
+{
+    erased = false;
+    node* parent = nullptr;
+    node* target = nullptr;
+    node* next = root_;
+    uint64_t parent_version = 0;
+    uint64_t version = 0;
+    uint8_t parent_key = 0;
+    uint8_t key = 0;
+    size_t depth = 0;
+
+    while (true)
+    {
+        parent = target;
+        parent_key = key;
+        parent_version = version;
+        target = next;
+        if (!target->read_lock(version))
+            return false;
+
+        const auto length = target->prefix_length.load(
+            std::memory_order_relaxed);
+        for (size_t position = 0;
+            position < std::min<size_t>(length, stored_prefix); ++position)
+            if (depth + position >= key_size ||
+                target->prefix_at(position) != hash[depth + position])
+                return target->validate(version);
+
+        depth += length;
+        if (depth >= key_size)
+            return target->validate(version);
+
+        key = hash[depth];
+        const auto child = target->find(key);
+        if (!target->validate(version))
+            return false;
+
+        if (child == 0)
+            return true;
+
+        if (!is_leaf(child))
+        {
+            next = node::from_child(child);
+            ++depth;
+            continue;
+        }
+
+        if (child != leaf || load_(to_slot(child)) != hash)
+            return true;
+
+        if (parent == nullptr || target->child_count() != 2)
+        {
+            if (!remove_and_unlock(target, version, parent, parent_version,
+                parent_key, key))
+                return false;
+
+            erased = true;
+            return true;
+        }
+
+        // Two children, put the other child in the parent in place of
+        // target.
+        if (!parent->upgrade(parent_version))
+            return false;
+
+        if (!target->upgrade(version))
+        {
+            parent->unlock();
+            return false;
+        }
+
+        uint8_t other_key = 0;
+        const auto other = target->other_child(key, other_key);
+        if (!is_leaf(other))
+        {
+            const auto below = node::from_child(other);
+            if (!below->lock())
+            {
+                target->unlock();
+                parent->unlock();
+                return false;
+            }
+
+            below->prepend_prefix(target, other_key);
+            parent->change(parent_key, other);
+            below->unlock();
+        }
+        else
+        {
+            parent->change(parent_key, other);
+        }
+
+        parent->unlock();
+        target->unlock_obsolete();
+        retire(target);
+        nodes_.fetch_sub(1, std::memory_order_relaxed);
+        erased = true;
+        return true;
+    }
+}
+
+// An underfull target is replaced by a smaller copy, which needs the
+// parent. The root is never replaced.
+bool art_index::remove_and_unlock(node* target, uint64_t version,
+    node* parent, uint64_t parent_version, uint8_t parent_key, uint8_t key)
+{
+    if (parent == nullptr || !target->underfull())
+    {
+        if (!target->upgrade(version))
+            return false;
+
+        if (parent != nullptr && !parent->validate(parent_version))
+        {
+            target->unlock();
+            return false;
+        }
+
+        target->remove(key);
+        target->unlock();
+        return true;
+    }
+
+    if (!parent->upgrade(parent_version))
+        return false;
+
+    if (!target->upgrade(version))
+    {
+        parent->unlock();
+        return false;
+    }
+
+    const auto shrunk = target->resize(smaller(target->type));
+    shrunk->remove(key);
+    parent->change(parent_key, shrunk->to_child());
+    parent->unlock();
+
+    target->unlock_obsolete();
+    retire(target);
+    return true;
+}
+
+} // namespace container
+} // namespace database
+} // namespace libbitcoin
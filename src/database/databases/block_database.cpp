@@ -17,8 +17,19 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <thread>
+#include <utility>
+
 #include <bitcoin/database/block_state.hpp>
 #include <bitcoin/database/databases/block_database.hpp>
+#include <bitcoin/database/durability/parallel_for.hpp>
+#include <bitcoin/database/storage/interleave.hpp>
+#include <bitcoin/database/storage/util.hpp>
 #include <bitcoin/database/tuples/block_tuple.hpp>
 
 namespace libbitcoin {
@@ -29,56 +40,597 @@ using namespace chain;
 using namespace mvto;
 using namespace tuples;
 using namespace storage;
+using namespace durability;
+
+// The hash of a block never changes once it is written, so it is read
+// from the cold column without a transaction.
+static hash_digest_index_map::loader hash_loader(block_store_ptr store)
+{
+    return [store](const slot& at_slot) -> const hash_digest&
+    {
+        return store->get_cold_at<block_cold_column>(at_slot)->hash;
+    };
+}
 
 block_database::block_database(uint64_t block_size_limit,
     uint64_t block_reuse_limit, uint64_t delta_size_limit,
     uint64_t delta_reuse_limit)
+  : block_database(nullptr, block_size_limit, block_reuse_limit,
+      delta_size_limit, delta_reuse_limit)
+{
+}
+
+block_database::block_database(log_manager_ptr log,
+    uint64_t block_size_limit, uint64_t block_reuse_limit,
+    uint64_t delta_size_limit, uint64_t delta_reuse_limit)
     : block_store_pool_(std::make_shared<block_pool>(block_size_limit, block_reuse_limit)),
-      block_store_(std::make_shared<storage::store<block_mvcc_record>>(block_store_pool_)),
+      block_store_(std::make_shared<storage::store<block_mvcc_record>>(
+          block_store_pool_, sizeof(block_cold_column))),
       delta_store_pool_(std::make_shared<block_pool>(delta_size_limit, delta_reuse_limit)),
       delta_store_(std::make_shared<storage::store<block_delta_mvcc_record>>(delta_store_pool_)),
       accessor_(block_mvto_accessor{block_store_, delta_store_}),
       candidate_index_(std::make_shared<height_index_map>()),
       confirmed_index_(std::make_shared<height_index_map>()),
-      hash_digest_index_(std::make_shared<hash_digest_index_map>())
+      hash_digest_index_(std::make_shared<hash_digest_index_map>(
+          hash_loader(block_store_))),
+      candidate_tip_(std::make_shared<chain_tip>()),
+      confirmed_tip_(std::make_shared<chain_tip>()),
+      candidate_pending_(std::make_shared<container::pending_heights>()),
+      confirmed_pending_(std::make_shared<container::pending_heights>()),
+      log_(log),
+      checkpointer_(log)
+{
+}
+
+// Blocks read from a checkpoint at a time, each batch is restored
+// across the recovery threads.
+static const size_t checkpoint_batch_size = 1 << 16;
+
+// Headers hashed by each thread of a bulk store, at least.
+static const size_t headers_per_thread = 1024;
+
+void block_database::reserve(size_t expected_height)
+{
+    candidate_index_->reserve(expected_height);
+    confirmed_index_->reserve(expected_height);
+
+    hash_digest_index_->reserve(expected_height);
+}
+
+bool block_database::filter_hashes(size_t expected_count)
+{
+    return hash_digest_index_->enable_filter(expected_count);
+}
+
+bool block_database::create()
+{
+    return log_ == nullptr || (checkpointer_.create() && log_->create());
+}
+
+bool block_database::open()
+{
+    return open(std::max(1u, std::thread::hardware_concurrency()));
+}
+
+bool block_database::open(size_t threads)
+{
+    if (log_ == nullptr)
+        return true;
+
+    size_t segment;
+    const auto loaded = checkpointer_.load(
+        [this, threads](checkpoint_reader& reader)
+        {
+            return load(reader, threads);
+        }, segment);
+
+    if (!loaded)
+        return false;
+
+    const auto replayed = log_->replay(segment,
+        [this](timestamp_t, const redo_record& record)
+        {
+            transaction_context context(recovery_timestamp, state::active);
+            if (apply(context, record))
+                context.commit();
+            else
+                context.abort();
+        }, threads);
+
+    if (!replayed)
+        return false;
+
+    if (!index_heights(threads))
+        return false;
+
+    link_blocks(threads);
+    return log_->open();
+}
+
+void block_database::commit()
+{
+    if (log_ != nullptr)
+        log_->flush();
+}
+
+bool block_database::close()
+{
+    return log_ == nullptr || log_->close();
+}
+
+bool block_database::checkpoint(transaction_manager& manager)
+{
+    if (log_ == nullptr)
+        return false;
+
+    return checkpointer_.checkpoint(manager,
+        [this](checkpoint_writer& writer, timestamp_t snapshot)
+        {
+            return save(writer, snapshot);
+        });
+}
+
+// Section layout: table id, block count, then hash and block tuple
+// for each block.
+bool block_database::save(checkpoint_writer& writer,
+    timestamp_t snapshot) const
+{
+    if (!writer.write(table_id::block))
+        return false;
+
+    uint64_t count = 0;
+    const auto count_position = writer.position();
+    if (!writer.write(count))
+        return false;
+
+    auto written = true;
+    for (const auto block: block_store_->get_blocks())
+    {
+        block_store_->for_each_in(block,
+            [&](const slot& at_slot, block_mvcc_record* record)
+            {
+                auto data = record->read_snapshot(snapshot,
+                    block_tuple::read_from_delta);
+                if (!written || data == block_mvcc_record::not_found)
+                    return;
+
+                written = writer.write(cold(at_slot).hash) &&
+                    writer.write(*data);
+                ++count;
+            });
+    }
+
+    return written && writer.write_at(count_position, count);
+}
+
+bool block_database::load(checkpoint_reader& reader, size_t threads)
+{
+    static const size_t entry_size = sizeof(hash_digest) + sizeof(block_tuple);
+
+    table_id table;
+    uint64_t count;
+    if (!reader.read(table) || table != table_id::block || !reader.read(count))
+        return false;
+
+    // Size the hash index once, instead of growing it during the load.
+    hash_digest_index_->reserve(count);
+
+    data_chunk batch;
+    std::atomic<bool> restored(true);
+
+    for (uint64_t loaded = 0; loaded < count;)
+    {
+        const size_t size = std::min<uint64_t>(count - loaded,
+            checkpoint_batch_size);
+        batch.resize(size * entry_size);
+        if (!reader.read(batch.data(), batch.size()))
+            return false;
+
+        parallel_for(size, threads, [&](size_t begin, size_t end)
+        {
+            transaction_context context(recovery_timestamp, state::active);
+            for (auto index = begin; index < end; ++index)
+            {
+                const auto entry = batch.data() + index * entry_size;
+
+                hash_digest hash;
+                auto data = std::make_shared<block_tuple>();
+                std::memcpy(hash.data(), entry, hash.size());
+                std::memcpy(data.get(), entry + hash.size(),
+                    sizeof(block_tuple));
+
+                if (!restore(context, hash, data))
+                {
+                    restored = false;
+                    context.abort();
+                    return;
+                }
+            }
+
+            context.commit();
+        });
+
+        if (!restored)
+            return false;
+
+        loaded += size;
+    }
+
+    return true;
+}
+
+bool block_database::restore(transaction_context& context,
+    const hash_digest& hash, block_tuple_ptr data)
+{
+    const auto at_slot = accessor_.put(context, data);
+    if (!at_slot)
+        return false;
+
+    // Links are set by link_blocks once every block is recovered.
+    make_cold(at_slot, hash, 0);
+    hash_digest_index_->insert(hash, at_slot);
+    return true;
+}
+
+block_cold_column& block_database::cold(const slot& at_slot) const
+{
+    return *block_store_->get_cold_at<block_cold_column>(at_slot);
+}
+
+void block_database::make_cold(const slot& at_slot, const hash_digest& hash,
+    uint64_t pending)
+{
+    auto column = new (&cold(at_slot)) block_cold_column{};
+    column->hash = hash;
+    column->pending.store(pending, std::memory_order_release);
+}
+
+bool block_database::find_hash(const transaction_context& context,
+    const hash_digest& hash, slot& out) const
+{
+    return hash_digest_index_->find(hash, out) && is_visible(context, out);
+}
+
+bool block_database::is_visible(const transaction_context& context,
+    const slot& at_slot) const
+{
+    const auto pending = cold(at_slot).pending.load(std::memory_order_acquire);
+    return pending == 0 || pending == context.get_timestamp();
+}
+
+bool block_database::find_height(const transaction_context& context,
+    size_t height, bool candidate, slot& out) const
+{
+    const auto& index = candidate ? candidate_index_ : confirmed_index_;
+    const auto& tip = candidate ? candidate_tip_ : confirmed_tip_;
+    const auto& pending = candidate ? candidate_pending_ : confirmed_pending_;
+
+    if (tip->is_writer(context.get_timestamp()))
+        return pending->find(*index, height, out);
+
+    return index->find(height, out);
+}
+
+void block_database::register_stored(transaction_context& context,
+    const std::vector<hash_digest>& hashes, const std::vector<slot>& slots)
+{
+    const auto store = block_store_;
+    const auto index = hash_digest_index_;
+
+    context.register_commit_action([store, slots]()
+    {
+        for (const auto& at_slot: slots)
+            store->get_cold_at<block_cold_column>(at_slot)->pending.store(0,
+                std::memory_order_release);
+    });
+
+    // Aborted records begin at infinity, unreadable, only their index
+    // entries are dropped.
+    context.register_abort_action([index, hashes, slots]()
+    {
+        for (size_t entry = 0; entry < slots.size(); ++entry)
+            index->erase(hashes[entry], slots[entry]);
+    });
+}
+
+// The height of a record never changes, it is read without a
+// transaction.
+size_t block_database::height_of(const slot& at_slot) const
+{
+    return block_store_->get_bytes_at(at_slot)->get_data().height;
+}
+
+static size_t invert_lowest_one(size_t value)
+{
+    return value & (value - 1);
+}
+
+// The height a block at height keeps a skip link to. As in Bitcoin
+// Core's pskip, any ancestor is then O(log n) links away.
+static size_t skip_height(size_t height)
+{
+    if (height < 2)
+        return 0;
+
+    // Odd heights link a little further back than the even height
+    // below them, so walks alternate between long and short hops.
+    return (height & 1) ?
+        invert_lowest_one(invert_lowest_one(height - 1)) + 1 :
+        invert_lowest_one(height);
+}
+
+static uint256_t to_uint256(const chain_work& work)
+{
+    uint256_t value;
+    boost::multiprecision::import_bits(value, work.begin(), work.end());
+    return value;
+}
+
+static chain_work to_chain_work(const uint256_t& value)
+{
+    // export_bits writes only the significant bytes, right align them.
+    chain_work work{};
+    data_chunk bytes;
+    boost::multiprecision::export_bits(value, std::back_inserter(bytes), 8);
+    std::copy(bytes.begin(), bytes.end(), work.end() - bytes.size());
+    return work;
+}
+
+void block_database::link(const slot& at_slot, const slot& parent)
+{
+    auto& links = cold(at_slot);
+    const auto height = height_of(at_slot);
+    const auto proof = chain::header::proof(
+        block_store_->get_bytes_at(at_slot)->get_data().bits);
+
+    if (!parent || height == 0 || height_of(parent) + 1 != height)
+    {
+        links.parent = slot{};
+        links.skip = slot{};
+        links.work = to_chain_work(proof);
+        return;
+    }
+
+    links.parent = parent;
+    links.skip = get_ancestor(parent, skip_height(height));
+    links.work = to_chain_work(to_uint256(cold(parent).work) + proof);
+}
+
+slot block_database::get_ancestor(slot at_slot, size_t height) const
+{
+    if (!at_slot || height > height_of(at_slot))
+        return slot{};
+
+    auto current = height_of(at_slot);
+    while (at_slot && current > height)
+    {
+        const auto& links = cold(at_slot);
+        const auto skip = skip_height(current);
+        const auto skip_previous = skip_height(current - 1);
+
+        // Take the skip unless the parent's skip gets closer without
+        // passing height.
+        if (links.skip && (skip == height || (skip > height &&
+            !(skip_previous + 2 < skip && skip_previous >= height))))
+        {
+            at_slot = links.skip;
+            current = skip;
+        }
+        else
+        {
+            at_slot = links.parent;
+            --current;
+        }
+    }
+
+    return at_slot;
+}
+
+bool block_database::get_ancestor(transaction_context& context,
+    const hash_digest& hash, size_t height, hash_digest& out) const
+{
+    slot at_slot;
+    if (!find_hash(context, hash, at_slot) ||
+        !(at_slot = get_ancestor(at_slot, height)))
+    {
+        context.abort();
+        return false;
+    }
+
+    out = cold(at_slot).hash;
+    return true;
+}
+
+bool block_database::get_work(transaction_context& context,
+    const hash_digest& hash, uint256_t& out) const
 {
+    slot at_slot;
+    if (!find_hash(context, hash, at_slot))
+    {
+        context.abort();
+        return false;
+    }
+
+    out = to_uint256(cold(at_slot).work);
+    return true;
+}
+
+bool block_database::compare_work(transaction_context& context,
+    const hash_digest& left, const hash_digest& right, int& out) const
+{
+    slot left_slot;
+    slot right_slot;
+    if (!find_hash(context, left, left_slot) ||
+        !find_hash(context, right, right_slot))
+    {
+        context.abort();
+        return false;
+    }
+
+    const auto& left_work = cold(left_slot).work;
+    const auto& right_work = cold(right_slot).work;
+    out = std::memcmp(left_work.data(), right_work.data(), left_work.size());
+    return true;
+}
+
+void block_database::link_blocks(size_t threads)
+{
+    std::vector<std::pair<size_t, slot>> blocks;
+    for (const auto block: block_store_->get_blocks())
+    {
+        block_store_->for_each_in(block,
+            [&](const slot& at_slot, block_mvcc_record* record)
+            {
+                if (record->is_committed_at(recovery_timestamp))
+                    blocks.emplace_back(record->get_data().height, at_slot);
+            });
+    }
+
+    // A skip link follows the links of ancestors, so link upwards.
+    std::stable_sort(blocks.begin(), blocks.end(),
+        [](const std::pair<size_t, slot>& left,
+            const std::pair<size_t, slot>& right)
+        {
+            return left.first < right.first;
+        });
+
+    std::vector<slot> parents(blocks.size());
+    parallel_for(blocks.size(), threads, [&](size_t begin, size_t end)
+    {
+        for (auto index = begin; index < end; ++index)
+        {
+            const auto record = block_store_->get_bytes_at(
+                blocks[index].second);
+            hash_digest_index_->find(record->get_data().previous_block_hash,
+                parents[index]);
+        }
+    });
+
+    for (size_t index = 0; index < blocks.size(); ++index)
+        link(blocks[index].second, parents[index]);
+}
+
+bool block_database::apply(transaction_context& context,
+    const redo_record& record)
+{
+    if (record.table != table_id::block ||
+        record.key_size != sizeof(hash_digest))
+        return false;
+
+    hash_digest hash;
+    std::memcpy(hash.data(), record.key, hash.size());
+
+    slot at_slot;
+    const auto exists = hash_digest_index_->find(hash, at_slot);
+
+    if (record.operation == redo_operation::insert)
+    {
+        if (exists)
+            return true;
+
+        auto data = std::make_shared<block_tuple>();
+        return record.read_value(*data) && restore(context, hash, data);
+    }
+
+    auto delta_data = std::make_shared<block_tuple_delta>();
+    if (!exists || !record.read_value(*delta_data))
+        return false;
+
+    return accessor_.update(context, at_slot, delta_data);
+}
+
+bool block_database::index_heights(size_t threads)
+{
+    const auto blocks = block_store_->get_blocks();
+    std::atomic<bool> indexed{ true };
+
+    parallel_for(blocks.size(), threads, [&](size_t begin, size_t end)
+    {
+        for (auto index = begin; index < end; ++index)
+        {
+            block_store_->for_each_in(blocks[index],
+                [this, &indexed](const slot& at_slot, block_mvcc_record* record)
+                {
+                    // Every recovered version begins at recovery_timestamp.
+                    const auto data = record->read_snapshot(
+                        recovery_timestamp, block_tuple::read_from_delta);
+                    if (data == block_mvcc_record::not_found)
+                        return;
+
+                    // A height past the index is a corrupt tuple.
+                    if (is_candidate(data->state) &&
+                        !candidate_index_->insert_or_assign(data->height,
+                            at_slot))
+                        indexed.store(false, std::memory_order_relaxed);
+
+                    if (is_confirmed(data->state) &&
+                        !confirmed_index_->insert_or_assign(data->height,
+                            at_slot))
+                        indexed.store(false, std::memory_order_relaxed);
+                });
+        }
+    });
+
+    if (!indexed.load())
+        return false;
+
+    candidate_tip_->publish(recovery_timestamp, candidate_index_->size());
+    confirmed_tip_->publish(recovery_timestamp, confirmed_index_->size());
+    return true;
 }
 
 bool block_database::top(transaction_context& context, size_t& out_height,
     bool candidate) const
 {
-    auto index = candidate ? candidate_index_ : confirmed_index_;
-    auto size = index->size();
+    const auto& tip = candidate ? candidate_tip_ : confirmed_tip_;
+    const auto& pending = candidate ? candidate_pending_ : confirmed_pending_;
 
-    if (size == 0)
+    size_t size;
+    if (tip->is_writer(context.get_timestamp()))
+    {
+        size = pending->size();
+    }
+    else if (!tip->find(context.get_timestamp(), size))
     {
+        // The snapshot is older than every tip kept.
         context.abort();
         return false;
     }
 
+    // An empty chain is not an error of the transaction.
+    if (size == 0)
+        return false;
+
     out_height = size - 1;
     return true;
 }
 
+static void to_tuple(const chain::header& header, size_t height,
+    uint32_t median_time_past, uint32_t checksum, uint8_t state,
+    block_tuple& data)
+{
+    // set header data
+    data.previous_block_hash = header.previous_block_hash();
+    data.merkle_root = header.merkle_root();
+    data.version = header.version();
+    data.timestamp = header.timestamp();
+    data.bits = header.bits();
+    data.nonce = header.nonce();
+
+    // set block data
+    data.height = height;
+    data.median_time_past = median_time_past;
+    data.checksum = checksum;
+    data.state = state;
+}
+
 bool block_database::store(transaction_context& context,
     const system::chain::header& header,
     const size_t height, const uint32_t median_time_past,
     const uint32_t checksum, const uint8_t state)
 {
     auto data = std::make_shared<block_tuple>();
-    // set header data
-    data->previous_block_hash = header.previous_block_hash();
-    data->merkle_root = header.merkle_root();
-    data->version = header.version();
-    data->timestamp = header.timestamp();
-    data->bits = header.bits();
-    data->nonce = header.nonce();
-
-    // set block data
-    data->height = height;
-    data->median_time_past = median_time_past;
-    data->checksum = checksum;
-    data->state = state;
+    to_tuple(header, height, median_time_past, checksum, state, *data);
 
     auto result_slot = accessor_.put(context, data);
 
@@ -88,7 +640,157 @@ bool block_database::store(transaction_context& context,
         return false;
     }
 
-    hash_digest_index_->insert(header.hash(), result_slot);
+    slot parent;
+    hash_digest_index_->find(data->previous_block_hash, parent);
+
+    const auto hash = header.hash();
+    make_cold(result_slot, hash, context.get_timestamp());
+    link(result_slot, parent);
+    hash_digest_index_->insert(hash, result_slot);
+    register_stored(context, { hash }, { result_slot });
+    context.register_redo(table_id::block, redo_operation::insert, hash,
+        *data);
+    return true;
+}
+
+bool block_database::store_headers(transaction_context& context,
+    const chain::header::list& headers, size_t start_height,
+    const std::vector<uint32_t>& median_time_pasts, uint8_t state)
+{
+    const auto count = headers.size();
+    if (median_time_pasts.size() != count)
+    {
+        context.abort();
+        return false;
+    }
+
+    // Small batches are not worth starting threads for.
+    const size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+    const auto threads = std::min(hardware,
+        (count + headers_per_thread - 1) / headers_per_thread);
+
+    std::vector<block_tuple> tuples(count);
+    std::vector<hash_digest> hashes(count);
+    parallel_for(count, threads, [&](size_t begin, size_t end)
+    {
+        for (auto index = begin; index < end; ++index)
+        {
+            const auto& header = headers[index];
+            to_tuple(header, start_height + index,
+                median_time_pasts[index], 0, state, tuples[index]);
+            hashes[index] = header.hash();
+        }
+    });
+
+    std::vector<slot> slots(count);
+    if (!accessor_.put(context, tuples.data(), count, slots.data()))
+    {
+        context.abort();
+        return false;
+    }
+
+    // Link in order, a header's parent is usually the one before it.
+    for (size_t index = 0; index < count; ++index)
+    {
+        slot parent;
+        if (index > 0 && tuples[index].previous_block_hash == hashes[index - 1])
+            parent = slots[index - 1];
+        else
+            hash_digest_index_->find(tuples[index].previous_block_hash,
+                parent);
+
+        make_cold(slots[index], hashes[index], context.get_timestamp());
+        link(slots[index], parent);
+    }
+
+    // No reserve here, it would rehash the whole index under all of its
+    // locks. Past the capacity planned by reserve the index doubles and
+    // moves buckets on first use.
+    parallel_for(count, threads, [&](size_t begin, size_t end)
+    {
+        for (auto index = begin; index < end; ++index)
+            hash_digest_index_->insert(hashes[index], slots[index]);
+    });
+
+    register_stored(context, hashes, slots);
+
+    for (size_t index = 0; index < count; ++index)
+        context.register_redo(table_id::block, redo_operation::insert,
+            hashes[index], tuples[index]);
+
+    return true;
+}
+
+bool block_database::get_hash(transaction_context& context, size_t height,
+    bool candidate, hash_digest& out) const
+{
+    slot at_slot;
+    if (!find_height(context, height, candidate, at_slot))
+    {
+        context.abort();
+        return false;
+    }
+
+    out = cold(at_slot).hash;
+    return true;
+}
+
+// Locator heights step back one block at a time for the first ten
+// entries, then double the step, and always end at genesis.
+static const size_t locator_dense_entries = 10;
+
+template <typename handler>
+static void for_each_locator_height(size_t top, handler handle)
+{
+    size_t step = 1;
+    size_t entries = 0;
+    for (auto height = top; height > 0;
+        height = height > step ? height - step : 0)
+    {
+        if (entries++ >= locator_dense_entries)
+            step <<= 1;
+
+        handle(height);
+    }
+
+    handle(0);
+}
+
+bool block_database::locator(transaction_context& context, bool candidate,
+    hash_list& out) const
+{
+    // One read of the tip, the heights all follow from it. An empty
+    // chain has no locator and, as with top, leaves the context active.
+    size_t top;
+    if (!this->top(context, top, candidate))
+    {
+        out.clear();
+        return false;
+    }
+
+    size_t count = 0;
+    for_each_locator_height(top, [&count](size_t) { ++count; });
+    out.resize(count);
+
+    auto found = true;
+    auto hash = out.begin();
+    for_each_locator_height(top, [&](size_t height)
+    {
+        slot at_slot;
+        if (!find_height(context, height, candidate, at_slot))
+            found = false;
+        else if (found)
+            *hash++ = cold(at_slot).hash;
+    });
+
+    // A reorganization truncated the index below the tip read.
+    if (!found)
+    {
+        out.clear();
+        context.abort();
+        return false;
+    }
+
     return true;
 }
 
@@ -97,16 +799,132 @@ bool block_database::store(transaction_context& context,
 block_tuple_ptr block_database::get(transaction_context& context,
     const system::hash_digest& hash) const
 {
-    try
-    {
-        auto at_slot = hash_digest_index_->find(hash);
-        return accessor_.get(context, at_slot, block_tuple::read_from_delta);
-    }
-    catch (std::out_of_range e)
+    slot at_slot;
+    if (!find_hash(context, hash, at_slot))
     {
         context.abort();
         return nullptr;
     }
+
+    return accessor_.get(context, at_slot, block_tuple::read_from_delta);
+}
+
+// Lookups in flight in multi_get, enough for their misses to overlap
+// without their prefetches evicting each other.
+static const size_t multi_get_width = 16;
+
+// Each step ends by prefetching what the next one reads.
+class block_database::hash_lookup
+{
+public:
+    void start(const block_database& database, transaction_context& context,
+        const hash_digest& hash, block_tuple_ptr& out)
+    {
+        database_ = &database;
+        context_ = &context;
+        hash_ = &hash;
+        out_ = &out;
+        state_ = state::probe;
+    }
+
+    bool step()
+    {
+        const auto& index = database_->hash_digest_index_;
+        const auto& accessor = database_->accessor_;
+
+        switch (state_)
+        {
+            case state::probe:
+                index->prefetch(*hash_);
+                state_ = state::candidate;
+                return true;
+
+            // The index confirms a match against the cold column, so
+            // load that and the record before verifying the match here.
+            case state::candidate:
+                state_ = state::verify;
+                has_candidate_ = index->candidate(*hash_, slot_);
+                if (has_candidate_)
+                {
+                    util::prefetch(&database_->cold(slot_));
+                    accessor.prefetch(slot_, false);
+                    return true;
+                }
+
+                // Without a candidate the lookup itself is next.
+                return step();
+
+            // A candidate holding another hash leaves the full lookup,
+            // which also searches the fingerprint overflow.
+            case state::verify:
+                if (has_candidate_ && database_->cold(slot_).hash == *hash_)
+                {
+                    if (!database_->is_visible(*context_, slot_))
+                        return false;
+                }
+                else if (!database_->find_hash(*context_, *hash_, slot_))
+                    return false;
+
+                accessor.prefetch(slot_, false);
+                state_ = state::delta;
+                return true;
+
+            case state::delta:
+                accessor.prefetch(slot_, true);
+                state_ = state::read;
+                return true;
+
+            case state::read:
+                *out_ = accessor.get(*context_, slot_,
+                    block_tuple::read_from_delta);
+                return false;
+        }
+
+        return false;
+    }
+
+private:
+    enum class state
+    {
+        probe,
+        candidate,
+        verify,
+        delta,
+        read
+    };
+
+    const block_database* database_;
+    transaction_context* context_;
+    const hash_digest* hash_;
+    block_tuple_ptr* out_;
+    slot slot_;
+    bool has_candidate_;
+    state state_;
+};
+
+size_t block_database::multi_get(transaction_context& context,
+    const hash_list& hashes, std::vector<block_tuple_ptr>& out) const
+{
+    return multi_get(context, hashes, out, multi_get_width);
+}
+
+size_t block_database::multi_get(transaction_context& context,
+    const hash_list& hashes, std::vector<block_tuple_ptr>& out,
+    size_t width) const
+{
+    out.assign(hashes.size(), nullptr);
+
+    interleave<hash_lookup>(hashes.size(), width,
+        [&](size_t index, hash_lookup& lookup)
+        {
+            lookup.start(*this, context, hashes[index], out[index]);
+        });
+
+    return std::count_if(out.begin(), out.end(),
+        [](const block_tuple_ptr& block)
+        {
+            return block != nullptr;
+        });
 }
 
 static uint8_t update_validation_state(uint8_t original, bool positive)
@@ -156,17 +974,107 @@ static uint8_t update_confirmation_state(uint8_t original, bool positive,
 block_tuple_ptr block_database::get(transaction_context& context,
     size_t height, bool candidate) const
 {
-    auto index = candidate ? candidate_index_ : confirmed_index_;
-    try
-    {
-        auto at_slot = index->find(height);
-        return accessor_.get(context, at_slot, block_tuple::read_from_delta);
-    }
-    catch (std::out_of_range e)
+    slot at_slot;
+    if (!find_height(context, height, candidate, at_slot))
     {
         context.abort();
         return nullptr;
     }
+
+    return accessor_.get(context, at_slot, block_tuple::read_from_delta);
+}
+
+// Slots prefetched ahead of the one being read. Records are
+// prefetched at this distance, their first delta at half of it, when
+// the record itself should already be cached.
+static const size_t prefetch_distance = 8;
+
+// Heights reserved for up front by a range read, the rest of a range
+// grows as it is read, so an unbounded to allocates nothing extra.
+static const size_t reserved_range = 2000;
+
+template <typename visitor>
+size_t block_database::read_range(transaction_context& context,
+    size_t from, size_t to, bool candidate, visitor visit) const
+{
+    std::vector<slot> slots;
+    slots.reserve(std::min(to > from ? to - from : 0, reserved_range));
+
+    slot at_slot;
+    for (auto height = from; height < to &&
+        find_height(context, height, candidate, at_slot); ++height)
+        slots.push_back(at_slot);
+
+    const auto count = slots.size();
+    for (size_t index = 0; index < std::min(count, prefetch_distance); ++index)
+        accessor_.prefetch(slots[index], false);
+
+    block_tuple block;
+    for (size_t index = 0; index < count; ++index)
+    {
+        if (index + prefetch_distance < count)
+            accessor_.prefetch(slots[index + prefetch_distance], false);
+
+        if (index + prefetch_distance / 2 < count)
+            accessor_.prefetch(slots[index + prefetch_distance / 2], true);
+
+        if (!accessor_.get(context, slots[index],
+            block_tuple::read_from_delta, block))
+            return index;
+
+        visit(block);
+    }
+
+    return count;
+}
+
+size_t block_database::get(transaction_context& context, size_t from,
+    size_t to, bool candidate, std::vector<block_tuple>& out) const
+{
+    return read_range(context, from, to, candidate,
+        [&out](const block_tuple& block)
+        {
+            out.push_back(block);
+        });
+}
+
+// Header wire encoding, integers little endian.
+static uint8_t* write_header(const block_tuple& block, uint8_t* out)
+{
+    const auto write_4_bytes = [&out](uint32_t value)
+    {
+        out[0] = static_cast<uint8_t>(value);
+        out[1] = static_cast<uint8_t>(value >> 8);
+        out[2] = static_cast<uint8_t>(value >> 16);
+        out[3] = static_cast<uint8_t>(value >> 24);
+        out += sizeof(uint32_t);
+    };
+
+    write_4_bytes(block.version);
+    out = std::copy(block.previous_block_hash.begin(),
+        block.previous_block_hash.end(), out);
+    out = std::copy(block.merkle_root.begin(), block.merkle_root.end(), out);
+    write_4_bytes(block.timestamp);
+    write_4_bytes(block.bits);
+    write_4_bytes(block.nonce);
+    return out;
+}
+
+size_t block_database::get_headers(transaction_context& context,
+    size_t from, size_t to, bool candidate, data_chunk& out) const
+{
+    static const size_t header_size = 80;
+
+    out.reserve(out.size() +
+        std::min(to > from ? to - from : 0, reserved_range) * header_size);
+
+    return read_range(context, from, to, candidate,
+        [&out](const block_tuple& block)
+        {
+            const auto position = out.size();
+            out.resize(position + header_size);
+            write_header(block, out.data() + position);
+        });
 }
 
 // Find block from block hash index and then update it.
@@ -175,39 +1083,156 @@ bool block_database::promote(transaction_context& context,
     const system::hash_digest &hash, size_t height, bool candidate,
     bool promote_or_demote)
 {
-    block_tuple_ptr read_block;
     slot at_slot;
-
-    try
-    {
-        hash_digest_index_->find(hash, at_slot);
-        read_block = accessor_.get(context, at_slot, block_tuple::read_from_delta);
-    }
-    catch (std::out_of_range e)
+    if (height >= height_index_map::max_height ||
+        !find_hash(context, hash, at_slot) ||
+        !write_tip(context, candidate) ||
+        !update_state(context, hash, at_slot, candidate, promote_or_demote))
     {
         context.abort();
         return false;
     }
 
-    auto original = read_block->state;
-    const auto updated_state = update_confirmation_state(original, promote_or_demote, candidate);
+    const auto& index = candidate ? candidate_index_ : confirmed_index_;
+    const auto& pending = candidate ? candidate_pending_ : confirmed_pending_;
+
+    // add to the selected index - promote
+    if (promote_or_demote)
+        return pending->insert(*index, height, at_slot);
+
+    // remove from the selected index - demote
+    return pending->erase(*index, height);
+}
+
+bool block_database::write_tip(transaction_context& context, bool candidate)
+{
+    const auto index = candidate ? candidate_index_ : confirmed_index_;
+    const auto tip = candidate ? candidate_tip_ : confirmed_tip_;
+    const auto pending = candidate ? candidate_pending_ : confirmed_pending_;
+    const auto timestamp = context.get_timestamp();
+
+    if (tip->is_writer(timestamp))
+        return true;
+
+    if (!tip->begin_write(timestamp))
+        return false;
+
+    // The writer starts from the committed index.
+    pending->reset(*index);
+
+    context.register_commit_action([index, tip, pending, timestamp]()
+    {
+        pending->apply(*index);
+        tip->commit_write(timestamp, pending->size());
+    });
+
+    context.register_abort_action([tip, timestamp]()
+    {
+        tip->end_write(timestamp);
+    });
+
+    return true;
+}
+
+// Append a delta moving the block at at_slot into or out of the
+// candidate|confirmed chain.
+bool block_database::update_state(transaction_context& context,
+    const hash_digest& hash, slot at_slot, bool candidate,
+    bool promote_or_demote)
+{
+    block_tuple block;
+    if (!accessor_.get(context, at_slot, block_tuple::read_from_delta, block))
+        return false;
 
     auto delta_data = std::make_shared<block_tuple_delta>();
-    delta_data->state = updated_state;
+    delta_data->state = update_confirmation_state(block.state,
+        promote_or_demote, candidate);
+
     if (!accessor_.update(context, at_slot, delta_data))
+        return false;
+
+    context.register_redo(table_id::block, redo_operation::update, hash,
+        *delta_data);
+    return true;
+}
+
+bool block_database::reorganize(transaction_context& context,
+    size_t fork_height, const hash_list& outgoing, const hash_list& incoming,
+    bool candidate)
+{
+    const auto& index = candidate ? candidate_index_ : confirmed_index_;
+    const auto& pending = candidate ? candidate_pending_ : confirmed_pending_;
+    const auto first = fork_height + 1;
+
+    // Outgoing must be exactly the blocks above the fork point, and
+    // incoming must fit the index.
+    if (incoming.size() > height_index_map::max_height ||
+        first > height_index_map::max_height - incoming.size() ||
+        !write_tip(context, candidate) ||
+        pending->size() != first + outgoing.size())
     {
         context.abort();
         return false;
     }
 
-    auto index = candidate ? candidate_index_ : confirmed_index_;
+    // Resolve every slot before writing anything.
+    std::vector<slot> outgoing_slots(outgoing.size());
+    for (size_t offset = 0; offset < outgoing.size(); ++offset)
+    {
+        slot by_hash;
+        if (!pending->find(*index, first + offset, outgoing_slots[offset]) ||
+            !find_hash(context, outgoing[offset], by_hash) ||
+            by_hash != outgoing_slots[offset])
+        {
+            context.abort();
+            return false;
+        }
+    }
 
-    // add to the selected index - promote
-    if (promote_or_demote)
-        return index->insert(height, at_slot);
+    std::vector<slot> incoming_slots(incoming.size());
+    for (size_t offset = 0; offset < incoming.size(); ++offset)
+    {
+        if (!find_hash(context, incoming[offset], incoming_slots[offset]))
+        {
+            context.abort();
+            return false;
+        }
+    }
 
-    // remove from the selected index - demote
-    return index->erase(height);
+    // Pop from the top down, then push from the fork up.
+    for (auto offset = outgoing.size(); offset > 0; --offset)
+    {
+        if (!update_state(context, outgoing[offset - 1],
+            outgoing_slots[offset - 1], candidate, false))
+        {
+            context.abort();
+            return false;
+        }
+    }
+
+    for (size_t offset = 0; offset < incoming.size(); ++offset)
+    {
+        if (!update_state(context, incoming[offset], incoming_slots[offset],
+            candidate, true))
+        {
+            context.abort();
+            return false;
+        }
+    }
+
+    // All deltas are in place, switch the index in one step. The
+    // switch is applied to the index at commit, dropped on abort.
+    pending->truncate(first);
+    for (size_t offset = 0; offset < incoming.size(); ++offset)
+    {
+        if (!pending->insert_or_assign(first + offset, incoming_slots[offset]))
+        {
+            context.abort();
+            return false;
+        }
+    }
+
+    return true;
 }
 
 bool block_database::promote(transaction_context& context,
@@ -246,24 +1271,26 @@ void block_database::get_header_metadata(transaction_context& context,
     header.metadata.median_time_past = read_block->median_time_past;
 }
 
+hash_digest_index_map::counters block_database::hash_lookup_counters() const
+{
+    return hash_digest_index_->lookup_counters();
+}
+
 bool block_database::validate(transaction_context& context,
     const system::hash_digest& hash, const system::code& error)
 {
-    block_tuple_ptr read_block;
+    block_tuple read_block;
     slot at_slot;
 
-    try
-    {
-        hash_digest_index_->find(hash, at_slot);
-        read_block = accessor_.get(context, at_slot, block_tuple::read_from_delta);
-    }
-    catch (std::out_of_range e)
+    if (!find_hash(context, hash, at_slot) ||
+        !accessor_.get(context, at_slot, block_tuple::read_from_delta,
+            read_block))
     {
         context.abort();
         return false;
     }
 
-    auto original = read_block->state;
+    auto original = read_block.state;
     const auto updated_state = update_validation_state(original, !error);
 
     auto delta_data = std::make_shared<block_tuple_delta>();
@@ -273,6 +1300,9 @@ bool block_database::validate(transaction_context& context,
         context.abort();
         return false;
     }
+
+    context.register_redo(table_id::block, redo_operation::update, hash,
+        *delta_data);
     return true;
 }
 
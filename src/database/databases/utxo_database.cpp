@@ -0,0 +1,759 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <utility>
+
+#include <bitcoin/database/databases/utxo_database.hpp>
+#include <bitcoin/database/durability/parallel_for.hpp>
+#include <bitcoin/database/storage/interleave.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+using namespace bc::system;
+using namespace chain;
+using namespace mvto;
+using namespace tuples;
+using namespace storage;
+using namespace durability;
+
+// Lookups in flight in multi_get and spend.
+static const size_t multi_get_width = 16;
+
+static const uint8_t op_return = 0x6a;
+
+// The outpoint of a record never changes, it is read without a
+// transaction.
+static outpoint_index_map::verifier point_verifier(utxo_store_ptr store)
+{
+    return [store](const slot& at_slot, const point& point)
+    {
+        const auto column = store->get_cold_at<utxo_cold_column>(at_slot);
+        return column->index == point.index() && column->hash == point.hash();
+    };
+}
+
+utxo_database::utxo_database(uint64_t utxo_size_limit,
+    uint64_t utxo_reuse_limit, uint64_t delta_size_limit,
+    uint64_t delta_reuse_limit)
+  : utxo_database(nullptr, utxo_size_limit, utxo_reuse_limit,
+      delta_size_limit, delta_reuse_limit)
+{
+}
+
+utxo_database::utxo_database(log_manager_ptr log, uint64_t utxo_size_limit,
+    uint64_t utxo_reuse_limit, uint64_t delta_size_limit,
+    uint64_t delta_reuse_limit)
+    : utxo_store_pool_(std::make_shared<block_pool>(utxo_size_limit, utxo_reuse_limit)),
+      utxo_store_(std::make_shared<storage::store<utxo_mvcc_record>>(
+          utxo_store_pool_, sizeof(utxo_cold_column))),
+      delta_store_pool_(std::make_shared<block_pool>(delta_size_limit, delta_reuse_limit)),
+      delta_store_(std::make_shared<storage::store<utxo_delta_mvcc_record>>(delta_store_pool_)),
+      accessor_(utxo_mvto_accessor{utxo_store_, delta_store_}),
+      outpoint_index_(std::make_shared<outpoint_index_map>(
+          point_verifier(utxo_store_))),
+      script_overflow_(std::make_shared<script_overflow_map>()),
+      spent_latch_(std::make_shared<spinlatch>()),
+      spent_(std::make_shared<std::vector<spent_output>>()),
+      log_(log),
+      checkpointer_(log)
+{
+}
+
+// Outputs read from a checkpoint at a time, each batch is restored
+// across the recovery threads.
+static const size_t checkpoint_batch_size = 1 << 16;
+
+void utxo_database::reserve(size_t expected_count)
+{
+    outpoint_index_->reserve(expected_count);
+}
+
+bool utxo_database::create()
+{
+    return log_ == nullptr || (checkpointer_.create() && log_->create());
+}
+
+bool utxo_database::open()
+{
+    return open(std::max(1u, std::thread::hardware_concurrency()));
+}
+
+bool utxo_database::open(size_t threads)
+{
+    if (log_ == nullptr)
+        return true;
+
+    size_t segment;
+    const auto loaded = checkpointer_.load(
+        [this, threads](checkpoint_reader& reader)
+        {
+            return load(reader, threads);
+        }, segment);
+
+    if (!loaded)
+        return false;
+
+    const auto replayed = log_->replay(segment,
+        [this](timestamp_t, const redo_record& record)
+        {
+            transaction_context context(recovery_timestamp, state::active);
+            if (apply(context, record))
+                context.commit();
+            else
+                context.abort();
+        }, threads);
+
+    return replayed && log_->open();
+}
+
+void utxo_database::commit()
+{
+    if (log_ != nullptr)
+        log_->flush();
+}
+
+bool utxo_database::close()
+{
+    return log_ == nullptr || log_->close();
+}
+
+bool utxo_database::checkpoint(transaction_manager& manager)
+{
+    if (log_ == nullptr)
+        return false;
+
+    return checkpointer_.checkpoint(manager,
+        [this](checkpoint_writer& writer, timestamp_t snapshot)
+        {
+            return save(writer, snapshot);
+        });
+}
+
+// Section layout: table id, output count, then outpoint and output
+// tuple for each unspent output, followed by its script if that is
+// not inline.
+bool utxo_database::save(checkpoint_writer& writer,
+    timestamp_t snapshot) const
+{
+    if (!writer.write(table_id::utxo))
+        return false;
+
+    uint64_t count = 0;
+    const auto count_position = writer.position();
+    if (!writer.write(count))
+        return false;
+
+    auto written = true;
+    data_chunk script;
+    for (const auto block: utxo_store_->get_blocks())
+    {
+        utxo_store_->for_each_in(block,
+            [&](const slot& at_slot, utxo_mvcc_record* record)
+            {
+                auto data = record->read_snapshot(snapshot,
+                    utxo_tuple::read_from_delta);
+                if (!written || data == utxo_mvcc_record::not_found ||
+                    data->state == utxo_tuple::spent)
+                    return;
+
+                const auto& column = cold(at_slot);
+                written = writer.write(column) && writer.write(*data);
+                if (written && !data->is_inline())
+                    written = script_overflow_->find(
+                        point{ column.hash, column.index }, script) &&
+                        writer.write(script.data(), script.size());
+
+                ++count;
+            });
+    }
+
+    return written && writer.write_at(count_position, count);
+}
+
+bool utxo_database::load(checkpoint_reader& reader, size_t threads)
+{
+    struct entry
+    {
+        utxo_cold_column outpoint;
+        utxo_tuple data;
+        data_chunk script;
+    };
+
+    table_id table;
+    uint64_t count;
+    if (!reader.read(table) || table != table_id::utxo || !reader.read(count))
+        return false;
+
+    // Size the index once, instead of growing it during the load.
+    outpoint_index_->reserve(count);
+
+    std::vector<entry> batch;
+    std::atomic<bool> restored(true);
+
+    for (uint64_t loaded = 0; loaded < count;)
+    {
+        const size_t size = std::min<uint64_t>(count - loaded,
+            checkpoint_batch_size);
+        batch.resize(size);
+
+        // Scripts that are not inline make entries variable in size,
+        // they are read one at a time.
+        for (auto& entry: batch)
+        {
+            if (!reader.read(entry.outpoint) || !reader.read(entry.data))
+                return false;
+
+            entry.script.resize(entry.data.is_inline() ? 0 :
+                entry.data.script_size);
+            if (!entry.script.empty() &&
+                !reader.read(entry.script.data(), entry.script.size()))
+                return false;
+        }
+
+        parallel_for(size, threads, [&](size_t begin, size_t end)
+        {
+            transaction_context context(recovery_timestamp, state::active);
+            for (auto index = begin; index < end; ++index)
+            {
+                auto& entry = batch[index];
+                const point outpoint{ entry.outpoint.hash,
+                    entry.outpoint.index };
+
+                if (!restore(context, outpoint, entry.data,
+                    std::move(entry.script)))
+                {
+                    restored = false;
+                    context.abort();
+                    return;
+                }
+            }
+
+            context.commit();
+        });
+
+        if (!restored)
+            return false;
+
+        loaded += size;
+    }
+
+    return true;
+}
+
+bool utxo_database::restore(transaction_context& context,
+    const point& point, const utxo_tuple& data, data_chunk&& script)
+{
+    const auto at_slot = accessor_.put(context,
+        std::make_shared<utxo_tuple>(data));
+    if (!at_slot)
+        return false;
+
+    cold(at_slot) = { point.hash(), point.index() };
+    if (!outpoint_index_->insert(point, at_slot))
+        return false;
+
+    if (!data.is_inline())
+        script_overflow_->insert(point, std::move(script));
+
+    return true;
+}
+
+bool utxo_database::apply(transaction_context& context,
+    const redo_record& record)
+{
+    utxo_cold_column outpoint;
+    if (record.table != table_id::utxo ||
+        record.key_size != sizeof(outpoint))
+        return false;
+
+    std::memcpy(&outpoint, record.key, sizeof(outpoint));
+    const point point{ outpoint.hash, outpoint.index };
+
+    slot at_slot;
+    const auto exists = outpoint_index_->find(point, at_slot);
+
+    if (record.operation == redo_operation::insert)
+    {
+        if (exists)
+            return true;
+
+        // The value is the tuple, then the script if it is not inline.
+        utxo_tuple data;
+        if (record.value_size < sizeof(data))
+            return false;
+
+        std::memcpy(&data, record.value, sizeof(data));
+        data_chunk script(record.value + sizeof(data),
+            record.value + record.value_size);
+        if (!data.is_inline() && script.size() != data.script_size)
+            return false;
+
+        return restore(context, point, data, std::move(script));
+    }
+
+    // No transaction reads a snapshot before recovery, so a spent
+    // output is reclaimed at once. The spend is still applied, so the
+    // record is not saved to the next checkpoint.
+    auto delta_data = std::make_shared<utxo_tuple_delta>();
+    if (!exists || !record.read_value(*delta_data) ||
+        delta_data->state != utxo_tuple::spent ||
+        !accessor_.update(context, at_slot, delta_data))
+        return false;
+
+    outpoint_index_->erase(point, at_slot);
+    script_overflow_->erase(point);
+    return true;
+}
+
+size_t utxo_database::reclaim(const transaction_manager& manager)
+{
+    const auto oldest = manager.oldest_active();
+
+    std::vector<spent_output> reclaimable;
+    {
+        scopedspinlatch guard(spent_latch_);
+        const auto end = std::partition(spent_->begin(), spent_->end(),
+            [oldest](const spent_output& output)
+            {
+                return output.timestamp >= oldest;
+            });
+
+        reclaimable.assign(end, spent_->end());
+        spent_->erase(end, spent_->end());
+    }
+
+    // Every transaction that reads these outputs sees them spent, so
+    // it reads the same with them missing.
+    for (const auto& output: reclaimable)
+    {
+        const auto& column = cold(output.at_slot);
+        const point outpoint{ column.hash, column.index };
+
+        outpoint_index_->erase(outpoint, output.at_slot);
+        if (output.long_script)
+            script_overflow_->erase(outpoint);
+    }
+
+    return reclaimable.size();
+}
+
+size_t utxo_database::size() const
+{
+    return outpoint_index_->size();
+}
+
+size_t utxo_database::index_bytes() const
+{
+    return outpoint_index_->bytes();
+}
+
+utxo_cold_column& utxo_database::cold(const slot& at_slot) const
+{
+    return *utxo_store_->get_cold_at<utxo_cold_column>(at_slot);
+}
+
+// An output script starting with op_return can never be spent.
+static bool is_unspendable(const data_chunk& script)
+{
+    return !script.empty() && script.front() == op_return;
+}
+
+static void to_tuple(const output& output, uint32_t height,
+    const data_chunk& script, utxo_tuple& data)
+{
+    data.value = output.value();
+    data.height = height;
+    data.script_size = static_cast<uint32_t>(script.size());
+    data.state = utxo_tuple::unspent;
+
+    if (data.is_inline())
+        std::memcpy(data.script, script.data(), script.size());
+}
+
+// Log the output with its script, if that is not inline.
+static void register_store(transaction_context& context, const point& point,
+    const utxo_tuple& data, const data_chunk& script)
+{
+    const utxo_cold_column outpoint{ point.hash(), point.index() };
+    if (data.is_inline())
+    {
+        context.register_redo(table_id::utxo, redo_operation::insert,
+            outpoint, data);
+        return;
+    }
+
+    data_chunk value(sizeof(data) + script.size());
+    std::memcpy(value.data(), &data, sizeof(data));
+    std::memcpy(value.data() + sizeof(data), script.data(), script.size());
+    context.register_redo(table_id::utxo, redo_operation::insert, outpoint,
+        value.data(), static_cast<uint32_t>(value.size()));
+}
+
+bool utxo_database::index(transaction_context& context,
+    const point::list& points, const std::vector<slot>& slots)
+{
+    const auto index = outpoint_index_;
+
+    // Only entries still at their slot are erased, so an entry of the
+    // same point stored before is left alone. The transaction abort
+    // leaves the records themselves unreadable.
+    context.register_abort_action([index, points, slots]()
+    {
+        for (size_t entry = 0; entry < slots.size(); ++entry)
+            index->erase(points[entry], slots[entry]);
+    });
+
+    // The index verifies keys against the outpoint, so it is written
+    // before any entry.
+    for (size_t entry = 0; entry < slots.size(); ++entry)
+        cold(slots[entry]) = { points[entry].hash(), points[entry].index() };
+
+    for (size_t entry = 0; entry < slots.size(); ++entry)
+    {
+        if (!outpoint_index_->insert(points[entry], slots[entry]))
+        {
+            context.abort();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Called once every point is indexed, so none of these is taken.
+static void store_scripts(transaction_context& context,
+    std::shared_ptr<script_overflow_map> scripts, point::list&& points,
+    std::vector<data_chunk>&& datas)
+{
+    if (points.empty())
+        return;
+
+    for (size_t entry = 0; entry < points.size(); ++entry)
+        scripts->insert(points[entry], std::move(datas[entry]));
+
+    context.register_abort_action([scripts, points]()
+    {
+        for (const auto& point: points)
+            scripts->erase(point);
+    });
+}
+
+bool utxo_database::store(transaction_context& context, const point& point,
+    const output& output, uint32_t height)
+{
+    auto script = output.script().to_data(false);
+    auto data = std::make_shared<utxo_tuple>();
+    to_tuple(output, height, script, *data);
+
+    const auto result_slot = accessor_.put(context, data);
+    if (!result_slot)
+    {
+        context.abort();
+        return false;
+    }
+
+    if (!index(context, { point }, { result_slot }))
+        return false;
+
+    register_store(context, point, *data, script);
+    if (!data->is_inline())
+        store_scripts(context, script_overflow_, { point }, { script });
+
+    return true;
+}
+
+bool utxo_database::store(transaction_context& context, const block& block,
+    uint32_t height)
+{
+    point::list points;
+    std::vector<utxo_tuple> tuples;
+    point::list long_points;
+    std::vector<data_chunk> long_scripts;
+
+    for (const auto& tx: block.transactions())
+    {
+        const auto hash = tx.hash();
+        const auto& outputs = tx.outputs();
+        for (uint32_t index = 0; index < outputs.size(); ++index)
+        {
+            auto script = outputs[index].script().to_data(false);
+            if (is_unspendable(script))
+                continue;
+
+            points.emplace_back(hash, index);
+            tuples.emplace_back();
+            to_tuple(outputs[index], height, script, tuples.back());
+
+            if (tuples.back().is_inline())
+                continue;
+
+            long_points.push_back(points.back());
+            long_scripts.push_back(std::move(script));
+        }
+    }
+
+    std::vector<slot> slots(tuples.size());
+    if (!accessor_.put(context, tuples.data(), tuples.size(), slots.data()))
+    {
+        context.abort();
+        return false;
+    }
+
+    if (!index(context, points, slots))
+        return false;
+
+    // Long scripts are in the order of their outputs.
+    static const data_chunk inline_script;
+    for (size_t entry = 0, script = 0; entry < points.size(); ++entry)
+        register_store(context, points[entry], tuples[entry],
+            tuples[entry].is_inline() ? inline_script :
+                long_scripts[script++]);
+
+    store_scripts(context, script_overflow_, std::move(long_points),
+        std::move(long_scripts));
+    return true;
+}
+
+bool utxo_database::get_script(const point& point, const utxo_tuple& output,
+    data_chunk& out) const
+{
+    if (output.is_inline())
+    {
+        out.assign(output.script, output.script + output.script_size);
+        return true;
+    }
+
+    return script_overflow_->find(point, out);
+}
+
+utxo_tuple_ptr utxo_database::get(transaction_context& context,
+    const point& point) const
+{
+    slot at_slot;
+    auto output = std::make_shared<utxo_tuple>();
+    if (!outpoint_index_->find(point, at_slot) ||
+        !accessor_.get(context, at_slot, utxo_tuple::read_from_delta,
+            *output) || output->state == utxo_tuple::spent)
+    {
+        context.abort();
+        return nullptr;
+    }
+
+    return output;
+}
+
+// Each step ends by prefetching what the next one reads. A lookup
+// without an output stops once it has the slot.
+class utxo_database::point_lookup
+{
+public:
+    void start(const utxo_database& database, transaction_context& context,
+        const point& point, slot& at_slot, utxo_tuple_ptr* out)
+    {
+        database_ = &database;
+        context_ = &context;
+        point_ = &point;
+        slot_ = &at_slot;
+        out_ = out;
+        state_ = state::probe;
+    }
+
+    bool step()
+    {
+        const auto& index = database_->outpoint_index_;
+        const auto& accessor = database_->accessor_;
+
+        switch (state_)
+        {
+            case state::probe:
+                index->prefetch(*point_);
+                state_ = state::find;
+                return true;
+
+            // The cold column the index verifies against is not known
+            // until the key is found, a second locked probe for it costs
+            // more than the miss.
+            case state::find:
+                if (!index->find(*point_, *slot_))
+                    return false;
+
+                accessor.prefetch(*slot_, false);
+                state_ = state::delta;
+                return out_ != nullptr;
+
+            case state::delta:
+                accessor.prefetch(*slot_, true);
+                state_ = state::read;
+                return true;
+
+            case state::read:
+            {
+                auto output = std::make_shared<utxo_tuple>();
+                if (accessor.get(*context_, *slot_,
+                    utxo_tuple::read_from_delta, *output) &&
+                    output->state == utxo_tuple::unspent)
+                    *out_ = output;
+
+                return false;
+            }
+        }
+
+        return false;
+    }
+
+private:
+    enum class state
+    {
+        probe,
+        find,
+        delta,
+        read
+    };
+
+    const utxo_database* database_;
+    transaction_context* context_;
+    const point* point_;
+    slot* slot_;
+    utxo_tuple_ptr* out_;
+    state state_;
+};
+
+size_t utxo_database::multi_get(transaction_context& context,
+    const point::list& points, std::vector<utxo_tuple_ptr>& out) const
+{
+    return multi_get(context, points, out, multi_get_width);
+}
+
+size_t utxo_database::multi_get(transaction_context& context,
+    const point::list& points, std::vector<utxo_tuple_ptr>& out,
+    size_t width) const
+{
+    out.assign(points.size(), nullptr);
+    std::vector<slot> slots(points.size());
+
+    interleave<point_lookup>(points.size(), width,
+        [&](size_t index, point_lookup& lookup)
+        {
+            lookup.start(*this, context, points[index], slots[index],
+                &out[index]);
+        });
+
+    return std::count_if(out.begin(), out.end(),
+        [](const utxo_tuple_ptr& output)
+        {
+            return output != nullptr;
+        });
+}
+
+bool utxo_database::spend(transaction_context& context, const slot& at_slot,
+    std::vector<spent_output>& spent)
+{
+    utxo_tuple output;
+    if (!accessor_.get(context, at_slot, utxo_tuple::read_from_delta,
+        output) || output.state == utxo_tuple::spent)
+        return false;
+
+    auto delta_data = std::make_shared<utxo_tuple_delta>();
+    delta_data->state = utxo_tuple::spent;
+
+    auto head = at_slot;
+    if (!accessor_.update(context, head, delta_data))
+        return false;
+
+    context.register_redo(table_id::utxo, redo_operation::update,
+        cold(at_slot), *delta_data);
+    spent.push_back({ at_slot, context.get_timestamp(),
+        !output.is_inline() });
+    return true;
+}
+
+void utxo_database::register_spent(transaction_context& context,
+    std::vector<spent_output>&& spent)
+{
+    const auto latch = spent_latch_;
+    const auto outputs = spent_;
+
+    context.register_commit_action([latch, outputs, spent]()
+    {
+        scopedspinlatch guard(latch);
+        outputs->insert(outputs->end(), spent.begin(), spent.end());
+    });
+}
+
+bool utxo_database::spend(transaction_context& context, const point& point)
+{
+    slot at_slot;
+    std::vector<spent_output> spent;
+    if (!outpoint_index_->find(point, at_slot) ||
+        !spend(context, at_slot, spent))
+    {
+        context.abort();
+        return false;
+    }
+
+    register_spent(context, std::move(spent));
+    return true;
+}
+
+bool utxo_database::spend(transaction_context& context,
+    const point::list& points)
+{
+    std::vector<slot> slots(points.size());
+
+    interleave<point_lookup>(points.size(), multi_get_width,
+        [&](size_t index, point_lookup& lookup)
+        {
+            lookup.start(*this, context, points[index], slots[index],
+                nullptr);
+        });
+
+    // Every slot is resolved before any delta is written.
+    std::vector<spent_output> spent;
+    spent.reserve(slots.size());
+    for (const auto& at_slot: slots)
+    {
+        if (!at_slot || !spend(context, at_slot, spent))
+        {
+            context.abort();
+            return false;
+        }
+    }
+
+    register_spent(context, std::move(spent));
+    return true;
+}
+
+bool utxo_database::spend(transaction_context& context, const block& block)
+{
+    point::list points;
+    const auto& transactions = block.transactions();
+    for (size_t tx = 1; tx < transactions.size(); ++tx)
+        for (const auto& input: transactions[tx].inputs())
+            points.push_back(input.previous_output());
+
+    return spend(context, points);
+}
+
+} // namespace database
+} // namespace libbitcoin
@@ -0,0 +1,176 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/database/durability/checkpoint_file.hpp>
+
+#include <cstdio>
+#include <filesystem>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace libbitcoin {
+namespace database {
+namespace durability {
+
+static const int closed_file = -1;
+
+// Bytes buffered before each write to the file.
+static const size_t buffer_size = 1 << 20;
+
+checkpoint_writer::checkpoint_writer(const std::string& path)
+  : path_(path), temporary_path_(path + ".tmp"), file_(closed_file),
+    position_(0)
+{
+}
+
+checkpoint_writer::~checkpoint_writer()
+{
+    if (file_ == closed_file)
+        return;
+
+    ::close(file_);
+    std::remove(temporary_path_.c_str());
+}
+
+bool checkpoint_writer::open(timestamp_t snapshot, size_t segment)
+{
+    file_ = ::open(temporary_path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC,
+        0644);
+    if (file_ == closed_file)
+        return false;
+
+    buffer_.reserve(buffer_size);
+    const uint32_t reserved = 0;
+    const uint64_t first_segment = segment;
+    return write(checkpoint_magic) && write(reserved) && write(snapshot) &&
+        write(first_segment);
+}
+
+bool checkpoint_writer::write(const uint8_t* data, size_t size)
+{
+    buffer_.insert(buffer_.end(), data, data + size);
+    position_ += size;
+    return buffer_.size() < buffer_size || flush_buffer();
+}
+
+bool checkpoint_writer::write_at(uint64_t position, const uint8_t* data,
+    size_t size)
+{
+    if (!flush_buffer())
+        return false;
+
+    size_t written = 0;
+    while (written < size)
+    {
+        const auto result = ::pwrite(file_, data + written, size - written,
+            position + written);
+        if (result < 0)
+            return false;
+
+        written += result;
+    }
+
+    return true;
+}
+
+uint64_t checkpoint_writer::position() const
+{
+    return position_;
+}
+
+bool checkpoint_writer::flush_buffer()
+{
+    size_t written = 0;
+    while (written < buffer_.size())
+    {
+        const auto result = ::write(file_, buffer_.data() + written,
+            buffer_.size() - written);
+        if (result < 0)
+            return false;
+
+        written += result;
+    }
+
+    buffer_.clear();
+    return true;
+}
+
+bool checkpoint_writer::commit()
+{
+    if (!flush_buffer() || ::fdatasync(file_) != 0)
+        return false;
+
+    ::close(file_);
+    file_ = closed_file;
+    if (std::rename(temporary_path_.c_str(), path_.c_str()) != 0)
+        return false;
+
+    // Sync the directory so the rename itself is durable.
+    const auto parent = std::filesystem::path(path_).parent_path();
+    const auto directory = ::open(parent.empty() ? "." : parent.c_str(),
+        O_RDONLY);
+    if (directory == closed_file)
+        return false;
+
+    const auto synced = ::fsync(directory) == 0;
+    ::close(directory);
+    return synced;
+}
+
+checkpoint_reader::checkpoint_reader(const std::string& path)
+  : path_(path), snapshot_(0), segment_(0)
+{
+}
+
+bool checkpoint_reader::open()
+{
+    file_.open(path_, std::ios::binary);
+    if (!file_)
+        return false;
+
+    uint32_t magic;
+    uint32_t reserved;
+    uint64_t segment;
+    if (!read(magic) || !read(reserved) || !read(snapshot_) ||
+        !read(segment) || magic != checkpoint_magic)
+        return false;
+
+    segment_ = segment;
+    return true;
+}
+
+timestamp_t checkpoint_reader::snapshot() const
+{
+    return snapshot_;
+}
+
+size_t checkpoint_reader::segment() const
+{
+    return segment_;
+}
+
+bool checkpoint_reader::read(uint8_t* data, size_t size)
+{
+    file_.read(reinterpret_cast<char*>(data), size);
+    return static_cast<size_t>(file_.gcount()) == size;
+}
+
+} // namespace durability
+} // namespace database
+} // namespace libbitcoin
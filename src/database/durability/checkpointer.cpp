@@ -0,0 +1,137 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/database/durability/checkpointer.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <vector>
+
+namespace libbitcoin {
+namespace database {
+namespace durability {
+
+static const std::string checkpoint_prefix = "checkpoint_";
+static const std::string checkpoint_suffix = ".dat";
+
+// Segment numbers of the checkpoints in directory, in ascending order.
+static std::vector<size_t> list_checkpoints(const std::string& directory)
+{
+    std::vector<size_t> checkpoints;
+    std::error_code ec;
+
+    for (const auto& entry: std::filesystem::directory_iterator(directory, ec))
+    {
+        const auto name = entry.path().filename().string();
+        if (name.size() <= checkpoint_prefix.size() + checkpoint_suffix.size() ||
+            name.compare(0, checkpoint_prefix.size(), checkpoint_prefix) != 0 ||
+            name.compare(name.size() - checkpoint_suffix.size(),
+                checkpoint_suffix.size(), checkpoint_suffix) != 0)
+            continue;
+
+        const auto number = name.substr(checkpoint_prefix.size(),
+            name.size() - checkpoint_prefix.size() - checkpoint_suffix.size());
+        if (!std::all_of(number.begin(), number.end(), ::isdigit))
+            continue;
+
+        checkpoints.push_back(std::stoull(number));
+    }
+
+    std::sort(checkpoints.begin(), checkpoints.end());
+    return checkpoints;
+}
+
+checkpointer::checkpointer(log_manager_ptr log)
+  : log_(log)
+{
+}
+
+std::string checkpointer::checkpoint_path(size_t segment) const
+{
+    return (std::filesystem::path(log_->directory()) /
+        (checkpoint_prefix + std::to_string(segment) +
+            checkpoint_suffix)).string();
+}
+
+bool checkpointer::create()
+{
+    std::error_code ec;
+    for (const auto segment: list_checkpoints(log_->directory()))
+        if (!std::filesystem::remove(checkpoint_path(segment), ec))
+            return false;
+
+    return true;
+}
+
+bool checkpointer::checkpoint(transaction_manager& manager,
+    const checkpoint_saver& save)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Every frame before segment is installed once the wait is over,
+    // and the snapshot is taken after, so it sees all of them.
+    const auto segment = log_->rotate();
+    if (log_->is_failed())
+        return false;
+
+    log_->wait_for_commits(segment);
+
+    auto context = manager.begin_transaction();
+    const auto snapshot = context.get_timestamp();
+
+    checkpoint_writer writer(checkpoint_path(segment));
+    const auto written = writer.open(snapshot, segment) &&
+        save(writer, snapshot) && writer.commit();
+
+    // The snapshot context wrote nothing, it only ends the snapshot,
+    // and is removed so it does not hold back the oldest active.
+    context.commit();
+    manager.remove_transaction(context);
+
+    if (!written)
+        return false;
+
+    std::error_code ec;
+    for (const auto previous: list_checkpoints(log_->directory()))
+        if (previous < segment)
+            std::filesystem::remove(checkpoint_path(previous), ec);
+
+    return log_->truncate(segment);
+}
+
+bool checkpointer::load(const checkpoint_loader& load, size_t& segment) const
+{
+    const auto checkpoints = list_checkpoints(log_->directory());
+    if (checkpoints.empty())
+    {
+        segment = 0;
+        return true;
+    }
+
+    checkpoint_reader reader(checkpoint_path(checkpoints.back()));
+    if (!reader.open() || !load(reader))
+        return false;
+
+    segment = reader.segment();
+    return true;
+}
+
+} // namespace durability
+} // namespace database
+} // namespace libbitcoin
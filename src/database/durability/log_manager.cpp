@@ -0,0 +1,488 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <bitcoin/database/durability/log_manager.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <boost/crc.hpp>
+
+#include <bitcoin/database/durability/parallel_for.hpp>
+
+namespace libbitcoin {
+namespace database {
+namespace durability {
+
+using namespace bc::system;
+
+static const std::string segment_prefix = "redo_";
+static const std::string segment_suffix = ".log";
+static const int closed_file = -1;
+
+static uint32_t frame_checksum(timestamp_t timestamp, const uint8_t* payload,
+    size_t size)
+{
+    boost::crc_32_type crc;
+    crc.process_bytes(&timestamp, sizeof(timestamp));
+    crc.process_bytes(payload, size);
+    return crc.checksum();
+}
+
+// Segment numbers found in directory, in ascending order.
+static std::vector<size_t> list_segments(const std::string& directory)
+{
+    std::vector<size_t> segments;
+    std::error_code ec;
+
+    for (const auto& entry: std::filesystem::directory_iterator(directory, ec))
+    {
+        const auto name = entry.path().filename().string();
+        if (name.size() <= segment_prefix.size() + segment_suffix.size() ||
+            name.compare(0, segment_prefix.size(), segment_prefix) != 0 ||
+            name.compare(name.size() - segment_suffix.size(),
+                segment_suffix.size(), segment_suffix) != 0)
+            continue;
+
+        const auto number = name.substr(segment_prefix.size(),
+            name.size() - segment_prefix.size() - segment_suffix.size());
+        if (!std::all_of(number.begin(), number.end(), ::isdigit))
+            continue;
+
+        segments.push_back(std::stoull(number));
+    }
+
+    std::sort(segments.begin(), segments.end());
+    return segments;
+}
+
+log_manager::log_manager(const std::string& directory,
+    std::chrono::microseconds flush_interval, size_t flush_bytes,
+    bool synchronous)
+  : directory_(directory), flush_interval_(flush_interval),
+    flush_bytes_(flush_bytes), synchronous_(synchronous),
+    latch_(std::make_shared<spinlatch>()), appended_lsn_(0),
+    file_(closed_file), segment_(0), durable_lsn_(0), failed_(false),
+    stopped_(true)
+{
+}
+
+log_manager::~log_manager()
+{
+    close();
+}
+
+const std::string& log_manager::directory() const
+{
+    return directory_;
+}
+
+std::string log_manager::segment_path(size_t segment) const
+{
+    return (std::filesystem::path(directory_) /
+        (segment_prefix + std::to_string(segment) + segment_suffix)).string();
+}
+
+bool log_manager::create()
+{
+    std::error_code ec;
+    std::filesystem::create_directories(directory_, ec);
+    if (ec)
+        return false;
+
+    for (const auto segment: list_segments(directory_))
+        std::filesystem::remove(segment_path(segment), ec);
+
+    return open_segment(0);
+}
+
+bool log_manager::open()
+{
+    const auto segments = list_segments(directory_);
+
+    // Never append after a possibly torn tail, start a new segment.
+    const auto next = segments.empty() ? 0 : segments.back() + 1;
+    return open_segment(next);
+}
+
+bool log_manager::open_segment(size_t segment)
+{
+    if (!stopped_)
+        return false;
+
+    file_ = ::open(segment_path(segment).c_str(),
+        O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (file_ == closed_file)
+        return false;
+
+    segment_ = segment;
+    stopped_ = false;
+    flusher_ = std::thread(&log_manager::run_flusher, this);
+    return true;
+}
+
+bool log_manager::close()
+{
+    if (stopped_.exchange(true))
+        return true;
+
+    {
+        std::lock_guard<std::mutex> lock(wait_mutex_);
+        flush_requested_.notify_one();
+    }
+
+    flusher_.join();
+    flush();
+    close_segment();
+    return !failed_;
+}
+
+void log_manager::close_segment()
+{
+    if (file_ == closed_file)
+        return;
+
+    ::close(file_);
+    file_ = closed_file;
+}
+
+log_sequence_number log_manager::append(timestamp_t timestamp,
+    const data_chunk& payload)
+{
+    size_t segment;
+    const auto lsn = append(timestamp, payload, segment);
+    if (lsn != 0)
+        release(segment);
+
+    return lsn;
+}
+
+log_sequence_number log_manager::append(timestamp_t timestamp,
+    const data_chunk& payload, size_t& segment)
+{
+    uint8_t header[commit_frame_header_size];
+    const uint32_t size = payload.size();
+    const auto checksum = frame_checksum(timestamp, payload.data(), size);
+    std::memcpy(header, &size, sizeof(size));
+    std::memcpy(header + 4, &checksum, sizeof(checksum));
+    std::memcpy(header + 8, &timestamp, sizeof(timestamp));
+
+    log_sequence_number lsn;
+    size_t pending;
+    {
+        scopedspinlatch guard(latch_);
+
+        // Nothing appended now would ever be written.
+        if (failed_ || stopped_)
+            return 0;
+
+        pending_.insert(pending_.end(), header,
+            header + commit_frame_header_size);
+        pending_.insert(pending_.end(), payload.begin(), payload.end());
+        appended_lsn_ += commit_frame_header_size + size;
+        lsn = appended_lsn_;
+        pending = pending_.size();
+        segment = segment_;
+        ++inflight_[segment];
+    }
+
+    // Enough has accumulated, do not wait out the interval.
+    if (pending >= flush_bytes_)
+        flush_requested_.notify_one();
+
+    return lsn;
+}
+
+void log_manager::release(size_t segment)
+{
+    scopedspinlatch guard(latch_);
+    const auto it = inflight_.find(segment);
+    BITCOIN_ASSERT_MSG(it != inflight_.end(), "Released an unknown commit");
+
+    if (--it->second == 0)
+        inflight_.erase(it);
+}
+
+size_t log_manager::rotate()
+{
+    std::lock_guard<std::mutex> lock(write_mutex_);
+
+    const auto next = segment_ + 1;
+    const auto file = failed_ ? closed_file : ::open(
+        segment_path(next).c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (file == closed_file)
+    {
+        fail();
+        return segment_;
+    }
+
+    // Frames pending now finish the current segment, later appends
+    // count against and are written to the next.
+    log_sequence_number lsn;
+    {
+        scopedspinlatch guard(latch_);
+        writing_.swap(pending_);
+        lsn = appended_lsn_;
+        segment_ = next;
+    }
+
+    write_writing(lsn);
+    close_segment();
+    file_ = file;
+    return next;
+}
+
+void log_manager::wait_for_commits(size_t segment)
+{
+    while (true)
+    {
+        {
+            scopedspinlatch guard(latch_);
+            if (inflight_.empty() || inflight_.begin()->first >= segment)
+                return;
+        }
+
+        // Commits in flight are only installing versions, they finish
+        // without waiting on anything.
+        std::this_thread::yield();
+    }
+}
+
+bool log_manager::truncate(size_t segment)
+{
+    std::error_code ec;
+    for (const auto existing: list_segments(directory_))
+    {
+        if (existing >= segment)
+            break;
+
+        if (!std::filesystem::remove(segment_path(existing), ec))
+            return false;
+    }
+
+    return true;
+}
+
+bool log_manager::wait(log_sequence_number lsn)
+{
+    if (!synchronous_)
+        return !failed_;
+
+    std::unique_lock<std::mutex> lock(wait_mutex_);
+    flushed_.wait(lock, [this, lsn]()
+    {
+        return durable_lsn_.load() >= lsn || failed_.load() ||
+            stopped_.load();
+    });
+
+    return durable_lsn_.load() >= lsn;
+}
+
+void log_manager::flush()
+{
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        write_pending();
+    }
+
+    std::lock_guard<std::mutex> lock(wait_mutex_);
+    flushed_.notify_all();
+}
+
+void log_manager::run_flusher()
+{
+    while (!stopped_)
+    {
+        {
+            std::unique_lock<std::mutex> lock(wait_mutex_);
+            flush_requested_.wait_for(lock, flush_interval_);
+        }
+
+        flush();
+    }
+}
+
+void log_manager::write_pending()
+{
+    // The buffer of a failed write is never swapped back and retried
+    // after newer frames, nor written a second time.
+    if (failed_)
+        return;
+
+    log_sequence_number lsn;
+    {
+        scopedspinlatch guard(latch_);
+        writing_.swap(pending_);
+        lsn = appended_lsn_;
+    }
+
+    write_writing(lsn);
+}
+
+void log_manager::write_writing(log_sequence_number lsn)
+{
+    if (failed_ || writing_.empty() || file_ == closed_file)
+        return;
+
+    size_t written = 0;
+    while (written < writing_.size())
+    {
+        const auto result = ::write(file_, writing_.data() + written,
+            writing_.size() - written);
+
+        if (result < 0 && errno == EINTR)
+            continue;
+
+        if (result < 0)
+        {
+            fail();
+            return;
+        }
+
+        written += result;
+    }
+
+    if (::fdatasync(file_) != 0)
+    {
+        fail();
+        return;
+    }
+
+    writing_.clear();
+    durable_lsn_.store(lsn);
+}
+
+void log_manager::fail()
+{
+    std::lock_guard<std::mutex> lock(wait_mutex_);
+    failed_.store(true);
+    flushed_.notify_all();
+}
+
+log_sequence_number log_manager::durable_lsn() const
+{
+    return durable_lsn_.load();
+}
+
+bool log_manager::is_synchronous() const
+{
+    return synchronous_;
+}
+
+bool log_manager::is_failed() const
+{
+    return failed_.load();
+}
+
+bool log_manager::replay(size_t from_segment,
+    const redo_handler& handler) const
+{
+    return replay(from_segment, handler, 1);
+}
+
+bool log_manager::replay(size_t from_segment, const redo_handler& handler,
+    size_t threads) const
+{
+    typedef std::pair<timestamp_t, redo_record> entry;
+    threads = std::max<size_t>(threads, 1);
+
+    for (const auto segment: list_segments(directory_))
+    {
+        if (segment < from_segment)
+            continue;
+
+        std::ifstream file(segment_path(segment), std::ios::binary);
+        if (!file)
+            return false;
+
+        const data_chunk data((std::istreambuf_iterator<char>(file)),
+            std::istreambuf_iterator<char>());
+
+        // Records point into data, which outlives the partitions.
+        std::vector<std::vector<entry>> partitions(threads);
+
+        size_t position = 0;
+        while (position + commit_frame_header_size <= data.size())
+        {
+            uint32_t size;
+            uint32_t checksum;
+            timestamp_t timestamp;
+            std::memcpy(&size, data.data() + position, sizeof(size));
+            std::memcpy(&checksum, data.data() + position + 4,
+                sizeof(checksum));
+            std::memcpy(&timestamp, data.data() + position + 8,
+                sizeof(timestamp));
+
+            const auto payload = data.data() + position +
+                commit_frame_header_size;
+            const auto end = position + commit_frame_header_size + size;
+
+            // A torn frame ends a segment written up to a crash, the
+            // log continues in the segment opened by the next start.
+            if (end > data.size() ||
+                frame_checksum(timestamp, payload, size) != checksum)
+                break;
+
+            size_t offset = 0;
+            while (offset < size)
+            {
+                redo_record record;
+                size_t used;
+                if (!read_redo_record(payload + offset, size - offset,
+                    record, used))
+                    return false;
+
+                const auto key = std::string_view(
+                    reinterpret_cast<const char*>(record.key),
+                    record.key_size);
+                const auto partition = threads == 1 ? 0 :
+                    std::hash<std::string_view>{}(key) % threads;
+
+                partitions[partition].emplace_back(timestamp, record);
+                offset += used;
+            }
+
+            position = end;
+        }
+
+        parallel_for(threads, threads, [&](size_t begin, size_t end)
+        {
+            for (auto partition = begin; partition < end; ++partition)
+                for (const auto& entry: partitions[partition])
+                    handler(entry.first, entry.second);
+        });
+    }
+
+    return true;
+}
+
+} // namespace durability
+} // namespace database
+} // namespace libbitcoin
@@ -0,0 +1,94 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/database/durability/thread_pool.hpp>
+
+#include <algorithm>
+#include <utility>
+
+namespace libbitcoin {
+namespace database {
+namespace durability {
+
+thread_pool& thread_pool::shared()
+{
+    static thread_pool pool(std::max(2u,
+        std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+thread_pool::thread_pool(size_t workers)
+  : stopped_(false)
+{
+    for (size_t worker = 0; worker < workers; ++worker)
+        workers_.emplace_back(&thread_pool::run, this);
+}
+
+thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = true;
+    }
+
+    ready_.notify_all();
+    for (auto& worker: workers_)
+        worker.join();
+}
+
+void thread_pool::post(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+
+    ready_.notify_one();
+}
+
+size_t thread_pool::size() const
+{
+    return workers_.size();
+}
+
+void thread_pool::run()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ready_.wait(lock, [this]()
+            {
+                return stopped_ || !tasks_.empty();
+            });
+
+            if (tasks_.empty())
+                return;
+
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+
+        task();
+    }
+}
+
+} // namespace durability
+} // namespace database
+} // namespace libbitcoin
@@ -0,0 +1,104 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <bitcoin/database/transaction_management/action_log.hpp>
+
+namespace libbitcoin {
+namespace database {
+
+action_log::action_log()
+  : size_(0)
+{
+}
+
+action_log::action_log(const action_log& other)
+  : inline_(other.inline_), size_(other.size_)
+{
+    for (const auto& from: other.chunks_)
+        chunks_.emplace_back(std::make_unique<chunk>(*from));
+}
+
+action_log& action_log::operator=(const action_log& other)
+{
+    if (this == &other)
+        return *this;
+
+    inline_ = other.inline_;
+    size_ = other.size_;
+    chunks_.clear();
+    for (const auto& from: other.chunks_)
+        chunks_.emplace_back(std::make_unique<chunk>(*from));
+
+    return *this;
+}
+
+void action_log::push_back(const version_action& action)
+{
+    if (size_ < inline_capacity)
+    {
+        inline_[size_++] = action;
+        return;
+    }
+
+    const auto position = size_ - inline_capacity;
+    const auto chunk_index = position / chunk_capacity;
+
+    // Chunks are kept on clear, so a reused log does not allocate.
+    if (chunk_index == chunks_.size())
+        chunks_.emplace_back(std::make_unique<chunk>());
+
+    (*chunks_[chunk_index])[position % chunk_capacity] = action;
+    ++size_;
+}
+
+size_t action_log::size() const
+{
+    return size_;
+}
+
+bool action_log::empty() const
+{
+    return size_ == 0;
+}
+
+void action_log::clear()
+{
+    size_ = 0;
+}
+
+version_action& action_log::operator[](size_t index)
+{
+    if (index < inline_capacity)
+        return inline_[index];
+
+    const auto position = index - inline_capacity;
+    return (*chunks_[position / chunk_capacity])[position % chunk_capacity];
+}
+
+const version_action& action_log::operator[](size_t index) const
+{
+    if (index < inline_capacity)
+        return inline_[index];
+
+    const auto position = index - inline_capacity;
+    return (*chunks_[position / chunk_capacity])[position % chunk_capacity];
+}
+
+} // namespace database
+} // namespace libbitcoin
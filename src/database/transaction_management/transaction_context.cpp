@@ -16,15 +16,25 @@
  * You should have received a copy of the GNU Affero General Public License
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
+#include <unordered_set>
 
+#include <bitcoin/database/durability/log_manager.hpp>
 #include <bitcoin/database/transaction_management/spinlatch.hpp>
 #include <bitcoin/database/transaction_management/transaction_context.hpp>
+#include <bitcoin/database/tuples/mvcc_columns.hpp>
 
 namespace libbitcoin {
 namespace database {
 
 transaction_context::transaction_context(timestamp_t timestamp, state state)
-    : timestamp_(timestamp), state_(state), commit_actions_(), abort_actions_()
+  : transaction_context(timestamp, state, nullptr)
+{
+}
+
+transaction_context::transaction_context(timestamp_t timestamp, state state,
+    durability::log_manager* log)
+    : timestamp_(timestamp), state_(state), actions_(), log_(log), redo_(),
+      commit_actions_(), abort_actions_()
 {
 }
 
@@ -36,16 +46,93 @@ bool transaction_context::is_committed() const
 bool transaction_context::commit()
 {
     set_state(state::committed);
+
+    // Log before releasing any version, so the log order of two
+    // transactions writing the same record matches their commit order.
+    durability::log_sequence_number lsn = 0;
+    size_t segment = 0;
+    const auto logged = log_ != nullptr && !redo_.empty();
+    if (logged)
+        lsn = log_->append(timestamp_, redo_, segment);
+
+    const auto count = actions_.size();
+    for (size_t index = 0; index < count; ++index)
+    {
+        const auto& action = actions_[index];
+        switch (action.type)
+        {
+            case action_type::insert:
+                // commit to context timestamp
+                action.record->commit(*this, timestamp_);
+                break;
+            case action_type::append:
+                // commit appended version to infinity, then the
+                // version it follows to context timestamp
+                action.next->commit(*this);
+                action.record->commit(*this, timestamp_);
+                break;
+        }
+    }
+
     for (auto action = commit_actions_.begin(); action != commit_actions_.end(); action++)
     {
         (*action)();
     }
-    return true;
+
+    // Versions are already released, readers do not wait for the sync.
+    // A log that refused the append never makes the commit durable.
+    if (!logged)
+        return true;
+
+    if (lsn == 0)
+        return false;
+
+    log_->release(segment);
+    return log_->wait(lsn);
 }
 
 bool transaction_context::abort()
 {
     set_state(state::aborted);
+
+    // Records installed by this transaction. Recovery contexts share a
+    // timestamp, so a begin timestamp does not tell who inserted one.
+    std::unordered_set<const tuples::mvcc_columns*> inserted;
+    for (size_t index = 0; index < actions_.size(); ++index)
+        if (actions_[index].type == action_type::insert)
+            inserted.insert(actions_[index].record);
+
+    // Undo in reverse, so a version appended to twice is restored to
+    // the values it had before the first append.
+    for (auto index = actions_.size(); index > 0; --index)
+    {
+        const auto& action = actions_[index - 1];
+        switch (action.type)
+        {
+            case action_type::insert:
+                // release the latch, the record begins at infinity so
+                // no one can read it
+                action.record->abort(*this);
+                break;
+            case action_type::append:
+                action.record->set_next_version(action.old_next);
+
+                // a record inserted by this transaction is released by
+                // its insert action, which is undone after this one
+                if (inserted.count(action.record) != 0)
+                {
+                    action.record->set_end_timestamp(
+                        action.old_end_timestamp);
+                    break;
+                }
+
+                // reset end timestamp and release latch, that is what
+                // commit does
+                action.record->commit(*this, action.old_end_timestamp);
+                break;
+        }
+    }
+
     for (auto action = abort_actions_.begin(); action != abort_actions_.end(); action++)
     {
         (*action)();
@@ -53,6 +140,20 @@ bool transaction_context::abort()
     return true;
 }
 
+void transaction_context::register_insert_action(
+    tuples::mvcc_columns* record)
+{
+    actions_.push_back({ record, nullptr, nullptr, 0, action_type::insert });
+}
+
+void transaction_context::register_append_action(
+    tuples::mvcc_columns* record, tuples::mvcc_columns* appended,
+    timestamp_t end_timestamp, tuples::mvcc_columns* next)
+{
+    actions_.push_back({ record, appended, next, end_timestamp,
+        action_type::append });
+}
+
 void transaction_context::register_commit_action(const transaction_end_action& action)
 {
     commit_actions_.push_front(action);
@@ -16,6 +16,7 @@
  * You should have received a copy of the GNU Affero General Public License
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
+#include <algorithm>
 
 #include <bitcoin/database/transaction_management/spinlatch.hpp>
 #include <bitcoin/database/transaction_management/transaction_context.hpp>
@@ -25,7 +26,13 @@ namespace libbitcoin {
 namespace database {
 
 transaction_manager::transaction_manager()
-  : latch_{ std::make_shared<spinlatch>() }, time_{ timestamp_t(0) }
+  : transaction_manager(nullptr)
+{
+}
+
+transaction_manager::transaction_manager(durability::log_manager_ptr log)
+  : latch_{ std::make_shared<spinlatch>() }, log_(log),
+    time_{ log ? durability::recovery_timestamp : timestamp_t(0) }
 {
 }
 
@@ -34,16 +41,16 @@ transaction_context transaction_manager::begin_transaction()
     scopedspinlatch latch(latch_);
     auto start_time = ++time_;
 
-    transaction_context context(start_time, state::active);
+    transaction_context context(start_time, state::active, log_.get());
 
     current_transactions_.emplace(start_time);
 
     return context;
 }
 
-void transaction_manager::commit_transaction(transaction_context& context) const
+bool transaction_manager::commit_transaction(transaction_context& context) const
 {
-    context.commit();
+    return context.commit();
 }
 
 bool transaction_manager::is_active(const transaction_context& context) const
@@ -60,6 +67,16 @@ bool transaction_manager::is_active(const transaction_context& context) const
     return existing != current_transactions_.end();
 }
 
+timestamp_t transaction_manager::oldest_active() const
+{
+    scopedspinlatch latch(latch_);
+    auto oldest = time_.load() + 1;
+    for (const auto timestamp: current_transactions_)
+        oldest = std::min(oldest, timestamp);
+
+    return oldest;
+}
+
 void transaction_manager::remove_transaction(const transaction_context& context)
 {
     BITCOIN_ASSERT(context.get_state() == state::committed);
@@ -0,0 +1,184 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <bitcoin/database/tuples/mvcc_columns.hpp>
+
+namespace libbitcoin {
+namespace database {
+namespace tuples {
+
+// Set it so that it is locked by creating tx context.
+// Set begin timestamp is set to passed context's tx id
+mvcc_columns::mvcc_columns(const transaction_context& tx_context)
+    : read_timestamp_(none_read), begin_timestamp_(tx_context.get_timestamp()),
+      end_timestamp_(infinity), next_(nullptr)
+{
+    txn_id_.store(tx_context.get_timestamp());
+}
+
+bool mvcc_columns::get_latch_for_write(const transaction_context& context)
+{
+    auto old_tid = txn_id_.load();
+    auto tid = context.get_timestamp();
+
+    // already locked by tid
+    if (old_tid == tid)
+        return true;
+
+    // try to get the lock
+    auto unlatched = not_latched;
+    auto latched = txn_id_.compare_exchange_strong(unlatched, tid);
+    return latched;
+}
+
+bool mvcc_columns::release_latch(const transaction_context& context)
+{
+    auto old_tid = txn_id_.load();
+    auto tid = context.get_timestamp();
+
+    // locked by tid, try to release the latch
+    if (old_tid == tid)
+        return txn_id_.compare_exchange_strong(tid, not_latched);
+
+    // Locked by another txn or already not_latched
+    return false;
+}
+
+bool mvcc_columns::is_latched_by(const transaction_context& context) const
+{
+    return txn_id_.load() == context.get_timestamp();
+}
+
+timestamp_t mvcc_columns::get_txn_id() const
+{
+    return txn_id_.load();
+}
+
+bool mvcc_columns::install(const transaction_context& context)
+{
+    if (!is_latched_by(context))
+        return false;
+
+    // set end ts
+    end_timestamp_ = context.get_timestamp();
+    return true;
+}
+
+bool mvcc_columns::commit(const transaction_context& context)
+{
+    return commit(context, infinity);
+}
+
+bool mvcc_columns::commit(const transaction_context& context,
+    const timestamp_t ts)
+{
+    BITCOIN_ASSERT_MSG(!is_latched_by(context),
+        "Trying to install a version without latching it first");
+
+    end_timestamp_ = ts;
+    return release_latch(context);
+}
+
+bool mvcc_columns::abort(const transaction_context& context)
+{
+    // Set before the latch is released, a reader that finds the
+    // version unlatched also finds it begins at infinity.
+    begin_timestamp_ = infinity;
+    return release_latch(context);
+}
+
+// Uses MVTO protocol
+bool mvcc_columns::can_read(const transaction_context& context) const
+{
+    return read_timestamp_ <= context.get_timestamp();
+}
+
+// Uses MVTO protocol
+bool mvcc_columns::is_visible(const transaction_context& context) const
+{
+    auto timestamp = context.get_timestamp();
+
+    // No write lock held by any other transaction
+    auto old_tid = txn_id_.load();
+    if (old_tid != not_latched && old_tid != timestamp)
+        return false;
+
+    // can't read if context.timestamp is less than begin ts
+    if (timestamp < begin_timestamp_)
+        return false;
+
+    return true;
+}
+
+// A writer holds the latch on the versions it creates until it
+// commits, an aborted insert keeps it. Versions latched by a later
+// writer, to append the next version, are committed.
+bool mvcc_columns::is_committed_at(timestamp_t snapshot) const
+{
+    // Read begin first, it is written after the creator's latch.
+    const auto begin = begin_timestamp_;
+
+    // Slot allocated but not yet written.
+    if (begin == 0 || begin > snapshot)
+        return false;
+
+    // An aborted insert moves begin to infinity before releasing its
+    // latch, so begin is read again once the latch is seen released.
+    return txn_id_.load() != begin && begin_timestamp_ == begin;
+}
+
+mvcc_column mvcc_columns::get_read_timestamp() const
+{
+    return read_timestamp_;
+}
+
+void mvcc_columns::set_read_timestamp(const transaction_context& context)
+{
+    if (read_timestamp_ < context.get_timestamp())
+        read_timestamp_ = context.get_timestamp();
+}
+
+mvcc_column mvcc_columns::get_begin_timestamp() const
+{
+    return begin_timestamp_;
+}
+
+mvcc_column mvcc_columns::get_end_timestamp() const
+{
+    return end_timestamp_;
+}
+
+void mvcc_columns::set_end_timestamp(const timestamp_t ts)
+{
+    end_timestamp_ = ts;
+}
+
+mvcc_columns* mvcc_columns::get_next_version() const
+{
+    return next_;
+}
+
+void mvcc_columns::set_next_version(mvcc_columns* next)
+{
+    next_ = next;
+}
+
+} // namespace tuples
+} // namespace database
+} // namespace libbitcoin
@@ -0,0 +1,56 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <bitcoin/database/tuples/utxo_tuple.hpp>
+
+namespace libbitcoin {
+namespace database {
+namespace tuples {
+
+static_assert(sizeof(utxo_tuple) == 64, "utxo_tuple is not 64 bytes");
+
+utxo_tuple::utxo_tuple()
+  : value(0), height(not_found), script_size(0), state(unspent)
+{
+}
+
+utxo_tuple::operator bool() const
+{
+    return height != not_found;
+}
+
+bool utxo_tuple::is_inline() const
+{
+    return script_size <= script_capacity;
+}
+
+void utxo_tuple::read_from_delta(utxo_tuple& tuple, utxo_tuple_delta& delta)
+{
+    tuple.state = delta.state;
+}
+
+void utxo_tuple::write_to_delta(const utxo_tuple& tuple,
+    utxo_tuple_delta& delta)
+{
+    delta.state = tuple.state;
+}
+
+} // tuples
+} // database
+} // libbitcoin
@@ -0,0 +1,244 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+
+#include <bitcoin/system.hpp>
+#include <bitcoin/database/container/art_index.hpp>
+#include <bitcoin/database/storage/raw_block.hpp>
+#include <bitcoin/database/storage/slot.hpp>
+
+using namespace bc;
+using namespace bc::database;
+using namespace bc::database::container;
+using namespace bc::database::storage;
+
+// Slots only need distinct values here, the block is never read.
+static slot slot_at(uint32_t offset)
+{
+    return { reinterpret_cast<raw_block*>(uintptr_t(BLOCK_SIZE)), offset };
+}
+
+// Stands in for the records, the hash at each slot offset. Offset 0
+// is left unused.
+struct hash_records
+{
+    hash_records(size_t count)
+      : hashes(count + 1)
+    {
+        for (uint32_t offset = 1; offset <= count; ++offset)
+            hashes[offset] = system::bitcoin_hash(
+                { uint8_t(offset), uint8_t(offset >> 8), uint8_t(offset >> 16) });
+    }
+
+    art_index::loader loader() const
+    {
+        return [this](const slot& at) -> const system::hash_digest&
+        {
+            return hashes.at(at.get_offset());
+        };
+    }
+
+    std::vector<system::hash_digest> hashes;
+};
+
+BOOST_AUTO_TEST_SUITE(art_index_tests)
+
+BOOST_AUTO_TEST_CASE(art_index__insert__random_hashes__found)
+{
+    static const uint32_t count = 20000;
+    const hash_records stored(count);
+    art_index index(stored.loader());
+
+    slot out;
+    BOOST_CHECK(!index.find(stored.hashes[1], out));
+
+    for (uint32_t offset = 1; offset <= count; ++offset)
+        BOOST_REQUIRE(index.insert(stored.hashes[offset], slot_at(offset)));
+
+    // already indexed
+    BOOST_CHECK(!index.insert(stored.hashes[7], slot_at(8)));
+    BOOST_CHECK_EQUAL(index.size(), count);
+    BOOST_CHECK_GT(index.nodes(), 1u);
+
+    size_t failures = 0;
+    for (uint32_t offset = 1; offset <= count; ++offset)
+        if (!index.find(stored.hashes[offset], out) || out != slot_at(offset))
+            ++failures;
+
+    BOOST_CHECK_EQUAL(failures, 0u);
+
+    // shares a leaf position with an indexed hash, but not its key
+    auto missing = stored.hashes[5];
+    missing[31] ^= 0xff;
+    BOOST_CHECK(!index.find(missing, out));
+}
+
+BOOST_AUTO_TEST_CASE(art_index__insert__long_shared_prefix__split)
+{
+    // 20 shared bytes, longer than the bytes kept in a node
+    hash_records stored(4);
+    for (size_t offset = 1; offset <= 4; ++offset)
+    {
+        stored.hashes[offset] = system::hash_digest{};
+        stored.hashes[offset][0] = 0x42;
+        stored.hashes[offset][21] = uint8_t(offset);
+    }
+
+    // differs inside the compressed prefix, past the stored bytes
+    stored.hashes[4][12] = 0x01;
+
+    art_index index(stored.loader());
+    BOOST_REQUIRE(index.insert(stored.hashes[1], slot_at(1)));
+    BOOST_REQUIRE(index.insert(stored.hashes[2], slot_at(2)));
+    BOOST_REQUIRE(index.insert(stored.hashes[3], slot_at(3)));
+    BOOST_REQUIRE(index.insert(stored.hashes[4], slot_at(4)));
+    BOOST_CHECK(!index.insert(stored.hashes[2], slot_at(2)));
+
+    slot out;
+    for (uint32_t offset = 1; offset <= 4; ++offset)
+    {
+        BOOST_REQUIRE(index.find(stored.hashes[offset], out));
+        BOOST_CHECK(out == slot_at(offset));
+    }
+
+    auto missing = stored.hashes[1];
+    missing[15] = 0x07;
+    BOOST_CHECK(!index.find(missing, out));
+}
+
+BOOST_AUTO_TEST_CASE(art_index__erase__all__nodes_collapse)
+{
+    static const uint32_t count = 5000;
+    const hash_records stored(count);
+    art_index index(stored.loader());
+    for (uint32_t offset = 1; offset <= count; ++offset)
+        BOOST_REQUIRE(index.insert(stored.hashes[offset], slot_at(offset)));
+
+    // indexed at another slot
+    BOOST_CHECK(!index.erase(stored.hashes[1], slot_at(2)));
+
+    slot out;
+    for (uint32_t offset = 1; offset <= count; offset += 2)
+        BOOST_REQUIRE(index.erase(stored.hashes[offset], slot_at(offset)));
+
+    BOOST_CHECK(!index.erase(stored.hashes[1], slot_at(1)));
+    BOOST_CHECK(!index.find(stored.hashes[1], out));
+    BOOST_REQUIRE(index.find(stored.hashes[2], out));
+    BOOST_CHECK(out == slot_at(2));
+    BOOST_CHECK_EQUAL(index.size(), count / 2);
+
+    for (uint32_t offset = 2; offset <= count; offset += 2)
+        BOOST_REQUIRE(index.erase(stored.hashes[offset], slot_at(offset)));
+
+    BOOST_CHECK_EQUAL(index.size(), 0u);
+    BOOST_CHECK_EQUAL(index.nodes(), 1u);
+
+    BOOST_REQUIRE(index.insert(stored.hashes[1], slot_at(1)));
+    BOOST_REQUIRE(index.find(stored.hashes[1], out));
+}
+
+BOOST_AUTO_TEST_CASE(art_index__find__concurrent_with_insert__consistent)
+{
+    static const uint32_t per_thread = 20000;
+    static const uint32_t threads = 4;
+    const hash_records stored(per_thread * threads);
+    art_index index(stored.loader());
+
+    std::vector<std::thread> writers;
+    for (uint32_t thread = 0; thread < threads; ++thread)
+        writers.emplace_back([&, thread]()
+        {
+            for (uint32_t offset = thread + 1; offset <= per_thread * threads;
+                offset += threads)
+                index.insert(stored.hashes[offset], slot_at(offset));
+        });
+
+    // a hash found is found at its own slot
+    size_t failures = 0;
+    while (index.size() < per_thread * threads)
+    {
+        for (uint32_t offset = 1; offset <= per_thread * threads;
+            offset += 97)
+        {
+            slot out;
+            if (index.find(stored.hashes[offset], out) &&
+                out != slot_at(offset))
+                ++failures;
+        }
+    }
+
+    for (auto& writer: writers)
+        writer.join();
+
+    for (uint32_t offset = 1; offset <= per_thread * threads; ++offset)
+    {
+        slot out;
+        if (!index.find(stored.hashes[offset], out))
+            ++failures;
+    }
+
+    BOOST_CHECK_EQUAL(failures, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(art_index__erase__concurrent_with_insert__consistent)
+{
+    static const uint32_t per_thread = 10000;
+    static const uint32_t threads = 4;
+    const hash_records stored(per_thread * threads);
+    art_index index(stored.loader());
+
+    // each thread inserts its hashes, erases the odd ones and inserts
+    // them again, growing and shrinking shared nodes
+    std::vector<std::thread> writers;
+    for (uint32_t thread = 0; thread < threads; ++thread)
+        writers.emplace_back([&, thread]()
+        {
+            const auto first = thread * per_thread + 1;
+            const auto last = first + per_thread;
+            for (auto offset = first; offset < last; ++offset)
+                index.insert(stored.hashes[offset], slot_at(offset));
+
+            for (auto offset = first; offset < last; offset += 2)
+                index.erase(stored.hashes[offset], slot_at(offset));
+
+            for (auto offset = first; offset < last; offset += 4)
+                index.insert(stored.hashes[offset], slot_at(offset));
+        });
+
+    for (auto& writer: writers)
+        writer.join();
+
+    size_t failures = 0;
+    for (uint32_t offset = 1; offset <= per_thread * threads; ++offset)
+    {
+        slot out;
+        const auto position = (offset - 1) % per_thread;
+        const auto expected = position % 2 == 1 || position % 4 == 0;
+        if (index.find(stored.hashes[offset], out) != expected)
+            ++failures;
+    }
+
+    BOOST_CHECK_EQUAL(failures, 0u);
+    BOOST_CHECK_EQUAL(index.size(), threads * (per_thread / 2 + per_thread / 4));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,193 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+
+#include <bitcoin/database/container/cuckoo_filter.hpp>
+
+using namespace libbitcoin::database::container;
+
+// Distinct, well spread hashes.
+static uint64_t hash_of(uint64_t value)
+{
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdull;
+    value ^= value >> 33;
+    return value;
+}
+
+BOOST_AUTO_TEST_SUITE(cuckoo_filter_tests)
+
+BOOST_AUTO_TEST_CASE(cuckoo_filter__contains__disabled__true)
+{
+    cuckoo_filter filter;
+    BOOST_CHECK(!filter.enabled());
+    BOOST_CHECK_EQUAL(filter.blocks(), 0u);
+    BOOST_CHECK(filter.contains(hash_of(1)));
+}
+
+BOOST_AUTO_TEST_CASE(cuckoo_filter__resize__count__blocks_power_of_two)
+{
+    cuckoo_filter filter;
+    filter.resize(1000);
+    const auto per_block = cuckoo_filter::hashes_per_block;
+    BOOST_CHECK(filter.enabled());
+    BOOST_CHECK_GE(filter.blocks() * per_block, 1000u);
+    BOOST_CHECK_EQUAL(filter.blocks() & (filter.blocks() - 1), 0u);
+
+    filter.resize(0);
+    BOOST_CHECK(!filter.enabled());
+}
+
+BOOST_AUTO_TEST_CASE(cuckoo_filter__contains__inserted__true)
+{
+    static const uint64_t count = 100000;
+    cuckoo_filter filter;
+    filter.resize(count);
+
+    for (uint64_t value = 0; value < count; ++value)
+        filter.insert(hash_of(value));
+
+    for (uint64_t value = 0; value < count; ++value)
+        BOOST_REQUIRE(filter.contains(hash_of(value)));
+
+    BOOST_CHECK_EQUAL(filter.saturated_blocks(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(cuckoo_filter__contains__not_inserted__mostly_false)
+{
+    static const uint64_t count = 100000;
+    cuckoo_filter filter;
+    filter.resize(count);
+
+    for (uint64_t value = 0; value < count; ++value)
+        filter.insert(hash_of(value));
+
+    size_t false_positives = 0;
+    for (uint64_t value = count; value < 2 * count; ++value)
+        if (filter.contains(hash_of(value)))
+            ++false_positives;
+
+    // Eight 16 bit fingerprints are compared, about 1 in 8000.
+    BOOST_CHECK_LT(false_positives, count / 1000);
+}
+
+BOOST_AUTO_TEST_CASE(cuckoo_filter__erase__inserted__false)
+{
+    cuckoo_filter filter;
+    filter.resize(100);
+    filter.insert(hash_of(1));
+    filter.insert(hash_of(2));
+
+    filter.erase(hash_of(1));
+    BOOST_CHECK(!filter.contains(hash_of(1)));
+    BOOST_CHECK(filter.contains(hash_of(2)));
+}
+
+BOOST_AUTO_TEST_CASE(cuckoo_filter__erase__inserted_twice__true)
+{
+    cuckoo_filter filter;
+    filter.resize(100);
+    filter.insert(hash_of(1));
+    filter.insert(hash_of(1));
+
+    filter.erase(hash_of(1));
+    BOOST_CHECK(filter.contains(hash_of(1)));
+
+    filter.erase(hash_of(1));
+    BOOST_CHECK(!filter.contains(hash_of(1)));
+}
+
+BOOST_AUTO_TEST_CASE(cuckoo_filter__insert__overfull__saturated_contains_all)
+{
+    cuckoo_filter filter;
+    filter.resize(1);
+    BOOST_REQUIRE_EQUAL(filter.blocks(), 2u);
+
+    // A block holds 28 fingerprints.
+    for (uint64_t value = 0; value < 64; ++value)
+        filter.insert(hash_of(value));
+
+    BOOST_CHECK_EQUAL(filter.saturated_blocks(), 2u);
+    BOOST_CHECK(filter.contains(hash_of(1000)));
+}
+
+BOOST_AUTO_TEST_CASE(cuckoo_filter__insert__one_block_full__spilled_contains)
+{
+    static const uint64_t count = 48;
+    cuckoo_filter filter;
+    filter.resize(1);
+
+    // More than one block holds, so at least one spills.
+    for (uint64_t value = 0; value < count; ++value)
+        filter.insert(hash_of(value));
+
+    BOOST_CHECK_EQUAL(filter.saturated_blocks(), 0u);
+    BOOST_CHECK_GE(filter.spilled_blocks(), 1u);
+
+    for (uint64_t value = 0; value < count; ++value)
+        BOOST_REQUIRE(filter.contains(hash_of(value)));
+
+    for (uint64_t value = 0; value < count; ++value)
+        filter.erase(hash_of(value));
+
+    size_t false_positives = 0;
+    for (uint64_t value = 0; value < count; ++value)
+        if (filter.contains(hash_of(value)))
+            ++false_positives;
+
+    BOOST_CHECK_EQUAL(false_positives, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(cuckoo_filter__insert__concurrent__all_contained)
+{
+    static const uint64_t threads = 4;
+    static const uint64_t per_thread = 20000;
+    cuckoo_filter filter;
+    filter.resize(threads * per_thread);
+
+    // Boost.Test is not thread safe, so misses are counted.
+    std::atomic<size_t> missed(0);
+    std::vector<std::thread> writers;
+    for (uint64_t thread = 0; thread < threads; ++thread)
+        writers.emplace_back([&filter, &missed, thread]()
+        {
+            for (uint64_t value = 0; value < per_thread; ++value)
+            {
+                const auto hash = hash_of(thread * per_thread + value);
+                filter.insert(hash);
+                if (!filter.contains(hash))
+                    missed.fetch_add(1);
+            }
+        });
+
+    for (auto& writer: writers)
+        writer.join();
+
+    BOOST_REQUIRE_EQUAL(missed.load(), 0u);
+
+    for (uint64_t value = 0; value < threads * per_thread; ++value)
+        BOOST_REQUIRE(filter.contains(hash_of(value)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
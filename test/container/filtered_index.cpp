@@ -0,0 +1,160 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <map>
+#include <boost/test/unit_test.hpp>
+
+#include <bitcoin/system.hpp>
+#include <bitcoin/database/container/filtered_index.hpp>
+#include <bitcoin/database/container/fingerprint_index.hpp>
+#include <bitcoin/database/storage/raw_block.hpp>
+#include <bitcoin/database/storage/slot.hpp>
+
+using namespace bc;
+using namespace bc::database;
+using namespace bc::database::container;
+using namespace bc::database::storage;
+
+typedef filtered_index<fingerprint_index> filtered_fingerprint_index;
+
+// Slots only need distinct values here, the block is never read.
+static slot slot_at(uint32_t offset)
+{
+    return { reinterpret_cast<raw_block*>(uintptr_t(BLOCK_SIZE)), offset };
+}
+
+static system::hash_digest hash_of(uint32_t value)
+{
+    return system::bitcoin_hash({ uint8_t(value), uint8_t(value >> 8),
+        uint8_t(value >> 16), uint8_t(value >> 24) });
+}
+
+// Stands in for the records, the hash stored at each slot offset.
+struct filtered_records
+{
+    fingerprint_index::loader loader()
+    {
+        return [this](const slot& at) -> const system::hash_digest&
+        {
+            return hashes.at(at.get_offset());
+        };
+    }
+
+    void add(uint32_t offset, const system::hash_digest& hash)
+    {
+        hashes[offset] = hash;
+    }
+
+    std::map<uint32_t, system::hash_digest> hashes;
+};
+
+BOOST_AUTO_TEST_SUITE(filtered_index_tests)
+
+BOOST_AUTO_TEST_CASE(filtered_index__find__not_enabled__unfiltered)
+{
+    filtered_records stored;
+    filtered_fingerprint_index index(stored.loader());
+    stored.add(1, hash_of(1));
+    BOOST_REQUIRE(index.insert(hash_of(1), slot_at(1)));
+
+    slot out;
+    BOOST_CHECK(index.find(hash_of(1), out));
+    BOOST_CHECK(!index.find(hash_of(2), out));
+    BOOST_CHECK(!index.filter().enabled());
+    BOOST_CHECK_EQUAL(index.lookup_counters().lookups, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(filtered_index__find__enabled__counts_rejected)
+{
+    static const uint32_t count = 1000;
+    filtered_records stored;
+    filtered_fingerprint_index index(stored.loader());
+    BOOST_REQUIRE(index.enable_filter(count));
+    BOOST_REQUIRE(index.filter().enabled());
+
+    for (uint32_t value = 0; value < count; ++value)
+    {
+        stored.add(value, hash_of(value));
+        BOOST_REQUIRE(index.insert(hash_of(value), slot_at(value)));
+    }
+
+    slot out;
+    for (uint32_t value = 0; value < count; ++value)
+    {
+        BOOST_REQUIRE(index.find(hash_of(value), out));
+        BOOST_REQUIRE(out == slot_at(value));
+    }
+
+    for (uint32_t value = count; value < 2 * count; ++value)
+        BOOST_REQUIRE(!index.find(hash_of(value), out));
+
+    const auto counters = index.lookup_counters();
+    BOOST_CHECK_EQUAL(counters.lookups, 2 * count);
+    BOOST_CHECK_EQUAL(counters.rejected + counters.false_positives, count);
+    BOOST_CHECK_GT(counters.rejected, count * 99 / 100);
+}
+
+BOOST_AUTO_TEST_CASE(filtered_index__erase__indexed__rejected)
+{
+    filtered_records stored;
+    filtered_fingerprint_index index(stored.loader());
+    BOOST_REQUIRE(index.enable_filter(100));
+    stored.add(1, hash_of(1));
+    BOOST_REQUIRE(index.insert(hash_of(1), slot_at(1)));
+
+    BOOST_CHECK(!index.erase(hash_of(1), slot_at(2)));
+    BOOST_CHECK(index.erase(hash_of(1), slot_at(1)));
+    BOOST_CHECK(!index.filter().contains(
+        filtered_fingerprint_index::to_filter_hash(hash_of(1))));
+
+    slot out;
+    BOOST_CHECK(!index.find(hash_of(1), out));
+    BOOST_CHECK_EQUAL(index.lookup_counters().rejected, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(filtered_index__insert__duplicate__filter_unchanged)
+{
+    filtered_records stored;
+    filtered_fingerprint_index index(stored.loader());
+    BOOST_REQUIRE(index.enable_filter(100));
+    stored.add(1, hash_of(1));
+    stored.add(2, hash_of(1));
+    BOOST_REQUIRE(index.insert(hash_of(1), slot_at(1)));
+    BOOST_REQUIRE(!index.insert(hash_of(1), slot_at(2)));
+
+    // One erase leaves nothing in the filter.
+    BOOST_REQUIRE(index.erase(hash_of(1), slot_at(1)));
+    BOOST_CHECK(!index.filter().contains(
+        filtered_fingerprint_index::to_filter_hash(hash_of(1))));
+}
+
+BOOST_AUTO_TEST_CASE(filtered_index__enable_filter__not_empty__failure)
+{
+    filtered_records stored;
+    filtered_fingerprint_index index(stored.loader());
+    stored.add(1, hash_of(1));
+    BOOST_REQUIRE(index.insert(hash_of(1), slot_at(1)));
+
+    BOOST_CHECK(!index.enable_filter(100));
+    BOOST_CHECK(!index.filter().enabled());
+
+    slot out;
+    BOOST_CHECK(index.find(hash_of(1), out));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
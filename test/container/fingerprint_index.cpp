@@ -0,0 +1,198 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <map>
+#include <boost/test/unit_test.hpp>
+
+#include <bitcoin/system.hpp>
+#include <bitcoin/database/container/fingerprint_index.hpp>
+#include <bitcoin/database/storage/raw_block.hpp>
+#include <bitcoin/database/storage/slot.hpp>
+
+using namespace bc;
+using namespace bc::database;
+using namespace bc::database::container;
+using namespace bc::database::storage;
+
+// Slots only need distinct values here, the block is never read.
+static slot slot_at(uint32_t offset)
+{
+    return { reinterpret_cast<raw_block*>(uintptr_t(BLOCK_SIZE)), offset };
+}
+
+// Hashes sharing a fingerprint, differing only past the first 8 bytes.
+static system::hash_digest colliding_hash(uint8_t tail)
+{
+    system::hash_digest hash{};
+    hash[0] = 0x42;
+    hash[31] = tail;
+    return hash;
+}
+
+// Stands in for the records, the hash stored at each slot offset.
+struct records
+{
+    fingerprint_index::verifier verifier()
+    {
+        return [this](const slot& at, const system::hash_digest& hash)
+        {
+            return hashes.at(at.get_offset()) == hash;
+        };
+    }
+
+    void add(uint32_t offset, const system::hash_digest& hash)
+    {
+        hashes[offset] = hash;
+    }
+
+    std::map<uint32_t, system::hash_digest> hashes;
+};
+
+BOOST_AUTO_TEST_SUITE(fingerprint_index_tests)
+
+BOOST_AUTO_TEST_CASE(fingerprint_index__find__empty__failure)
+{
+    records stored;
+    fingerprint_index index(stored.verifier());
+    slot out;
+    BOOST_CHECK(!index.find(colliding_hash(1), out));
+    BOOST_CHECK_EQUAL(index.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(fingerprint_index__insert__distinct__found)
+{
+    records stored;
+    fingerprint_index index(stored.verifier());
+
+    for (uint32_t offset = 1; offset <= 100; ++offset)
+    {
+        system::hash_digest hash{};
+        hash[0] = uint8_t(offset);
+        stored.add(offset, hash);
+        BOOST_REQUIRE(index.insert(hash, slot_at(offset)));
+    }
+
+    slot out;
+    system::hash_digest hash{};
+    hash[0] = 42;
+    BOOST_REQUIRE(index.find(hash, out));
+    BOOST_CHECK(out == slot_at(42));
+    BOOST_CHECK_EQUAL(index.size(), 100u);
+    BOOST_CHECK_EQUAL(index.overflow_size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(fingerprint_index__reserve__count__inserts_do_not_grow)
+{
+    static const uint32_t count = 300000;
+    records stored;
+    fingerprint_index index(stored.verifier());
+
+    index.reserve(count);
+    const auto capacity = index.capacity();
+    BOOST_REQUIRE_GE(capacity, count);
+
+    for (uint32_t offset = 1; offset <= count; ++offset)
+    {
+        const auto hash = system::bitcoin_hash(
+            { uint8_t(offset), uint8_t(offset >> 8), uint8_t(offset >> 16) });
+        stored.add(offset, hash);
+        BOOST_REQUIRE(index.insert(hash, slot_at(offset)));
+    }
+
+    BOOST_CHECK_EQUAL(index.size(), count);
+    BOOST_CHECK_EQUAL(index.capacity(), capacity);
+}
+
+BOOST_AUTO_TEST_CASE(fingerprint_index__insert__colliding__resolved_by_verifier)
+{
+    records stored;
+    fingerprint_index index(stored.verifier());
+
+    stored.add(1, colliding_hash(1));
+    stored.add(2, colliding_hash(2));
+    stored.add(3, colliding_hash(3));
+    BOOST_REQUIRE(index.insert(colliding_hash(1), slot_at(1)));
+    BOOST_REQUIRE(index.insert(colliding_hash(2), slot_at(2)));
+    BOOST_REQUIRE(index.insert(colliding_hash(3), slot_at(3)));
+    BOOST_CHECK_EQUAL(index.overflow_size(), 2u);
+    BOOST_CHECK_EQUAL(index.size(), 3u);
+
+    slot out;
+    BOOST_REQUIRE(index.find(colliding_hash(1), out));
+    BOOST_CHECK(out == slot_at(1));
+    BOOST_REQUIRE(index.find(colliding_hash(3), out));
+    BOOST_CHECK(out == slot_at(3));
+
+    // Same fingerprint, never inserted.
+    BOOST_CHECK(!index.find(colliding_hash(4), out));
+}
+
+BOOST_AUTO_TEST_CASE(fingerprint_index__candidate__colliding__unverified_slot)
+{
+    records stored;
+    fingerprint_index index(stored.verifier());
+    slot out;
+    BOOST_CHECK(!index.candidate(colliding_hash(1), out));
+
+    stored.add(1, colliding_hash(1));
+    BOOST_REQUIRE(index.insert(colliding_hash(1), slot_at(1)));
+
+    // The slot of the hash holding the fingerprint, not verified.
+    BOOST_REQUIRE(index.candidate(colliding_hash(2), out));
+    BOOST_CHECK(out == slot_at(1));
+    BOOST_CHECK(!index.find(colliding_hash(2), out));
+}
+
+BOOST_AUTO_TEST_CASE(fingerprint_index__insert__duplicate__failure)
+{
+    records stored;
+    fingerprint_index index(stored.verifier());
+
+    stored.add(1, colliding_hash(1));
+    stored.add(2, colliding_hash(2));
+    BOOST_REQUIRE(index.insert(colliding_hash(1), slot_at(1)));
+    BOOST_REQUIRE(index.insert(colliding_hash(2), slot_at(2)));
+
+    BOOST_CHECK(!index.insert(colliding_hash(1), slot_at(5)));
+    BOOST_CHECK(!index.insert(colliding_hash(2), slot_at(6)));
+    BOOST_CHECK_EQUAL(index.size(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(fingerprint_index__erase__primary_and_overflow__success)
+{
+    records stored;
+    fingerprint_index index(stored.verifier());
+
+    stored.add(1, colliding_hash(1));
+    stored.add(2, colliding_hash(2));
+    BOOST_REQUIRE(index.insert(colliding_hash(1), slot_at(1)));
+    BOOST_REQUIRE(index.insert(colliding_hash(2), slot_at(2)));
+
+    // Only at the slot it is indexed at.
+    BOOST_CHECK(!index.erase(colliding_hash(2), slot_at(1)));
+    BOOST_REQUIRE(index.erase(colliding_hash(2), slot_at(2)));
+    BOOST_CHECK_EQUAL(index.overflow_size(), 0u);
+
+    slot out;
+    BOOST_CHECK(!index.find(colliding_hash(2), out));
+    BOOST_REQUIRE(index.erase(colliding_hash(1), slot_at(1)));
+    BOOST_CHECK(!index.find(colliding_hash(1), out));
+    BOOST_CHECK_EQUAL(index.size(), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,72 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <bitcoin/system.hpp>
+#include <bitcoin/database/container/hash_digest_hasher.hpp>
+
+using namespace bc;
+using namespace bc::database::container;
+
+BOOST_AUTO_TEST_SUITE(hash_digest_hasher_tests)
+
+BOOST_AUTO_TEST_CASE(hash_digest_hasher__hash__words__only_selected_word)
+{
+    system::hash_digest hash{};
+    hash[0] = 0x01;
+    hash[8] = 0x02;
+
+    auto other = hash;
+    other[31] = 0xff;
+
+    BOOST_CHECK_EQUAL(hash_digest_hasher<0>()(hash), 0x01u);
+    BOOST_CHECK_EQUAL(hash_digest_hasher<1>()(hash), 0x02u);
+    BOOST_CHECK_EQUAL(hash_digest_hasher<0>()(hash),
+        hash_digest_hasher<0>()(other));
+    BOOST_CHECK(hash_digest_hasher<3>()(hash) !=
+        hash_digest_hasher<3>()(other));
+}
+
+BOOST_AUTO_TEST_CASE(hash_digest_equal__compare__any_byte__matches_operator)
+{
+    const hash_digest_equal equal;
+    const auto hash = system::bitcoin_hash({ 42 });
+    BOOST_CHECK(equal(hash, hash));
+
+    for (size_t byte = 0; byte < hash.size(); ++byte)
+    {
+        auto other = hash;
+        other[byte] ^= 0x80;
+        BOOST_CHECK(!equal(hash, other));
+        BOOST_CHECK_EQUAL(equal(hash, other), hash == other);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(point_hasher__hash__outputs_of_one_transaction__differ_in_high_bits)
+{
+    const point_hasher hasher;
+    const auto hash = system::bitcoin_hash({ 42 });
+    const auto first = hasher({ hash, 0 });
+    BOOST_CHECK_EQUAL(first, hash_digest_hasher<0>()(hash));
+
+    for (uint32_t index = 1; index < 16; ++index)
+        BOOST_CHECK((hasher({ hash, index }) ^ first) >> 56 != 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,248 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <atomic>
+#include <map>
+#include <thread>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+
+#include <bitcoin/system.hpp>
+#include <bitcoin/database/container/height_index.hpp>
+#include <bitcoin/database/storage/raw_block.hpp>
+#include <bitcoin/database/storage/slot.hpp>
+
+using namespace bc;
+using namespace bc::database;
+using namespace bc::database::container;
+using namespace bc::database::storage;
+
+// Slots only need distinct values here, the block is never read.
+static slot slot_at(uint32_t offset)
+{
+    return { reinterpret_cast<raw_block*>(uintptr_t(BLOCK_SIZE)), offset };
+}
+
+BOOST_AUTO_TEST_SUITE(height_index_tests)
+
+BOOST_AUTO_TEST_CASE(height_index__find__empty__failure)
+{
+    height_index index;
+    slot out;
+    size_t height;
+    BOOST_CHECK(!index.find(0, out));
+    BOOST_CHECK(!index.top(height));
+    BOOST_CHECK_EQUAL(index.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(height_index__insert__across_chunks__found)
+{
+    height_index index;
+    const auto heights = height_index::chunk_size + 10;
+    for (size_t height = 0; height < heights; ++height)
+        BOOST_REQUIRE(index.insert(height, slot_at(height % 1000)));
+
+    slot out;
+    BOOST_REQUIRE(index.find(height_index::chunk_size + 3, out));
+    BOOST_CHECK(out == slot_at((height_index::chunk_size + 3) % 1000));
+
+    size_t top;
+    BOOST_REQUIRE(index.top(top));
+    BOOST_CHECK_EQUAL(top, heights - 1);
+
+    // already indexed
+    BOOST_CHECK(!index.insert(5, slot_at(1)));
+}
+
+BOOST_AUTO_TEST_CASE(height_index__insert__max_height__failure)
+{
+    height_index index;
+    const auto height = height_index::max_height;
+    BOOST_CHECK(!index.insert(height, slot_at(1)));
+    BOOST_CHECK(!index.insert_or_assign(height, slot_at(1)));
+    BOOST_CHECK(!index.insert_or_assign(SIZE_MAX, slot_at(1)));
+    BOOST_CHECK_EQUAL(index.size(), 0u);
+    BOOST_CHECK_EQUAL(index.capacity(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(height_index__reserve__past_chunk__chunks_allocated)
+{
+    height_index index;
+    BOOST_CHECK_EQUAL(index.capacity(), 0u);
+
+    const auto chunk_size = height_index::chunk_size;
+    index.reserve(chunk_size + 1);
+    BOOST_CHECK_EQUAL(index.capacity(), 2 * chunk_size);
+
+    // reserving allocates, it does not index
+    slot out;
+    BOOST_CHECK_EQUAL(index.size(), 0u);
+    BOOST_CHECK(!index.find(chunk_size, out));
+
+    BOOST_REQUIRE(index.insert(0, slot_at(1)));
+    BOOST_REQUIRE(index.find(0, out));
+    BOOST_CHECK_EQUAL(index.capacity(), 2 * chunk_size);
+}
+
+BOOST_AUTO_TEST_CASE(height_index__erase__tip__moves_tip_back)
+{
+    height_index index;
+    BOOST_REQUIRE(index.insert(0, slot_at(0)));
+    BOOST_REQUIRE(index.insert(1, slot_at(1)));
+
+    BOOST_REQUIRE(index.erase(1));
+    BOOST_CHECK(!index.erase(1));
+
+    size_t top;
+    BOOST_REQUIRE(index.top(top));
+    BOOST_CHECK_EQUAL(top, 0u);
+
+    BOOST_REQUIRE(index.erase(0));
+    BOOST_CHECK(!index.top(top));
+}
+
+BOOST_AUTO_TEST_CASE(height_index__erase__middle_then_tip__tip_skips_empty_heights)
+{
+    height_index index;
+    for (size_t height = 0; height < 5; ++height)
+        BOOST_REQUIRE(index.insert(height, slot_at(height)));
+
+    BOOST_REQUIRE(index.erase(2));
+    BOOST_REQUIRE(index.erase(3));
+    BOOST_REQUIRE(index.erase(4));
+
+    size_t top;
+    BOOST_REQUIRE(index.top(top));
+    BOOST_CHECK_EQUAL(top, 1u);
+    BOOST_CHECK_EQUAL(index.size(), 2u);
+
+    // A height below the tip may be empty, the tip never is.
+    BOOST_REQUIRE(index.erase(0));
+    BOOST_REQUIRE(index.erase(1));
+    BOOST_CHECK(!index.top(top));
+    BOOST_CHECK_EQUAL(index.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(height_index__truncate__stale_entries_not_visible)
+{
+    height_index index;
+    for (size_t height = 0; height < 10; ++height)
+        BOOST_REQUIRE(index.insert(height, slot_at(height)));
+
+    index.truncate(4);
+    BOOST_CHECK_EQUAL(index.size(), 4u);
+
+    slot out;
+    BOOST_CHECK(!index.find(6, out));
+
+    // skipping past truncated heights does not expose their entries
+    index.insert_or_assign(8, slot_at(80));
+    BOOST_CHECK(!index.find(6, out));
+    BOOST_REQUIRE(index.find(8, out));
+    BOOST_CHECK(out == slot_at(80));
+    BOOST_REQUIRE(index.find(3, out));
+    BOOST_CHECK(out == slot_at(3));
+}
+
+BOOST_AUTO_TEST_CASE(height_index__find__concurrent_with_append__consistent)
+{
+    height_index index;
+    static const size_t heights = 50000;
+
+    std::thread writer([&index]()
+    {
+        for (size_t height = 0; height < heights; ++height)
+            index.insert(height, slot_at(height % 1000 + 1));
+    });
+
+    // every height below the tip is readable
+    size_t failures = 0;
+    while (index.size() < heights)
+    {
+        size_t top;
+        slot out;
+        if (index.top(top) && !index.find(top, out))
+            ++failures;
+    }
+
+    writer.join();
+    BOOST_CHECK_EQUAL(failures, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(height_index__apply__truncate_and_replace__success)
+{
+    height_index index;
+    for (size_t height = 0; height < 10; ++height)
+        BOOST_REQUIRE(index.insert(height, slot_at(height)));
+
+    // Replace 5..9 with 5 and 6, erase 2.
+    const std::map<size_t, slot> changes{ { 2, slot{} },
+        { 5, slot_at(50) }, { 6, slot_at(60) } };
+    index.apply(5, changes, 7);
+    BOOST_CHECK_EQUAL(index.size(), 7u);
+
+    slot out;
+    BOOST_CHECK(!index.find(2, out));
+    BOOST_REQUIRE(index.find(6, out));
+    BOOST_CHECK(out == slot_at(60));
+    BOOST_REQUIRE(index.find(4, out));
+    BOOST_CHECK(out == slot_at(4));
+
+    // the entries left above the tip are never exposed
+    index.apply(SIZE_MAX, {}, 9);
+    BOOST_CHECK(!index.find(7, out));
+    BOOST_CHECK(!index.find(8, out));
+}
+
+BOOST_AUTO_TEST_CASE(height_index__find__concurrent_with_apply__never_cut_short)
+{
+    height_index index;
+    static const size_t fork = 1000;
+    static const size_t rounds = 2000;
+    for (size_t height = 0; height < fork + 10; ++height)
+        BOOST_REQUIRE(index.insert(height, slot_at(height + 1)));
+
+    std::atomic<bool> done{ false };
+    std::thread writer([&index, &done]()
+    {
+        // Swap the ten blocks above the fork, a reorg of equal length.
+        for (size_t round = 0; round < rounds; ++round)
+        {
+            std::map<size_t, slot> changes;
+            for (size_t height = fork; height < fork + 10; ++height)
+                changes.emplace(height, slot_at(height + round % 2 + 1));
+
+            index.apply(fork, changes, fork + 10);
+        }
+
+        done = true;
+    });
+
+    size_t failures = 0;
+    while (!done)
+    {
+        slot out;
+        if (index.size() != fork + 10 || !index.find(fork + 9, out))
+            ++failures;
+    }
+
+    writer.join();
+    BOOST_CHECK_EQUAL(failures, 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,194 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+
+#include <bitcoin/system.hpp>
+#include <bitcoin/database/container/ordered_index.hpp>
+#include <bitcoin/database/storage/raw_block.hpp>
+#include <bitcoin/database/storage/slot.hpp>
+
+using namespace bc;
+using namespace bc::database;
+using namespace bc::database::container;
+using namespace bc::database::storage;
+
+typedef ordered_index<uint64_t> index_type;
+
+// Slots only need distinct values here, the block is never read.
+static slot slot_at(uint32_t offset)
+{
+    return { reinterpret_cast<raw_block*>(uintptr_t(BLOCK_SIZE)), offset };
+}
+
+// The keys from begin to end, in iteration order.
+static std::vector<uint64_t> keys(index_type::const_iterator begin,
+    index_type::const_iterator end)
+{
+    std::vector<uint64_t> out;
+    for (auto it = begin; it != end; ++it)
+        out.push_back(it.key());
+
+    return out;
+}
+
+BOOST_AUTO_TEST_SUITE(ordered_index_tests)
+
+BOOST_AUTO_TEST_CASE(ordered_index__insert__unordered__iterates_in_order)
+{
+    index_type index;
+    slot out;
+    BOOST_CHECK(!index.find(5, out));
+    BOOST_CHECK(index.begin() == index.end());
+
+    for (const auto key: { 5, 1, 9, 3, 7 })
+        BOOST_REQUIRE(index.insert(key, slot_at(key)));
+
+    // already indexed
+    BOOST_CHECK(!index.insert(5, slot_at(50)));
+    BOOST_CHECK_EQUAL(index.size(), 5u);
+
+    BOOST_REQUIRE(index.find(5, out));
+    BOOST_CHECK(out == slot_at(5));
+    BOOST_CHECK(!index.find(4, out));
+
+    const std::vector<uint64_t> expected{ 1, 3, 5, 7, 9 };
+    const auto forward = keys(index.begin(), index.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(forward.begin(), forward.end(),
+        expected.begin(), expected.end());
+
+    std::vector<uint64_t> backward;
+    for (auto it = index.end(); it != index.begin();)
+        backward.push_back((--it).key());
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(backward.rbegin(), backward.rend(),
+        expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(ordered_index__bounds__range__expected_keys)
+{
+    index_type index;
+    for (uint64_t key = 0; key < 100; key += 10)
+        BOOST_REQUIRE(index.insert(key, slot_at(key + 1)));
+
+    const std::vector<uint64_t> expected{ 30, 40, 50 };
+    const auto range = keys(index.lower_bound(25), index.upper_bound(50));
+    BOOST_CHECK_EQUAL_COLLECTIONS(range.begin(), range.end(),
+        expected.begin(), expected.end());
+
+    BOOST_CHECK(index.lower_bound(91) == index.end());
+    BOOST_CHECK((*index.lower_bound(90)).second == slot_at(91));
+    BOOST_CHECK_EQUAL(index.upper_bound(40).key(), 50u);
+}
+
+BOOST_AUTO_TEST_CASE(ordered_index__erase__skipped_by_iteration__reinsert)
+{
+    index_type index;
+    for (uint64_t key = 1; key <= 5; ++key)
+        BOOST_REQUIRE(index.insert(key, slot_at(key)));
+
+    BOOST_REQUIRE(index.erase(3));
+    BOOST_REQUIRE(index.erase(5));
+    BOOST_CHECK(!index.erase(3));
+    BOOST_CHECK_EQUAL(index.size(), 3u);
+
+    slot out;
+    BOOST_CHECK(!index.find(3, out));
+
+    const std::vector<uint64_t> expected{ 1, 2, 4 };
+    const auto forward = keys(index.begin(), index.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(forward.begin(), forward.end(),
+        expected.begin(), expected.end());
+
+    // backward steps over erased keys, including the last
+    auto it = index.end();
+    BOOST_CHECK_EQUAL((--it).key(), 4u);
+    BOOST_CHECK_EQUAL((--it).key(), 2u);
+
+    BOOST_REQUIRE(index.insert(3, slot_at(30)));
+    BOOST_REQUIRE(index.find(3, out));
+    BOOST_CHECK(out == slot_at(30));
+
+    index.insert_or_assign(3, slot_at(31));
+    BOOST_REQUIRE(index.find(3, out));
+    BOOST_CHECK(out == slot_at(31));
+    BOOST_CHECK_EQUAL(index.size(), 4u);
+}
+
+BOOST_AUTO_TEST_CASE(ordered_index__bulk_load__sorted__loaded)
+{
+    index_type::value_list values;
+    for (uint64_t key = 0; key < 10000; ++key)
+        values.emplace_back(key * 2, slot_at(key % 1000 + 1));
+
+    index_type index;
+    BOOST_REQUIRE(index.bulk_load(values));
+    BOOST_CHECK_EQUAL(index.size(), values.size());
+
+    // not empty
+    BOOST_CHECK(!index.bulk_load(values));
+
+    slot out;
+    BOOST_REQUIRE(index.find(5000, out));
+    BOOST_CHECK(out == slot_at(2500 % 1000 + 1));
+    BOOST_CHECK(!index.find(5001, out));
+
+    // inserts land between loaded keys
+    BOOST_REQUIRE(index.insert(5001, slot_at(7)));
+    BOOST_CHECK_EQUAL(index.upper_bound(5000).key(), 5001u);
+    BOOST_CHECK_EQUAL((--index.end()).key(), 19998u);
+
+    index_type unsorted;
+    BOOST_CHECK(!unsorted.bulk_load({ { 2, slot_at(1) }, { 1, slot_at(2) } }));
+    BOOST_CHECK(unsorted.empty());
+}
+
+BOOST_AUTO_TEST_CASE(ordered_index__insert__concurrent__all_ordered)
+{
+    index_type index;
+    static const uint64_t per_thread = 20000;
+    static const uint64_t threads = 4;
+
+    // interleaved keys, so threads race on the same neighbours
+    std::vector<std::thread> writers;
+    for (uint64_t thread = 0; thread < threads; ++thread)
+        writers.emplace_back([&index, thread]()
+        {
+            for (uint64_t key = 0; key < per_thread; ++key)
+                index.insert(key * threads + thread, slot_at(thread + 1));
+        });
+
+    for (auto& writer: writers)
+        writer.join();
+
+    BOOST_CHECK_EQUAL(index.size(), per_thread * threads);
+
+    uint64_t expected = 0;
+    size_t failures = 0;
+    for (auto it = index.begin(); it != index.end(); ++it)
+        if (it.key() != expected++)
+            ++failures;
+
+    BOOST_CHECK_EQUAL(failures, 0u);
+    BOOST_CHECK_EQUAL(expected, per_thread * threads);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,252 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <map>
+#include <boost/test/unit_test.hpp>
+
+#include <bitcoin/system.hpp>
+#include <bitcoin/database/container/outpoint_index.hpp>
+#include <bitcoin/database/storage/raw_block.hpp>
+#include <bitcoin/database/storage/slot.hpp>
+
+using namespace bc;
+using namespace bc::database;
+using namespace bc::database::container;
+using namespace bc::database::storage;
+using namespace bc::system::chain;
+
+namespace {
+
+// Slots only need distinct values here, the block is never read.
+slot point_slot(uint32_t offset)
+{
+    return { reinterpret_cast<raw_block*>(uintptr_t(BLOCK_SIZE)), offset };
+}
+
+// Txids sharing their first 8 bytes, so their keys collide.
+point colliding_point(uint8_t tail, uint32_t index)
+{
+    system::hash_digest hash{};
+    hash[0] = 0x42;
+    hash[31] = tail;
+    return { hash, index };
+}
+
+// Stands in for the records, the outpoint stored at each slot offset.
+struct stored_points
+{
+    outpoint_index::verifier verifier()
+    {
+        return [this](const slot& at, const point& outpoint)
+        {
+            return points.at(at.get_offset()) == outpoint;
+        };
+    }
+
+    void add(uint32_t offset, const point& outpoint)
+    {
+        points[offset] = outpoint;
+    }
+
+    std::map<uint32_t, point> points;
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(outpoint_index_tests)
+
+BOOST_AUTO_TEST_CASE(outpoint_index__to_key__index_sizes__distinct_prefix_codes)
+{
+    system::hash_digest hash;
+    hash.fill(0xff);
+
+    outpoint_index::compact_key key;
+    BOOST_REQUIRE(outpoint_index::to_key({ hash, 5 }, key));
+    BOOST_CHECK_EQUAL(key, 0xffffffffffffff0au);
+
+    BOOST_REQUIRE(outpoint_index::to_key({ hash, 128 }, key));
+    BOOST_CHECK_EQUAL(key, 0xffffffffffff0201u);
+
+    BOOST_REQUIRE(outpoint_index::to_key({ hash, 1u << 14 }, key));
+    BOOST_CHECK_EQUAL(key, 0xffffffff00020003u);
+
+    BOOST_CHECK(!outpoint_index::to_key({ hash, 1u << 29 }, key));
+}
+
+BOOST_AUTO_TEST_CASE(outpoint_index__to_key__same_low_bits_other_index_size__differ)
+{
+    system::hash_digest hash{};
+    outpoint_index::compact_key small;
+    outpoint_index::compact_key large;
+    BOOST_REQUIRE(outpoint_index::to_key({ hash, 1 }, small));
+    BOOST_REQUIRE(outpoint_index::to_key({ hash, 1u << 7 }, large));
+    BOOST_CHECK(small != large);
+}
+
+BOOST_AUTO_TEST_CASE(outpoint_index__find__empty__failure)
+{
+    stored_points stored;
+    outpoint_index index(stored.verifier());
+    slot out;
+    BOOST_CHECK(!index.find(colliding_point(1, 0), out));
+    BOOST_CHECK_EQUAL(index.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(outpoint_index__insert__outputs_of_one_transaction__found)
+{
+    stored_points stored;
+    outpoint_index index(stored.verifier());
+
+    // Indexes of every key size.
+    const auto hash = system::bitcoin_hash({ 42 });
+    const std::vector<uint32_t> indexes{ 0, 1, 127, 128, 16383, 16384,
+        100000 };
+
+    for (uint32_t offset = 0; offset < indexes.size(); ++offset)
+    {
+        stored.add(offset + 1, { hash, indexes[offset] });
+        BOOST_REQUIRE(index.insert({ hash, indexes[offset] },
+            point_slot(offset + 1)));
+    }
+
+    for (uint32_t offset = 0; offset < indexes.size(); ++offset)
+    {
+        slot out;
+        BOOST_REQUIRE(index.find({ hash, indexes[offset] }, out));
+        BOOST_CHECK(out == point_slot(offset + 1));
+    }
+
+    slot out;
+    BOOST_CHECK(!index.find({ hash, 2 }, out));
+    BOOST_CHECK_EQUAL(index.overflow_size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(outpoint_index__insert__colliding__resolved_by_verifier)
+{
+    stored_points stored;
+    outpoint_index index(stored.verifier());
+
+    stored.add(1, colliding_point(1, 3));
+    stored.add(2, colliding_point(2, 3));
+    BOOST_REQUIRE(index.insert(colliding_point(1, 3), point_slot(1)));
+    BOOST_REQUIRE(index.insert(colliding_point(2, 3), point_slot(2)));
+    BOOST_CHECK_EQUAL(index.overflow_size(), 1u);
+    BOOST_CHECK_EQUAL(index.size(), 2u);
+
+    slot out;
+    BOOST_REQUIRE(index.find(colliding_point(2, 3), out));
+    BOOST_CHECK(out == point_slot(2));
+
+    // The same key, never inserted.
+    BOOST_CHECK(!index.find(colliding_point(3, 3), out));
+}
+
+BOOST_AUTO_TEST_CASE(outpoint_index__insert__index_too_large__kept_in_full)
+{
+    stored_points stored;
+    outpoint_index index(stored.verifier());
+
+    const auto outpoint = colliding_point(1, 1u << 30);
+    stored.add(1, outpoint);
+    BOOST_REQUIRE(index.insert(outpoint, point_slot(1)));
+    BOOST_CHECK_EQUAL(index.overflow_size(), 1u);
+    BOOST_CHECK(!index.insert(outpoint, point_slot(2)));
+
+    slot out;
+    BOOST_REQUIRE(index.find(outpoint, out));
+    BOOST_CHECK(out == point_slot(1));
+    BOOST_REQUIRE(index.erase(outpoint, point_slot(1)));
+    BOOST_CHECK_EQUAL(index.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(outpoint_index__insert__duplicate__failure)
+{
+    stored_points stored;
+    outpoint_index index(stored.verifier());
+
+    stored.add(1, colliding_point(1, 0));
+    stored.add(2, colliding_point(2, 0));
+    BOOST_REQUIRE(index.insert(colliding_point(1, 0), point_slot(1)));
+    BOOST_REQUIRE(index.insert(colliding_point(2, 0), point_slot(2)));
+
+    BOOST_CHECK(!index.insert(colliding_point(1, 0), point_slot(5)));
+    BOOST_CHECK(!index.insert(colliding_point(2, 0), point_slot(6)));
+    BOOST_CHECK_EQUAL(index.size(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(outpoint_index__erase__primary_and_overflow__success)
+{
+    stored_points stored;
+    outpoint_index index(stored.verifier());
+
+    stored.add(1, colliding_point(1, 0));
+    stored.add(2, colliding_point(2, 0));
+    BOOST_REQUIRE(index.insert(colliding_point(1, 0), point_slot(1)));
+    BOOST_REQUIRE(index.insert(colliding_point(2, 0), point_slot(2)));
+
+    // Only at the slot it is indexed at.
+    BOOST_CHECK(!index.erase(colliding_point(2, 0), point_slot(1)));
+    BOOST_REQUIRE(index.erase(colliding_point(2, 0), point_slot(2)));
+    BOOST_CHECK_EQUAL(index.overflow_size(), 0u);
+
+    slot out;
+    BOOST_CHECK(!index.find(colliding_point(2, 0), out));
+    BOOST_REQUIRE(index.erase(colliding_point(1, 0), point_slot(1)));
+    BOOST_CHECK(!index.find(colliding_point(1, 0), out));
+    BOOST_CHECK_EQUAL(index.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(outpoint_index__reserve__count__inserts_do_not_grow)
+{
+    static const uint32_t count = 300000;
+    stored_points stored;
+    outpoint_index index(stored.verifier());
+
+    index.reserve(count);
+    const auto capacity = index.capacity();
+    BOOST_REQUIRE_GE(capacity, count);
+    BOOST_CHECK_EQUAL(index.bytes(), outpoint_index::reserved_bytes(count));
+
+    // A few outputs each, as transactions have.
+    for (uint32_t offset = 1; offset <= count; ++offset)
+    {
+        const auto hash = system::bitcoin_hash({ uint8_t(offset >> 2),
+            uint8_t(offset >> 10), uint8_t(offset >> 18) });
+        const point outpoint{ hash, offset & 3 };
+        stored.add(offset, outpoint);
+        BOOST_REQUIRE(index.insert(outpoint, point_slot(offset)));
+    }
+
+    BOOST_CHECK_EQUAL(index.size(), count);
+    BOOST_CHECK_EQUAL(index.capacity(), capacity);
+}
+
+BOOST_AUTO_TEST_CASE(outpoint_index__reserved_bytes__twice_mainnet_unspent__fits_in_eight_gigabytes)
+{
+    // The utxo index holds the unspent outputs and those spent since
+    // the last reclaim. About twice the unspent outputs of mainnet
+    // leaves room for as many spends between reclaims.
+    static const size_t count = 400000000;
+    const auto bytes = outpoint_index::reserved_bytes(count);
+    BOOST_CHECK_LE(bytes, size_t(8) << 30);
+
+    // Twice as many outpoints doubles the table.
+    BOOST_CHECK_EQUAL(outpoint_index::reserved_bytes(count / 2), bytes / 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,139 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <bitcoin/database/container/height_index.hpp>
+#include <bitcoin/database/container/pending_heights.hpp>
+#include <bitcoin/database/storage/raw_block.hpp>
+#include <bitcoin/database/storage/slot.hpp>
+
+using namespace bc;
+using namespace bc::database;
+using namespace bc::database::container;
+using namespace bc::database::storage;
+
+// Slots only need distinct values here, the block is never read.
+static slot slot_at(uint32_t offset)
+{
+    return { reinterpret_cast<raw_block*>(uintptr_t(BLOCK_SIZE)), offset };
+}
+
+BOOST_AUTO_TEST_SUITE(pending_heights_tests)
+
+BOOST_AUTO_TEST_CASE(pending_heights__insert__not_in_base_until_applied)
+{
+    height_index base;
+    BOOST_REQUIRE(base.insert(0, slot_at(1)));
+
+    pending_heights pending;
+    pending.reset(base);
+    BOOST_REQUIRE(!pending.insert(base, 0, slot_at(9)));
+    BOOST_REQUIRE(pending.insert(base, 1, slot_at(2)));
+
+    slot out;
+    BOOST_REQUIRE(pending.find(base, 1, out));
+    BOOST_CHECK(out == slot_at(2));
+    BOOST_CHECK(!base.find(1, out));
+    BOOST_CHECK_EQUAL(pending.size(), 2u);
+
+    pending.apply(base);
+    BOOST_REQUIRE(base.find(1, out));
+    BOOST_CHECK(out == slot_at(2));
+    BOOST_CHECK_EQUAL(base.size(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(pending_heights__erase__hides_base_entry)
+{
+    height_index base;
+    for (uint32_t height = 0; height < 4; ++height)
+        BOOST_REQUIRE(base.insert(height, slot_at(height + 1)));
+
+    pending_heights pending;
+    pending.reset(base);
+    BOOST_REQUIRE(pending.erase(base, 3));
+    BOOST_REQUIRE(pending.erase(base, 1));
+    BOOST_CHECK(!pending.erase(base, 1));
+
+    slot out;
+    BOOST_CHECK(!pending.find(base, 1, out));
+    BOOST_CHECK(!pending.find(base, 3, out));
+    BOOST_REQUIRE(pending.find(base, 2, out));
+    BOOST_CHECK_EQUAL(pending.size(), 3u);
+
+    pending.apply(base);
+    BOOST_CHECK(!base.find(1, out));
+    BOOST_CHECK(base.find(2, out));
+    BOOST_CHECK_EQUAL(base.size(), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(pending_heights__erase__middle_then_tip__size_matches_base)
+{
+    height_index base;
+    for (uint32_t height = 0; height < 5; ++height)
+        BOOST_REQUIRE(base.insert(height, slot_at(height + 1)));
+
+    pending_heights pending;
+    pending.reset(base);
+    BOOST_REQUIRE(pending.erase(base, 2));
+    BOOST_REQUIRE(pending.erase(base, 3));
+    BOOST_REQUIRE(pending.erase(base, 4));
+    BOOST_CHECK_EQUAL(pending.size(), 2u);
+
+    pending.apply(base);
+    BOOST_CHECK_EQUAL(base.size(), pending.size());
+
+    pending.reset(base);
+    BOOST_REQUIRE(pending.erase(base, 0));
+    BOOST_REQUIRE(pending.erase(base, 1));
+    BOOST_CHECK_EQUAL(pending.size(), 0u);
+
+    pending.apply(base);
+    BOOST_CHECK_EQUAL(base.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(pending_heights__truncate__replaces_base_above)
+{
+    height_index base;
+    for (uint32_t height = 0; height < 10; ++height)
+        BOOST_REQUIRE(base.insert(height, slot_at(height + 1)));
+
+    pending_heights pending;
+    pending.reset(base);
+    pending.truncate(5);
+    pending.insert_or_assign(5, slot_at(50));
+    pending.insert_or_assign(8, slot_at(80));
+
+    slot out;
+    BOOST_REQUIRE(pending.find(base, 4, out));
+    BOOST_CHECK(out == slot_at(5));
+    BOOST_REQUIRE(pending.find(base, 5, out));
+    BOOST_CHECK(out == slot_at(50));
+    BOOST_CHECK(!pending.find(base, 6, out));
+    BOOST_CHECK_EQUAL(pending.size(), 9u);
+
+    pending.apply(base);
+    BOOST_CHECK_EQUAL(base.size(), 9u);
+    BOOST_REQUIRE(base.find(5, out));
+    BOOST_CHECK(out == slot_at(50));
+    BOOST_CHECK(!base.find(6, out));
+    BOOST_REQUIRE(base.find(8, out));
+    BOOST_CHECK(out == slot_at(80));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,149 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+
+#include <bitcoin/system.hpp>
+#include <bitcoin/database/container/art_index.hpp>
+#include <bitcoin/database/container/fingerprint_index.hpp>
+#include <bitcoin/database/container/secondary_index.hpp>
+#include <bitcoin/database/storage/raw_block.hpp>
+#include <bitcoin/database/storage/slot.hpp>
+
+using namespace bc;
+using namespace bc::database;
+using namespace bc::database::container;
+using namespace bc::database::storage;
+
+// Slots only need distinct values here, the block is never read.
+static slot slot_at(uint32_t offset)
+{
+    return { reinterpret_cast<raw_block*>(uintptr_t(BLOCK_SIZE)), offset };
+}
+
+// Stands in for the records, the hash at each slot offset.
+struct primary_records
+{
+    primary_records(size_t count)
+      : hashes(count + 1)
+    {
+        for (uint32_t offset = 1; offset <= count; ++offset)
+            hashes[offset] = system::bitcoin_hash({ uint8_t(offset) });
+    }
+
+    fingerprint_index::loader loader() const
+    {
+        return [this](const slot& at) -> const system::hash_digest&
+        {
+            return hashes.at(at.get_offset());
+        };
+    }
+
+    std::vector<system::hash_digest> hashes;
+};
+
+typedef secondary_index<uint64_t, system::hash_digest, fingerprint_index>
+    by_timestamp;
+
+BOOST_AUTO_TEST_SUITE(secondary_index_tests)
+
+BOOST_AUTO_TEST_CASE(secondary_index__find__through_primary__found)
+{
+    const primary_records stored(10);
+    const auto primary = std::make_shared<fingerprint_index>(stored.loader());
+    by_timestamp index(primary);
+
+    for (uint32_t offset = 1; offset <= 10; ++offset)
+    {
+        BOOST_REQUIRE(primary->insert(stored.hashes[offset], slot_at(offset)));
+        BOOST_REQUIRE(index.insert(1000 + offset, stored.hashes[offset]));
+    }
+
+    BOOST_CHECK(!index.insert(1001, stored.hashes[2]));
+    BOOST_CHECK_EQUAL(index.size(), 10u);
+
+    slot out;
+    BOOST_REQUIRE(index.find(1004, out));
+    BOOST_CHECK(out == slot_at(4));
+    BOOST_CHECK(!index.find(42, out));
+
+    system::hash_digest primary_key;
+    BOOST_REQUIRE(index.find_primary(1004, primary_key));
+    BOOST_CHECK(primary_key == stored.hashes[4]);
+
+    BOOST_REQUIRE(index.erase(1004));
+    BOOST_CHECK(!index.find(1004, out));
+}
+
+BOOST_AUTO_TEST_CASE(secondary_index__find__moved_record__new_slot)
+{
+    // the record of hashes[3] moves from offset 3 to offset 9
+    primary_records stored(9);
+    stored.hashes[9] = stored.hashes[3];
+    const auto primary = std::make_shared<fingerprint_index>(stored.loader());
+    by_timestamp index(primary);
+
+    BOOST_REQUIRE(primary->insert(stored.hashes[3], slot_at(3)));
+    BOOST_REQUIRE(index.insert(7, stored.hashes[3]));
+
+    // only the primary index is updated
+    BOOST_REQUIRE(primary->erase(stored.hashes[3], slot_at(3)));
+    BOOST_REQUIRE(primary->insert(stored.hashes[9], slot_at(9)));
+
+    slot out;
+    BOOST_REQUIRE(index.find(7, out));
+    BOOST_CHECK(out == slot_at(9));
+}
+
+BOOST_AUTO_TEST_CASE(secondary_index__find__batch__found_and_prefetched)
+{
+    const primary_records stored(20);
+    const auto primary = std::make_shared<art_index>(stored.loader());
+    secondary_index<uint64_t, system::hash_digest, art_index> index(primary);
+
+    for (uint32_t offset = 1; offset <= 20; ++offset)
+    {
+        BOOST_REQUIRE(primary->insert(stored.hashes[offset], slot_at(offset)));
+        BOOST_REQUIRE(index.insert(offset * 10, stored.hashes[offset]));
+    }
+
+    // mapped, but the primary key is not indexed
+    BOOST_REQUIRE(primary->erase(stored.hashes[5], slot_at(5)));
+
+    const std::vector<uint64_t> keys{ 10, 15, 50, 200, 30 };
+    std::vector<slot> slots;
+    size_t prefetched = 0;
+    const auto found = index.find(keys, slots, [&](const slot&)
+    {
+        ++prefetched;
+    });
+
+    BOOST_CHECK_EQUAL(found, 3u);
+    BOOST_CHECK_EQUAL(prefetched, 3u);
+    BOOST_REQUIRE_EQUAL(slots.size(), keys.size());
+    BOOST_CHECK(slots[0] == slot_at(1));
+    BOOST_CHECK(!slots[1]);
+    BOOST_CHECK(!slots[2]);
+    BOOST_CHECK(slots[3] == slot_at(20));
+    BOOST_CHECK(slots[4] == slot_at(3));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
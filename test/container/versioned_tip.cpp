@@ -0,0 +1,99 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <bitcoin/database/container/versioned_tip.hpp>
+
+using namespace bc;
+using namespace bc::database;
+using namespace bc::database::container;
+
+BOOST_AUTO_TEST_SUITE(versioned_tip_tests)
+
+BOOST_AUTO_TEST_CASE(versioned_tip__find__initial__empty)
+{
+    versioned_tip tip;
+    size_t size = 42;
+    BOOST_REQUIRE(tip.find(0, size));
+    BOOST_CHECK_EQUAL(size, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(versioned_tip__find__by_snapshot__success)
+{
+    versioned_tip tip;
+    tip.publish(10, 5);
+    tip.publish(20, 7);
+
+    size_t size;
+    BOOST_REQUIRE(tip.find(9, size));
+    BOOST_CHECK_EQUAL(size, 0u);
+    BOOST_REQUIRE(tip.find(10, size));
+    BOOST_CHECK_EQUAL(size, 5u);
+    BOOST_REQUIRE(tip.find(19, size));
+    BOOST_CHECK_EQUAL(size, 5u);
+    BOOST_REQUIRE(tip.find(25, size));
+    BOOST_CHECK_EQUAL(size, 7u);
+}
+
+BOOST_AUTO_TEST_CASE(versioned_tip__publish__older_timestamp__stamped_newer)
+{
+    versioned_tip tip;
+    tip.publish(20, 7);
+    tip.publish(15, 9);
+
+    size_t size;
+    BOOST_REQUIRE(tip.find(17, size));
+    BOOST_CHECK_EQUAL(size, 0u);
+    BOOST_REQUIRE(tip.find(20, size));
+    BOOST_CHECK_EQUAL(size, 9u);
+}
+
+BOOST_AUTO_TEST_CASE(versioned_tip__find__snapshot_older_than_ring__failure)
+{
+    const size_t versions = versioned_tip::versions;
+    versioned_tip tip;
+    for (size_t version = 1; version <= versions; ++version)
+        tip.publish(100 + version, version);
+
+    size_t size;
+    BOOST_CHECK(!tip.find(50, size));
+    BOOST_REQUIRE(tip.find(100 + versions, size));
+    BOOST_CHECK_EQUAL(size, versions);
+}
+
+BOOST_AUTO_TEST_CASE(versioned_tip__begin_write__second_writer__failure)
+{
+    versioned_tip tip;
+    BOOST_REQUIRE(tip.begin_write(3));
+    BOOST_CHECK(tip.begin_write(3));
+    BOOST_CHECK(!tip.begin_write(4));
+    BOOST_CHECK(tip.is_writer(3));
+
+    tip.commit_write(3, 1);
+    BOOST_CHECK(!tip.is_writer(3));
+    BOOST_REQUIRE(tip.begin_write(4));
+    tip.end_write(4);
+    BOOST_CHECK(!tip.is_writer(4));
+
+    size_t size;
+    BOOST_REQUIRE(tip.find(3, size));
+    BOOST_CHECK_EQUAL(size, 1u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
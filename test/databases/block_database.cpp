@@ -18,12 +18,16 @@
  */
 #include <boost/test/unit_test.hpp>
 
+#include <filesystem>
+#include <vector>
+
 #include <bitcoin/system.hpp>
 #include <bitcoin/database/block_state.hpp>
 #include <bitcoin/database/transaction_management/transaction_manager.hpp>
 #include <bitcoin/database/transaction_management/transaction_context.hpp>
 #include <bitcoin/database/tuples/block_tuple.hpp>
 #include <bitcoin/database/databases/block_database.hpp>
+#include <bitcoin/database/durability/log_manager.hpp>
 
 using namespace bc;
 using namespace bc::system::chain;
@@ -140,6 +144,30 @@ BOOST_AUTO_TEST_CASE(block_database__promote__candidate_then_confirmed__success)
     BOOST_CHECK_EQUAL(reloaded->state, block_state::confirmed);
 }
 
+BOOST_AUTO_TEST_CASE(block_database__promote__past_max_height__aborts)
+{
+    static const auto settings = system::settings(system::config::settings::mainnet);
+    const auto header = settings.genesis_block.header();
+
+    transaction_manager manager;
+    auto context = manager.begin_transaction();
+    block_database instance{10, 1, 10, 1};
+    BOOST_REQUIRE(instance.store(context, header, 100, 1, 200,
+        block_state::missing));
+    context.commit();
+
+    context = manager.begin_transaction();
+    BOOST_REQUIRE(!instance.promote(context, header.hash(),
+        container::height_index::max_height, true));
+    BOOST_REQUIRE(context.get_state() == state::aborted);
+
+    context = manager.begin_transaction();
+    size_t height;
+    BOOST_CHECK(!instance.top(context, height, true));
+    BOOST_CHECK_EQUAL(instance.get(context, header.hash())->state,
+        block_state::missing);
+}
+
 BOOST_AUTO_TEST_CASE(block_database__demote__candidate__success)
 {
     static const auto settings = system::settings(system::config::settings::mainnet);
@@ -172,7 +200,6 @@ BOOST_AUTO_TEST_CASE(block_database__demote__candidate__success)
 
     context.commit();
 
-    // the call to top will abort the context, undoing demote
     context = manager.begin_transaction();
 
     // Check conditions
@@ -180,7 +207,10 @@ BOOST_AUTO_TEST_CASE(block_database__demote__candidate__success)
     BOOST_CHECK(!instance.top(context, height, true));
     BOOST_CHECK_EQUAL(height, -1);
 
-    // start new context to `get` as top aborted earlier context
+    // top of an empty chain no longer aborts the context
+    BOOST_CHECK(context.get_state() == state::active);
+
+    // start new context to `get`
     context = manager.begin_transaction();
 
     reloaded = instance.get(context, block0.header().hash());
@@ -237,4 +267,702 @@ BOOST_AUTO_TEST_CASE(block_database__validate__from_candidate__success)
     BOOST_CHECK_EQUAL(reloaded->state, block_state::valid | block_state::candidate);
 }
 
+BOOST_AUTO_TEST_CASE(block_database__open__replays_redo_log__success)
+{
+    static const auto settings = system::settings(system::config::settings::mainnet);
+    const chain::block block0 = settings.genesis_block;
+    const auto hash = block0.header().hash();
+    const auto directory = (std::filesystem::temp_directory_path() /
+        "libbitcoin_mvcc_block_database_tests").string();
+
+    {
+        auto log = std::make_shared<durability::log_manager>(directory,
+            std::chrono::microseconds(1000), 4096, true);
+        block_database instance{log, 10, 1, 10, 1};
+        BOOST_REQUIRE(instance.create());
+
+        transaction_manager manager(log);
+        auto context = manager.begin_transaction();
+        BOOST_REQUIRE(instance.store(context, block0.header(), 0, 1, 200, 0));
+        BOOST_REQUIRE(instance.validate(context, hash, error::success));
+        BOOST_REQUIRE(instance.promote(context, hash, 0, true));
+        context.commit();
+
+        instance.commit();
+        BOOST_REQUIRE(instance.close());
+    }
+
+    auto log = std::make_shared<durability::log_manager>(directory,
+        std::chrono::microseconds(1000), 4096, true);
+    block_database instance{log, 10, 1, 10, 1};
+    BOOST_REQUIRE(instance.open());
+
+    transaction_manager manager(log);
+    auto context = manager.begin_transaction();
+
+    auto reloaded = instance.get(context, hash);
+    BOOST_REQUIRE(reloaded);
+    BOOST_CHECK_EQUAL(reloaded->state,
+        block_state::valid | block_state::candidate);
+    BOOST_CHECK(reloaded->merkle_root == block0.header().merkle_root());
+
+    size_t height = -1;
+    BOOST_CHECK(instance.top(context, height, true));
+    BOOST_CHECK_EQUAL(height, 0);
+    BOOST_REQUIRE(instance.close());
+}
+
+BOOST_AUTO_TEST_CASE(block_database__open__loads_checkpoint_and_log_tail__success)
+{
+    static const auto settings = system::settings(system::config::settings::mainnet);
+    const chain::block block0 = settings.genesis_block;
+    const auto hash = block0.header().hash();
+    const auto directory = (std::filesystem::temp_directory_path() /
+        "libbitcoin_mvcc_block_database_checkpoint_tests").string();
+
+    {
+        auto log = std::make_shared<durability::log_manager>(directory,
+            std::chrono::microseconds(1000), 4096, true);
+        block_database instance{log, 10, 1, 10, 1};
+        BOOST_REQUIRE(instance.create());
+
+        transaction_manager manager(log);
+        auto context = manager.begin_transaction();
+        BOOST_REQUIRE(instance.store(context, block0.header(), 0, 1, 200, 0));
+        BOOST_REQUIRE(instance.promote(context, hash, 0, true));
+        context.commit();
+
+        BOOST_REQUIRE(instance.checkpoint(manager));
+
+        // logged after the checkpoint, replayed from the log tail
+        context = manager.begin_transaction();
+        BOOST_REQUIRE(instance.validate(context, hash, error::success));
+        context.commit();
+
+        BOOST_REQUIRE(instance.close());
+        BOOST_CHECK(!std::filesystem::exists(log->segment_path(0)));
+    }
+
+    auto log = std::make_shared<durability::log_manager>(directory,
+        std::chrono::microseconds(1000), 4096, true);
+    block_database instance{log, 10, 1, 10, 1};
+    BOOST_REQUIRE(instance.open());
+
+    transaction_manager manager(log);
+    auto context = manager.begin_transaction();
+
+    auto reloaded = instance.get(context, hash);
+    BOOST_REQUIRE(reloaded);
+    BOOST_CHECK_EQUAL(reloaded->state,
+        block_state::valid | block_state::candidate);
+
+    size_t height = -1;
+    BOOST_CHECK(instance.top(context, height, true));
+    BOOST_CHECK_EQUAL(height, 0);
+    BOOST_REQUIRE(instance.close());
+}
+
+BOOST_AUTO_TEST_CASE(block_database__open__parallel_recovery__success)
+{
+    static const size_t blocks = 64;
+    static const auto settings = system::settings(system::config::settings::mainnet);
+    const auto genesis = settings.genesis_block.header();
+    const auto directory = (std::filesystem::temp_directory_path() /
+        "libbitcoin_mvcc_block_database_recovery_tests").string();
+
+    std::vector<chain::header> headers;
+    for (size_t height = 0; height < blocks; ++height)
+        headers.emplace_back(genesis.version(),
+            height == 0 ? genesis.previous_block_hash() :
+                headers[height - 1].hash(),
+            genesis.merkle_root(), genesis.timestamp(), genesis.bits(),
+            genesis.nonce() + height);
+
+    {
+        auto log = std::make_shared<durability::log_manager>(directory,
+            std::chrono::microseconds(1000), 4096, false);
+        block_database instance{log, 10, 1, 10, 1};
+        BOOST_REQUIRE(instance.create());
+        transaction_manager manager(log);
+
+        for (size_t height = 0; height < blocks; ++height)
+        {
+            // half from the checkpoint, half from the log tail
+            if (height == blocks / 2)
+                BOOST_REQUIRE(instance.checkpoint(manager));
+
+            auto context = manager.begin_transaction();
+            BOOST_REQUIRE(instance.store(context, headers[height], height,
+                1, 200, 0));
+            BOOST_REQUIRE(instance.promote(context, headers[height].hash(),
+                height, true));
+            context.commit();
+        }
+
+        instance.commit();
+        BOOST_REQUIRE(instance.close());
+    }
+
+    auto log = std::make_shared<durability::log_manager>(directory,
+        std::chrono::microseconds(1000), 4096, false);
+    block_database instance{log, 10, 1, 10, 1};
+    BOOST_REQUIRE(instance.open(4));
+
+    transaction_manager manager(log);
+    auto context = manager.begin_transaction();
+
+    size_t height = -1;
+    BOOST_CHECK(instance.top(context, height, true));
+    BOOST_CHECK_EQUAL(height, blocks - 1);
+
+    for (height = 0; height < blocks; ++height)
+    {
+        auto reloaded = instance.get(context, height, true);
+        BOOST_REQUIRE(reloaded);
+        BOOST_CHECK_EQUAL(reloaded->nonce, headers[height].nonce());
+        BOOST_CHECK_EQUAL(reloaded->state, block_state::candidate);
+    }
+
+    // links are rebuilt across the checkpoint and the log tail
+    system::hash_digest ancestor;
+    BOOST_REQUIRE(instance.get_ancestor(context, headers.back().hash(), 1,
+        ancestor));
+    BOOST_CHECK(ancestor == headers[1].hash());
+
+    BOOST_REQUIRE(instance.close());
+}
+
+BOOST_AUTO_TEST_CASE(block_database__store_headers__spans_store_blocks__success)
+{
+    static const size_t count = 10000;
+    static const auto settings = system::settings(system::config::settings::mainnet);
+    const auto genesis = settings.genesis_block.header();
+
+    chain::header::list headers;
+    for (size_t height = 0; height < count; ++height)
+        headers.emplace_back(genesis.version(), genesis.previous_block_hash(),
+            genesis.merkle_root(), genesis.timestamp(), genesis.bits(),
+            genesis.nonce() + height);
+
+    const std::vector<uint32_t> median_time_pasts(count, 42);
+
+    transaction_manager manager;
+    auto context = manager.begin_transaction();
+    block_database instance{10, 1, 10, 1};
+
+    BOOST_REQUIRE(instance.store_headers(context, headers, 100,
+        median_time_pasts, block_state::missing));
+    context.commit();
+
+    context = manager.begin_transaction();
+    for (size_t index = 0; index < count; index += 997)
+    {
+        auto stored = instance.get(context, headers[index].hash());
+        BOOST_REQUIRE(stored);
+        BOOST_CHECK_EQUAL(stored->height, 100 + index);
+        BOOST_CHECK_EQUAL(stored->nonce, headers[index].nonce());
+        BOOST_CHECK_EQUAL(stored->median_time_past, 42u);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(block_database__reserve__then_store_headers__success)
+{
+    static const size_t count = 1000;
+    static const auto settings = system::settings(system::config::settings::mainnet);
+    const auto genesis = settings.genesis_block.header();
+
+    chain::header::list headers;
+    for (size_t height = 0; height < count; ++height)
+        headers.emplace_back(genesis.version(), genesis.previous_block_hash(),
+            genesis.merkle_root(), genesis.timestamp(), genesis.bits(),
+            genesis.nonce() + height);
+
+    block_database instance{10, 1, 10, 1};
+    instance.reserve(2 * count);
+
+    transaction_manager manager;
+    auto context = manager.begin_transaction();
+    BOOST_REQUIRE(instance.store_headers(context, headers, 0,
+        std::vector<uint32_t>(count, 0), block_state::missing));
+    for (size_t height = 0; height < count; ++height)
+        BOOST_REQUIRE(instance.promote(context, headers[height].hash(),
+            height, true));
+
+    context.commit();
+
+    size_t top;
+    context = manager.begin_transaction();
+    BOOST_REQUIRE(instance.top(context, top, true));
+    BOOST_CHECK_EQUAL(top, count - 1);
+    BOOST_CHECK(instance.get(context, headers[count / 2].hash()));
+}
+
+BOOST_AUTO_TEST_CASE(block_database__filter_hashes__unknown_hash__rejected)
+{
+    static const size_t count = 100;
+    static const auto settings = system::settings(system::config::settings::mainnet);
+    const auto genesis = settings.genesis_block.header();
+
+    chain::header::list headers;
+    for (size_t height = 0; height < 2 * count; ++height)
+        headers.emplace_back(genesis.version(), genesis.previous_block_hash(),
+            genesis.merkle_root(), genesis.timestamp(), genesis.bits(),
+            genesis.nonce() + height);
+
+    const chain::header::list stored(headers.begin(),
+        headers.begin() + count);
+
+    block_database instance{10, 1, 10, 1};
+    BOOST_REQUIRE(instance.filter_hashes(count));
+
+    transaction_manager manager;
+    auto context = manager.begin_transaction();
+    BOOST_REQUIRE(instance.store_headers(context, stored, 0,
+        std::vector<uint32_t>(count, 0), block_state::missing));
+    context.commit();
+
+    context = manager.begin_transaction();
+    for (size_t height = 0; height < count; ++height)
+        BOOST_REQUIRE(instance.get(context, headers[height].hash()));
+
+    // The store also looks up hashes, count from here.
+    const auto before = instance.hash_lookup_counters();
+    for (size_t height = count; height < 2 * count; ++height)
+        BOOST_REQUIRE(!instance.get(context, headers[height].hash()));
+
+    const auto after = instance.hash_lookup_counters();
+    BOOST_CHECK_EQUAL(after.lookups - before.lookups, count);
+    BOOST_CHECK_GT(after.rejected - before.rejected, count * 9 / 10);
+
+    // The filter cannot be turned on over stored hashes.
+    BOOST_CHECK(!instance.filter_hashes(count));
+}
+
+BOOST_AUTO_TEST_CASE(block_database__multi_get__stored_and_unknown__found_stored)
+{
+    static const size_t count = 100;
+    static const auto settings = system::settings(system::config::settings::mainnet);
+    const auto genesis = settings.genesis_block.header();
+
+    chain::header::list headers;
+    for (size_t height = 0; height < 2 * count; ++height)
+        headers.emplace_back(genesis.version(), genesis.previous_block_hash(),
+            genesis.merkle_root(), genesis.timestamp(), genesis.bits(),
+            genesis.nonce() + height);
+
+    const chain::header::list stored(headers.begin(),
+        headers.begin() + count);
+
+    block_database instance{10, 1, 10, 1};
+    transaction_manager manager;
+    auto context = manager.begin_transaction();
+    BOOST_REQUIRE(instance.store_headers(context, stored, 0,
+        std::vector<uint32_t>(count, 0), block_state::missing));
+    context.commit();
+
+    // Stored and unknown hashes alternate, across several groups.
+    hash_list hashes;
+    for (size_t height = 0; height < count; ++height)
+    {
+        hashes.push_back(headers[height].hash());
+        hashes.push_back(headers[count + height].hash());
+    }
+
+    context = manager.begin_transaction();
+    std::vector<block_tuple_ptr> out;
+    BOOST_CHECK_EQUAL(instance.multi_get(context, hashes, out), count);
+    BOOST_REQUIRE_EQUAL(out.size(), hashes.size());
+
+    for (size_t height = 0; height < count; ++height)
+    {
+        BOOST_REQUIRE(out[2 * height]);
+        BOOST_CHECK_EQUAL(out[2 * height]->nonce, headers[height].nonce());
+        BOOST_CHECK(!out[2 * height + 1]);
+    }
+
+    // In sequence, the same blocks are found.
+    std::vector<block_tuple_ptr> sequential;
+    BOOST_CHECK_EQUAL(instance.multi_get(context, hashes, sequential, 1),
+        count);
+    for (size_t index = 0; index < hashes.size(); ++index)
+        BOOST_CHECK_EQUAL(!sequential[index], !out[index]);
+}
+
+BOOST_AUTO_TEST_CASE(block_database__multi_get__uncommitted__not_found)
+{
+    static const auto settings = system::settings(system::config::settings::mainnet);
+    const auto genesis = settings.genesis_block.header();
+
+    block_database instance{10, 1, 10, 1};
+    transaction_manager manager;
+    auto writer = manager.begin_transaction();
+    BOOST_REQUIRE(instance.store(writer, genesis, 0, 0, 0,
+        block_state::missing));
+
+    auto reader = manager.begin_transaction();
+    std::vector<block_tuple_ptr> out;
+    BOOST_CHECK_EQUAL(instance.multi_get(reader, { genesis.hash() }, out), 0u);
+    BOOST_CHECK_EQUAL(instance.multi_get(writer, { genesis.hash() }, out), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(block_database__store_headers__mismatched_sizes__failure)
+{
+    static const auto settings = system::settings(system::config::settings::mainnet);
+    const chain::header::list headers{ settings.genesis_block.header() };
+
+    transaction_manager manager;
+    auto context = manager.begin_transaction();
+    block_database instance{10, 1, 10, 1};
+
+    BOOST_CHECK(!instance.store_headers(context, headers, 0, {}, 0));
+}
+
+BOOST_AUTO_TEST_CASE(block_database__get_range__stops_at_tip__success)
+{
+    static const size_t count = 20;
+    static const auto settings = system::settings(system::config::settings::mainnet);
+    const auto genesis = settings.genesis_block.header();
+
+    chain::header::list headers;
+    for (size_t height = 0; height < count; ++height)
+        headers.emplace_back(genesis.version(), genesis.previous_block_hash(),
+            genesis.merkle_root(), genesis.timestamp(), genesis.bits(),
+            genesis.nonce() + height);
+
+    transaction_manager manager;
+    auto context = manager.begin_transaction();
+    block_database instance{10, 1, 10, 1};
+
+    BOOST_REQUIRE(instance.store_headers(context, headers, 0,
+        std::vector<uint32_t>(count, 0), block_state::missing));
+    for (size_t height = 0; height < count; ++height)
+        BOOST_REQUIRE(instance.promote(context, headers[height].hash(),
+            height, true));
+    context.commit();
+
+    context = manager.begin_transaction();
+    std::vector<block_tuple> blocks;
+    BOOST_REQUIRE_EQUAL(instance.get(context, 5, count + 10, true, blocks),
+        count - 5);
+    BOOST_REQUIRE_EQUAL(blocks.size(), count - 5);
+    BOOST_CHECK_EQUAL(blocks.front().nonce, headers[5].nonce());
+    BOOST_CHECK_EQUAL(blocks.back().nonce, headers[count - 1].nonce());
+    BOOST_CHECK_EQUAL(blocks.back().state, block_state::candidate);
+
+    system::data_chunk wire{ 0xff };
+    BOOST_REQUIRE_EQUAL(instance.get_headers(context, 3, 6, true, wire), 3u);
+    BOOST_REQUIRE_EQUAL(wire.size(), 1u + 3 * 80);
+    BOOST_CHECK_EQUAL(wire[0], 0xff);
+
+    const auto expected = headers[4].to_data();
+    BOOST_CHECK(std::equal(expected.begin(), expected.end(),
+        wire.begin() + 1 + 80));
+
+    // nothing indexed in the confirmed chain
+    BOOST_CHECK_EQUAL(instance.get_headers(context, 0, 10, false, wire), 0u);
+    BOOST_CHECK_EQUAL(wire.size(), 1u + 3 * 80);
+
+    // an unbounded range is read to the tip
+    wire.clear();
+    BOOST_CHECK_EQUAL(instance.get_headers(context, 0, SIZE_MAX, true, wire),
+        count);
+    BOOST_CHECK_EQUAL(wire.size(), count * 80);
+    blocks.clear();
+    BOOST_CHECK_EQUAL(instance.get(context, 0, SIZE_MAX, true, blocks), count);
+
+    hash_digest hash;
+    BOOST_REQUIRE(instance.get_hash(context, 7, true, hash));
+    BOOST_CHECK(hash == headers[7].hash());
+    BOOST_CHECK(!instance.get_hash(context, count, true, hash));
+}
+
+BOOST_AUTO_TEST_CASE(block_database__reorganize__swap_and_abort__success)
+{
+    static const size_t count = 10;
+    static const auto settings = system::settings(system::config::settings::mainnet);
+    const auto genesis = settings.genesis_block.header();
+
+    chain::header::list headers;
+    for (size_t height = 0; height < count; ++height)
+        headers.emplace_back(genesis.version(), genesis.previous_block_hash(),
+            genesis.merkle_root(), genesis.timestamp(), genesis.bits(),
+            genesis.nonce() + height);
+
+    transaction_manager manager;
+    auto context = manager.begin_transaction();
+    block_database instance{10, 1, 10, 1};
+
+    BOOST_REQUIRE(instance.store_headers(context, headers, 0,
+        std::vector<uint32_t>(count, 0), block_state::missing));
+    for (size_t height = 0; height < 8; ++height)
+        BOOST_REQUIRE(instance.promote(context, headers[height].hash(),
+            height, true));
+    context.commit();
+
+    // Pop 5..7, push headers 8 and 9 at heights 5 and 6.
+    const system::hash_list outgoing{ headers[5].hash(), headers[6].hash(),
+        headers[7].hash() };
+    const system::hash_list incoming{ headers[8].hash(), headers[9].hash() };
+
+    context = manager.begin_transaction();
+    BOOST_REQUIRE(!instance.reorganize(context, 4, incoming, outgoing, true));
+    BOOST_REQUIRE(context.get_state() == state::aborted);
+
+    context = manager.begin_transaction();
+    BOOST_REQUIRE(instance.reorganize(context, 4, outgoing, incoming, true));
+    context.commit();
+
+    context = manager.begin_transaction();
+    size_t top;
+    BOOST_REQUIRE(instance.top(context, top, true));
+    BOOST_CHECK_EQUAL(top, 6u);
+    BOOST_CHECK_EQUAL(instance.get(context, 5, true)->nonce, headers[8].nonce());
+    BOOST_CHECK_EQUAL(instance.get(context, 6, true)->nonce, headers[9].nonce());
+    BOOST_CHECK_EQUAL(instance.get(context, 6, true)->state,
+        block_state::candidate);
+    BOOST_CHECK_EQUAL(instance.get(context, headers[7].hash())->state,
+        block_state::missing);
+    context.commit();
+
+    // Reorganize back and abort, the index returns to 8 and 9.
+    context = manager.begin_transaction();
+    BOOST_REQUIRE(instance.reorganize(context, 4, incoming, outgoing, true));
+    BOOST_REQUIRE(instance.top(context, top, true));
+    BOOST_CHECK_EQUAL(top, 7u);
+    context.abort();
+
+    context = manager.begin_transaction();
+    BOOST_REQUIRE(instance.top(context, top, true));
+    BOOST_CHECK_EQUAL(top, 6u);
+    BOOST_CHECK_EQUAL(instance.get(context, 5, true)->nonce, headers[8].nonce());
+    BOOST_CHECK_EQUAL(instance.get(context, headers[5].hash())->state,
+        block_state::missing);
+}
+
+BOOST_AUTO_TEST_CASE(block_database__get_ancestor__chained_headers__success)
+{
+    static const size_t count = 3000;
+    static const auto settings = system::settings(system::config::settings::mainnet);
+    const auto genesis = settings.genesis_block.header();
+
+    chain::header::list headers;
+    for (size_t height = 0; height < count; ++height)
+        headers.emplace_back(genesis.version(),
+            height == 0 ? genesis.previous_block_hash() :
+                headers[height - 1].hash(),
+            genesis.merkle_root(), genesis.timestamp(), genesis.bits(),
+            genesis.nonce() + height);
+
+    transaction_manager manager;
+    auto context = manager.begin_transaction();
+    block_database instance{10, 1, 10, 1};
+
+    // The first batch in bulk, the rest one at a time.
+    const chain::header::list batch(headers.begin(), headers.begin() + 2000);
+    BOOST_REQUIRE(instance.store_headers(context, batch, 0,
+        std::vector<uint32_t>(batch.size(), 0), block_state::missing));
+    for (size_t height = batch.size(); height < count; ++height)
+        BOOST_REQUIRE(instance.store(context, headers[height], height, 0, 0,
+            block_state::missing));
+    context.commit();
+
+    context = manager.begin_transaction();
+    hash_digest ancestor;
+    for (const size_t height: { size_t(0), size_t(1), size_t(1023),
+        size_t(1999), size_t(2000), size_t(2998), count - 1 })
+    {
+        BOOST_REQUIRE(instance.get_ancestor(context, headers.back().hash(),
+            height, ancestor));
+        BOOST_CHECK(ancestor == headers[height].hash());
+    }
+
+    BOOST_REQUIRE(instance.get_ancestor(context, headers[1500].hash(), 700,
+        ancestor));
+    BOOST_CHECK(ancestor == headers[700].hash());
+
+    // Above the block itself.
+    BOOST_CHECK(!instance.get_ancestor(context, headers[10].hash(), 11,
+        ancestor));
+}
+
+BOOST_AUTO_TEST_CASE(block_database__compare_work__longer_branch_less_work__success)
+{
+    static const auto settings = system::settings(system::config::settings::mainnet);
+    const auto genesis = settings.genesis_block.header();
+    static const uint32_t easy_bits = 0x207f0000;
+
+    // main: heights 0..4, branch: heights 3..6 on main height 2
+    chain::header::list main;
+    for (size_t height = 0; height < 5; ++height)
+        main.emplace_back(genesis.version(),
+            height == 0 ? genesis.previous_block_hash() :
+                main[height - 1].hash(),
+            genesis.merkle_root(), genesis.timestamp(), genesis.bits(),
+            genesis.nonce() + height);
+
+    chain::header::list branch;
+    for (size_t offset = 0; offset < 4; ++offset)
+        branch.emplace_back(genesis.version(),
+            offset == 0 ? main[2].hash() : branch[offset - 1].hash(),
+            genesis.merkle_root(), genesis.timestamp(), easy_bits,
+            genesis.nonce() + 100 + offset);
+
+    transaction_manager manager;
+    auto context = manager.begin_transaction();
+    block_database instance{10, 1, 10, 1};
+
+    BOOST_REQUIRE(instance.store_headers(context, main, 0,
+        std::vector<uint32_t>(main.size(), 0), block_state::missing));
+    BOOST_REQUIRE(instance.store_headers(context, branch, 3,
+        std::vector<uint32_t>(branch.size(), 0), block_state::missing));
+    context.commit();
+
+    context = manager.begin_transaction();
+    system::uint256_t work;
+    BOOST_REQUIRE(instance.get_work(context, main.back().hash(), work));
+    BOOST_CHECK(work == 5 * chain::header::proof(genesis.bits()));
+
+    BOOST_REQUIRE(instance.get_work(context, branch.back().hash(), work));
+    BOOST_CHECK(work == 3 * chain::header::proof(genesis.bits()) +
+        4 * chain::header::proof(easy_bits));
+
+    int order;
+    BOOST_REQUIRE(instance.compare_work(context, main.back().hash(),
+        branch.back().hash(), order));
+    BOOST_CHECK_GT(order, 0);
+    BOOST_REQUIRE(instance.compare_work(context, branch.back().hash(),
+        main.back().hash(), order));
+    BOOST_CHECK_LT(order, 0);
+    BOOST_REQUIRE(instance.compare_work(context, main[2].hash(),
+        main[2].hash(), order));
+    BOOST_CHECK_EQUAL(order, 0);
+}
+
+BOOST_AUTO_TEST_CASE(block_database__locator__candidate_chain__success)
+{
+    static const size_t count = 100;
+    static const auto settings = system::settings(system::config::settings::mainnet);
+    const auto genesis = settings.genesis_block.header();
+
+    chain::header::list headers;
+    for (size_t height = 0; height < count; ++height)
+        headers.emplace_back(genesis.version(), genesis.previous_block_hash(),
+            genesis.merkle_root(), genesis.timestamp(), genesis.bits(),
+            genesis.nonce() + height);
+
+    transaction_manager manager;
+    auto context = manager.begin_transaction();
+    block_database instance{10, 1, 10, 1};
+
+    // An empty chain has no locator, the context remains usable.
+    system::hash_list locator;
+    BOOST_REQUIRE(!instance.locator(context, true, locator));
+    BOOST_REQUIRE(locator.empty());
+    BOOST_REQUIRE(context.get_state() == state::active);
+
+    BOOST_REQUIRE(instance.store_headers(context, headers, 0,
+        std::vector<uint32_t>(count, 0), block_state::missing));
+    for (size_t height = 0; height < count; ++height)
+        BOOST_REQUIRE(instance.promote(context, headers[height].hash(),
+            height, true));
+    context.commit();
+
+    // 99 down to 90, then 89, 87, 83, 75, 59, 27 and genesis.
+    context = manager.begin_transaction();
+    BOOST_REQUIRE(instance.locator(context, true, locator));
+    BOOST_REQUIRE_EQUAL(locator.size(), 17u);
+    BOOST_CHECK(locator.front() == headers[99].hash());
+    BOOST_CHECK(locator[9] == headers[90].hash());
+    BOOST_CHECK(locator[10] == headers[89].hash());
+    BOOST_CHECK(locator[15] == headers[27].hash());
+    BOOST_CHECK(locator.back() == headers[0].hash());
+}
+
+BOOST_AUTO_TEST_CASE(block_database__top__uncommitted_promote__not_visible)
+{
+    static const auto settings = system::settings(system::config::settings::mainnet);
+    const auto header = settings.genesis_block.header();
+
+    transaction_manager manager;
+    block_database instance{10, 1, 10, 1};
+
+    auto context = manager.begin_transaction();
+    BOOST_REQUIRE(instance.store(context, header, 0, 1, 200,
+        block_state::missing));
+    context.commit();
+
+    auto reader = manager.begin_transaction();
+    auto writer = manager.begin_transaction();
+    BOOST_REQUIRE(instance.promote(writer, header.hash(), 0, true));
+
+    // Only the writer sees its tip before it commits.
+    size_t height;
+    BOOST_CHECK(instance.top(writer, height, true));
+    BOOST_CHECK(!instance.top(reader, height, true));
+
+    // A second writer of the same chain is refused.
+    auto other = manager.begin_transaction();
+    BOOST_CHECK(!instance.demote(other, header.hash(), 0, true));
+
+    writer.commit();
+
+    // The reader's snapshot predates the writer.
+    BOOST_CHECK(!instance.top(reader, height, true));
+
+    auto later = manager.begin_transaction();
+    BOOST_REQUIRE(instance.top(later, height, true));
+    BOOST_CHECK_EQUAL(height, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(block_database__abort__index_changes_undone__success)
+{
+    static const auto settings = system::settings(system::config::settings::mainnet);
+    const auto genesis = settings.genesis_block.header();
+    const chain::header header1(genesis.version(), genesis.hash(),
+        genesis.merkle_root(), genesis.timestamp(), genesis.bits(),
+        genesis.nonce() + 1);
+
+    transaction_manager manager;
+    block_database instance{10, 1, 10, 1};
+
+    auto context = manager.begin_transaction();
+    BOOST_REQUIRE(instance.store(context, genesis, 0, 1, 200,
+        block_state::missing));
+    BOOST_REQUIRE(instance.promote(context, genesis.hash(), 0, true));
+    context.commit();
+
+    // Stored and promoted, then aborted.
+    auto writer = manager.begin_transaction();
+    BOOST_REQUIRE(instance.store(writer, header1, 1, 1, 200,
+        block_state::missing));
+    BOOST_REQUIRE(instance.promote(writer, header1.hash(), 1, true));
+    BOOST_REQUIRE(instance.get(writer, 1, true));
+
+    // Neither entry is visible outside the writer.
+    auto reader = manager.begin_transaction();
+    BOOST_CHECK(!instance.get(reader, header1.hash()));
+    reader = manager.begin_transaction();
+    BOOST_CHECK(!instance.get(reader, 1, true));
+
+    writer.abort();
+
+    context = manager.begin_transaction();
+    size_t height;
+    BOOST_REQUIRE(instance.top(context, height, true));
+    BOOST_CHECK_EQUAL(height, 0u);
+    BOOST_CHECK(!instance.get(context, header1.hash()));
+
+    // The hash can be stored again.
+    context = manager.begin_transaction();
+    BOOST_REQUIRE(instance.store(context, header1, 1, 1, 200,
+        block_state::missing));
+    BOOST_REQUIRE(instance.promote(context, header1.hash(), 1, true));
+    context.commit();
+
+    context = manager.begin_transaction();
+    BOOST_REQUIRE(instance.top(context, height, true));
+    BOOST_CHECK_EQUAL(height, 1u);
+    BOOST_CHECK_EQUAL(instance.get(context, 1, true)->nonce, header1.nonce());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
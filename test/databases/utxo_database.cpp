@@ -0,0 +1,585 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include <bitcoin/system.hpp>
+#include <bitcoin/database/durability/log_manager.hpp>
+#include <bitcoin/database/transaction_management/transaction_manager.hpp>
+#include <bitcoin/database/transaction_management/transaction_context.hpp>
+#include <bitcoin/database/tuples/utxo_tuple.hpp>
+#include <bitcoin/database/databases/utxo_database.hpp>
+
+using namespace bc;
+using namespace bc::system::chain;
+using namespace bc::database;
+using namespace bc::database::tuples;
+
+namespace {
+
+const auto utxo_directory = (std::filesystem::temp_directory_path() /
+    "libbitcoin_mvcc_utxo_database_tests").string();
+
+durability::log_manager_ptr utxo_log()
+{
+    return std::make_shared<durability::log_manager>(utxo_directory,
+        std::chrono::microseconds(1000), 4096, true);
+}
+
+system::data_chunk utxo_script(size_t size, uint8_t fill)
+{
+    return system::data_chunk(size, fill);
+}
+
+output utxo_output(uint64_t value, size_t script_size)
+{
+    return { value, { utxo_script(script_size, uint8_t(value)), false } };
+}
+
+point utxo_point(uint8_t fill, uint32_t index)
+{
+    system::hash_digest hash;
+    hash.fill(fill);
+    return { hash, index };
+}
+
+// A block of count transactions, each spending the outputs in spends
+// at its position, if any, with two 25 byte script outputs.
+chain::block utxo_block(size_t count, const point::list& spends,
+    uint32_t nonce)
+{
+    chain::transaction::list txs(count);
+    for (size_t tx = 0; tx < count; ++tx)
+    {
+        txs[tx].inputs().resize(1);
+        txs[tx].inputs()[0].previous_output().set_index(nonce);
+        if (tx != 0 && tx - 1 < spends.size())
+            txs[tx].inputs()[0].previous_output() = spends[tx - 1];
+
+        txs[tx].outputs().push_back(utxo_output(nonce * count + tx, 25));
+        txs[tx].outputs().push_back(utxo_output(1, 25));
+    }
+
+    chain::block block;
+    block.set_transactions(txs);
+    return block;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(utxo_database_tests)
+
+BOOST_AUTO_TEST_CASE(utxo_database__store__get__found)
+{
+    utxo_database instance{10, 1, 10, 1};
+    transaction_manager manager;
+    auto context = manager.begin_transaction();
+
+    const auto point = utxo_point(1, 2);
+    BOOST_REQUIRE(instance.store(context, point, utxo_output(42, 25), 7));
+    context.commit();
+
+    context = manager.begin_transaction();
+    const auto output = instance.get(context, point);
+    BOOST_REQUIRE(output);
+    BOOST_CHECK_EQUAL(output->value, 42u);
+    BOOST_CHECK_EQUAL(output->height, 7u);
+    BOOST_CHECK_EQUAL(output->script_size, 25u);
+    BOOST_CHECK(output->is_inline());
+
+    system::data_chunk script;
+    BOOST_REQUIRE(instance.get_script(point, *output, script));
+    BOOST_CHECK(script == utxo_script(25, 42));
+    BOOST_CHECK_EQUAL(instance.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(utxo_database__get__unknown__aborts)
+{
+    utxo_database instance{10, 1, 10, 1};
+    transaction_manager manager;
+    auto context = manager.begin_transaction();
+
+    BOOST_CHECK(!instance.get(context, utxo_point(1, 0)));
+    BOOST_CHECK(context.get_state() == state::aborted);
+}
+
+BOOST_AUTO_TEST_CASE(utxo_database__store__long_script__kept_outside_tuple)
+{
+    utxo_database instance{10, 1, 10, 1};
+    transaction_manager manager;
+    auto context = manager.begin_transaction();
+
+    const auto point = utxo_point(1, 0);
+    BOOST_REQUIRE(instance.store(context, point, utxo_output(3, 67), 0));
+    context.commit();
+
+    context = manager.begin_transaction();
+    const auto output = instance.get(context, point);
+    BOOST_REQUIRE(output);
+    BOOST_CHECK(!output->is_inline());
+
+    system::data_chunk script;
+    BOOST_REQUIRE(instance.get_script(point, *output, script));
+    BOOST_CHECK(script == utxo_script(67, 3));
+}
+
+BOOST_AUTO_TEST_CASE(utxo_database__store__colliding_keys__verified_against_outpoint)
+{
+    utxo_database instance{10, 1, 10, 1};
+    transaction_manager manager;
+    auto context = manager.begin_transaction();
+
+    // Txids differing past the 8 bytes kept in the key.
+    auto first = utxo_point(1, 0);
+    auto second = first;
+    auto hash = second.hash();
+    hash[31] = 2;
+    second = { hash, 0 };
+
+    BOOST_REQUIRE(instance.store(context, first, utxo_output(1, 25), 0));
+    BOOST_REQUIRE(instance.store(context, second, utxo_output(2, 25), 0));
+    context.commit();
+
+    context = manager.begin_transaction();
+    const auto first_output = instance.get(context, first);
+    const auto second_output = instance.get(context, second);
+    BOOST_REQUIRE(first_output);
+    BOOST_REQUIRE(second_output);
+    BOOST_CHECK_EQUAL(first_output->value, 1u);
+    BOOST_CHECK_EQUAL(second_output->value, 2u);
+
+    hash[31] = 3;
+    BOOST_CHECK(!instance.get(context, { hash, 0 }));
+}
+
+BOOST_AUTO_TEST_CASE(utxo_database__store__duplicate__aborts)
+{
+    utxo_database instance{10, 1, 10, 1};
+    transaction_manager manager;
+    auto context = manager.begin_transaction();
+
+    const auto point = utxo_point(1, 0);
+    BOOST_REQUIRE(instance.store(context, point, utxo_output(1, 25), 0));
+    context.commit();
+
+    context = manager.begin_transaction();
+    BOOST_CHECK(!instance.store(context, point, utxo_output(2, 25), 1));
+    BOOST_CHECK(context.get_state() == state::aborted);
+
+    // The first output is still indexed.
+    context = manager.begin_transaction();
+    const auto output = instance.get(context, point);
+    BOOST_REQUIRE(output);
+    BOOST_CHECK_EQUAL(output->value, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(utxo_database__store__aborted__unindexed)
+{
+    utxo_database instance{10, 1, 10, 1};
+    transaction_manager manager;
+    auto context = manager.begin_transaction();
+
+    const auto point = utxo_point(1, 0);
+    BOOST_REQUIRE(instance.store(context, point, utxo_output(1, 67), 0));
+    context.abort();
+    BOOST_CHECK_EQUAL(instance.size(), 0u);
+
+    // The point may be stored again.
+    context = manager.begin_transaction();
+    BOOST_REQUIRE(instance.store(context, point, utxo_output(2, 67), 0));
+    context.commit();
+
+    context = manager.begin_transaction();
+    const auto output = instance.get(context, point);
+    BOOST_REQUIRE(output);
+
+    system::data_chunk script;
+    BOOST_REQUIRE(instance.get_script(point, *output, script));
+    BOOST_CHECK(script == utxo_script(67, 2));
+}
+
+BOOST_AUTO_TEST_CASE(utxo_database__spend__twice__aborts_second)
+{
+    utxo_database instance{10, 1, 10, 1};
+    transaction_manager manager;
+    auto context = manager.begin_transaction();
+
+    const auto point = utxo_point(1, 0);
+    BOOST_REQUIRE(instance.store(context, point, utxo_output(1, 25), 0));
+    context.commit();
+
+    context = manager.begin_transaction();
+    BOOST_REQUIRE(instance.spend(context, point));
+
+    // Spending twice in the same context aborts it.
+    BOOST_CHECK(!instance.spend(context, point));
+    BOOST_CHECK(context.get_state() == state::aborted);
+
+    // The aborted spend is undone.
+    context = manager.begin_transaction();
+    BOOST_REQUIRE(instance.get(context, point));
+    BOOST_REQUIRE(instance.spend(context, point));
+    context.commit();
+
+    context = manager.begin_transaction();
+    BOOST_CHECK(!instance.get(context, point));
+}
+
+BOOST_AUTO_TEST_CASE(utxo_database__spend__unknown__aborts)
+{
+    utxo_database instance{10, 1, 10, 1};
+    transaction_manager manager;
+    auto context = manager.begin_transaction();
+
+    BOOST_CHECK(!instance.spend(context, utxo_point(1, 0)));
+    BOOST_CHECK(context.get_state() == state::aborted);
+}
+
+BOOST_AUTO_TEST_CASE(utxo_database__multi_get__stored_spent_and_unknown__found_unspent)
+{
+    static const uint32_t count = 100;
+    utxo_database instance{10, 1, 10, 1};
+    transaction_manager manager;
+    auto context = manager.begin_transaction();
+
+    for (uint32_t index = 0; index < count; ++index)
+        BOOST_REQUIRE(instance.store(context, utxo_point(1, index),
+            utxo_output(index, 25), index));
+    context.commit();
+
+    context = manager.begin_transaction();
+    BOOST_REQUIRE(instance.spend(context, utxo_point(1, 0)));
+    context.commit();
+
+    // Stored and unknown points alternate.
+    point::list points;
+    for (uint32_t index = 0; index < count; ++index)
+    {
+        points.push_back(utxo_point(1, index));
+        points.push_back(utxo_point(2, index));
+    }
+
+    context = manager.begin_transaction();
+    std::vector<utxo_tuple_ptr> out;
+    BOOST_CHECK_EQUAL(instance.multi_get(context, points, out), count - 1);
+    BOOST_REQUIRE_EQUAL(out.size(), points.size());
+    BOOST_CHECK(!out[0]);
+
+    for (uint32_t index = 1; index < count; ++index)
+    {
+        BOOST_REQUIRE(out[2 * index]);
+        BOOST_CHECK_EQUAL(out[2 * index]->value, index);
+        BOOST_CHECK(!out[2 * index + 1]);
+    }
+
+    // In sequence, the same outputs are found.
+    std::vector<utxo_tuple_ptr> sequential;
+    BOOST_CHECK_EQUAL(instance.multi_get(context, points, sequential, 1),
+        count - 1);
+    BOOST_CHECK(context.get_state() != state::aborted);
+}
+
+BOOST_AUTO_TEST_CASE(utxo_database__store_block__spend_block__spends_previous_outputs)
+{
+    utxo_database instance{10, 1, 10, 1};
+    transaction_manager manager;
+    auto context = manager.begin_transaction();
+
+    const auto block0 = utxo_block(10, {}, 0);
+    BOOST_REQUIRE(instance.store(context, block0, 0));
+    context.commit();
+    BOOST_CHECK_EQUAL(instance.size(), 20u);
+
+    point::list spends;
+    for (const auto& tx: block0.transactions())
+        spends.emplace_back(tx.hash(), 0);
+
+    const auto block1 = utxo_block(11, spends, 1);
+    context = manager.begin_transaction();
+    BOOST_REQUIRE(instance.store(context, block1, 1));
+    BOOST_REQUIRE(instance.spend(context, block1));
+    context.commit();
+
+    context = manager.begin_transaction();
+    for (const auto& tx: block0.transactions())
+    {
+        BOOST_CHECK(!instance.get(context, { tx.hash(), 0 }));
+        context = manager.begin_transaction();
+        BOOST_CHECK(instance.get(context, { tx.hash(), 1 }));
+    }
+
+    // The coinbase spends nothing, every output of block1 is unspent.
+    for (const auto& tx: block1.transactions())
+    {
+        const auto output = instance.get(context, { tx.hash(), 0 });
+        BOOST_REQUIRE(output);
+        BOOST_CHECK_EQUAL(output->height, 1u);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(utxo_database__spend_block__double_spend__aborts_all)
+{
+    utxo_database instance{10, 1, 10, 1};
+    transaction_manager manager;
+    auto context = manager.begin_transaction();
+
+    const auto block0 = utxo_block(3, {}, 0);
+    BOOST_REQUIRE(instance.store(context, block0, 0));
+    context.commit();
+
+    const auto spent = point{ block0.transactions()[1].hash(), 0 };
+    const auto block1 = utxo_block(3, { spent, spent }, 1);
+    context = manager.begin_transaction();
+    BOOST_CHECK(!instance.spend(context, block1));
+    BOOST_CHECK(context.get_state() == state::aborted);
+
+    context = manager.begin_transaction();
+    BOOST_CHECK(instance.get(context, spent));
+}
+
+BOOST_AUTO_TEST_CASE(utxo_database__store_block__op_return__not_stored)
+{
+    utxo_database instance{10, 1, 10, 1};
+    transaction_manager manager;
+    auto context = manager.begin_transaction();
+
+    auto block = utxo_block(1, {}, 0);
+    block.transactions()[0].outputs()[1] =
+        output{ 0, { utxo_script(40, 0x6a), false } };
+
+    BOOST_REQUIRE(instance.store(context, block, 0));
+    context.commit();
+    BOOST_CHECK_EQUAL(instance.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(utxo_database__reclaim__spent_before_oldest_active__unindexed)
+{
+    utxo_database instance{10, 1, 10, 1};
+    transaction_manager manager;
+    auto context = manager.begin_transaction();
+
+    const auto kept = utxo_point(1, 0);
+    const auto spent = utxo_point(2, 0);
+    const auto long_spent = utxo_point(3, 0);
+    BOOST_REQUIRE(instance.store(context, kept, utxo_output(1, 25), 0));
+    BOOST_REQUIRE(instance.store(context, spent, utxo_output(2, 25), 0));
+    BOOST_REQUIRE(instance.store(context, long_spent, utxo_output(3, 67), 0));
+    context.commit();
+    manager.remove_transaction(context);
+
+    auto reader = manager.begin_transaction();
+    auto writer = manager.begin_transaction();
+    BOOST_REQUIRE(instance.spend(writer, point::list{ spent, long_spent }));
+    writer.commit();
+    manager.remove_transaction(writer);
+
+    // The reader began before the spend, it may still read both.
+    BOOST_CHECK_EQUAL(instance.reclaim(manager), 0u);
+    BOOST_CHECK_EQUAL(instance.size(), 3u);
+
+    reader.commit();
+    manager.remove_transaction(reader);
+    BOOST_CHECK_EQUAL(instance.reclaim(manager), 2u);
+    BOOST_CHECK_EQUAL(instance.size(), 1u);
+
+    context = manager.begin_transaction();
+    std::vector<utxo_tuple_ptr> out;
+    BOOST_CHECK_EQUAL(instance.multi_get(context,
+        { kept, spent, long_spent }, out), 1u);
+    BOOST_CHECK(out[0]);
+
+    utxo_tuple long_output;
+    long_output.script_size = 67;
+    system::data_chunk script;
+    BOOST_CHECK(!instance.get_script(long_spent, long_output, script));
+}
+
+BOOST_AUTO_TEST_CASE(utxo_database__reclaim__store_spend_rounds__index_does_not_grow)
+{
+    static const uint32_t count = 200;
+    utxo_database instance{10, 1, 10, 1};
+    instance.reserve(count);
+    const auto bytes = instance.index_bytes();
+    transaction_manager manager;
+
+    // Eight times the reserved count pass through the index.
+    for (uint8_t round = 0; round < 8; ++round)
+    {
+        point::list points;
+        auto context = manager.begin_transaction();
+        for (uint32_t index = 0; index < count; ++index)
+        {
+            points.push_back(utxo_point(round, index));
+            BOOST_REQUIRE(instance.store(context, points.back(),
+                utxo_output(index, 25), round));
+        }
+
+        context.commit();
+        manager.remove_transaction(context);
+
+        context = manager.begin_transaction();
+        BOOST_REQUIRE(instance.spend(context, points));
+        context.commit();
+        manager.remove_transaction(context);
+
+        BOOST_REQUIRE_EQUAL(instance.reclaim(manager), count);
+        BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+    }
+
+    BOOST_CHECK_EQUAL(instance.index_bytes(), bytes);
+}
+
+BOOST_AUTO_TEST_CASE(utxo_database__reclaim__after_checkpoint__unindexed)
+{
+    const auto kept = utxo_point(1, 0);
+    const auto spent = utxo_point(2, 0);
+
+    const auto log = utxo_log();
+    utxo_database instance{log, 10, 1, 10, 1};
+    BOOST_REQUIRE(instance.create());
+
+    transaction_manager manager(log);
+    auto context = manager.begin_transaction();
+    BOOST_REQUIRE(instance.store(context, kept, utxo_output(1, 25), 0));
+    BOOST_REQUIRE(context.commit());
+    manager.remove_transaction(context);
+    BOOST_REQUIRE(instance.checkpoint(manager));
+
+    // Stored and spent after the checkpoint snapshot.
+    context = manager.begin_transaction();
+    BOOST_REQUIRE(instance.store(context, spent, utxo_output(2, 25), 1));
+    BOOST_REQUIRE(context.commit());
+    manager.remove_transaction(context);
+
+    context = manager.begin_transaction();
+    BOOST_REQUIRE(instance.spend(context, spent));
+    BOOST_REQUIRE(context.commit());
+    manager.remove_transaction(context);
+
+    BOOST_CHECK_EQUAL(instance.reclaim(manager), 1u);
+    BOOST_CHECK_EQUAL(instance.size(), 1u);
+    BOOST_REQUIRE(instance.close());
+}
+
+BOOST_AUTO_TEST_CASE(utxo_database__open__replays_stores_and_spends)
+{
+    const auto kept = utxo_point(1, 0);
+    const auto spent = utxo_point(2, 0);
+    const auto long_kept = utxo_point(3, 1);
+
+    {
+        const auto log = utxo_log();
+        utxo_database instance{log, 10, 1, 10, 1};
+        BOOST_REQUIRE(instance.create());
+
+        transaction_manager manager(log);
+        auto context = manager.begin_transaction();
+        BOOST_REQUIRE(instance.store(context, kept, utxo_output(42, 25), 7));
+        BOOST_REQUIRE(instance.store(context, spent, utxo_output(5, 25), 7));
+        BOOST_REQUIRE(instance.store(context, long_kept, utxo_output(3, 67),
+            8));
+        BOOST_REQUIRE(context.commit());
+
+        context = manager.begin_transaction();
+        BOOST_REQUIRE(instance.spend(context, spent));
+        BOOST_REQUIRE(context.commit());
+        BOOST_REQUIRE(instance.close());
+    }
+
+    const auto log = utxo_log();
+    utxo_database instance{log, 10, 1, 10, 1};
+    BOOST_REQUIRE(instance.open());
+    BOOST_CHECK_EQUAL(instance.size(), 2u);
+
+    transaction_manager manager(log);
+    auto context = manager.begin_transaction();
+    const auto output = instance.get(context, kept);
+    BOOST_REQUIRE(output);
+    BOOST_CHECK_EQUAL(output->value, 42u);
+    BOOST_CHECK_EQUAL(output->height, 7u);
+
+    const auto long_output = instance.get(context, long_kept);
+    BOOST_REQUIRE(long_output);
+
+    system::data_chunk script;
+    BOOST_REQUIRE(instance.get_script(long_kept, *long_output, script));
+    BOOST_CHECK(script == utxo_script(67, 3));
+
+    std::vector<utxo_tuple_ptr> out;
+    BOOST_CHECK_EQUAL(instance.multi_get(context, { spent }, out), 0u);
+    BOOST_REQUIRE(instance.close());
+}
+
+BOOST_AUTO_TEST_CASE(utxo_database__open__checkpoint_and_log_tail__unspent_only)
+{
+    const auto early = utxo_point(1, 0);
+    const auto kept = utxo_point(2, 0);
+    const auto late = utxo_point(3, 0);
+
+    {
+        const auto log = utxo_log();
+        utxo_database instance{log, 10, 1, 10, 1};
+        BOOST_REQUIRE(instance.create());
+
+        transaction_manager manager(log);
+        auto context = manager.begin_transaction();
+        BOOST_REQUIRE(instance.store(context, early, utxo_output(1, 25), 0));
+        BOOST_REQUIRE(instance.store(context, kept, utxo_output(2, 67), 0));
+        BOOST_REQUIRE(context.commit());
+        BOOST_REQUIRE(instance.checkpoint(manager));
+
+        // logged after the checkpoint, replayed from the log tail
+        context = manager.begin_transaction();
+        BOOST_REQUIRE(instance.spend(context, early));
+        BOOST_REQUIRE(instance.store(context, late, utxo_output(3, 25), 1));
+        BOOST_REQUIRE(context.commit());
+        BOOST_REQUIRE(instance.close());
+    }
+
+    // The spent output is left out of a second checkpoint.
+    for (auto reopen = 0; reopen < 2; ++reopen)
+    {
+        const auto log = utxo_log();
+        utxo_database instance{log, 10, 1, 10, 1};
+        BOOST_REQUIRE(instance.open(2));
+        BOOST_CHECK_EQUAL(instance.size(), 2u);
+
+        transaction_manager manager(log);
+        auto context = manager.begin_transaction();
+        std::vector<utxo_tuple_ptr> out;
+        BOOST_CHECK_EQUAL(instance.multi_get(context, { early, kept, late },
+            out), 2u);
+        BOOST_CHECK(!out[0]);
+        BOOST_REQUIRE(out[1]);
+
+        system::data_chunk script;
+        BOOST_REQUIRE(instance.get_script(kept, *out[1], script));
+        BOOST_CHECK(script == utxo_script(67, 2));
+        BOOST_REQUIRE(context.commit());
+
+        BOOST_REQUIRE(instance.checkpoint(manager));
+        BOOST_REQUIRE(instance.close());
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
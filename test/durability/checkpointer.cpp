@@ -0,0 +1,150 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <filesystem>
+
+#include <bitcoin/system.hpp>
+#include <bitcoin/database/durability/checkpoint_file.hpp>
+#include <bitcoin/database/durability/checkpointer.hpp>
+#include <bitcoin/database/durability/log_manager.hpp>
+#include <bitcoin/database/transaction_management/transaction_manager.hpp>
+
+using namespace bc;
+using namespace bc::database;
+using namespace bc::database::durability;
+
+static const std::string checkpoint_directory =
+    (std::filesystem::temp_directory_path() /
+        "libbitcoin_mvcc_checkpointer_tests").string();
+
+static log_manager_ptr make_log()
+{
+    auto log = std::make_shared<log_manager>(checkpoint_directory,
+        std::chrono::microseconds(1000), 4096, false);
+    BOOST_REQUIRE(log->create());
+    return log;
+}
+
+BOOST_AUTO_TEST_SUITE(checkpointer_tests)
+
+BOOST_AUTO_TEST_CASE(checkpoint_writer__write_at__round_trip__success)
+{
+    const auto path = (std::filesystem::path(checkpoint_directory) /
+        "round_trip.dat").string();
+    std::filesystem::create_directories(checkpoint_directory);
+
+    {
+        checkpoint_writer writer(path);
+        BOOST_REQUIRE(writer.open(42, 3));
+        BOOST_CHECK_EQUAL(writer.position(), checkpoint_header_size);
+
+        const auto count_position = writer.position();
+        BOOST_REQUIRE(writer.write(uint64_t(0)));
+        BOOST_REQUIRE(writer.write(uint32_t(7)));
+        BOOST_REQUIRE(writer.write_at(count_position, uint64_t(1)));
+        BOOST_REQUIRE(writer.commit());
+    }
+
+    checkpoint_reader reader(path);
+    BOOST_REQUIRE(reader.open());
+    BOOST_CHECK_EQUAL(reader.snapshot(), 42u);
+    BOOST_CHECK_EQUAL(reader.segment(), 3u);
+
+    uint64_t count;
+    uint32_t value;
+    BOOST_REQUIRE(reader.read(count));
+    BOOST_REQUIRE(reader.read(value));
+    BOOST_CHECK_EQUAL(count, 1u);
+    BOOST_CHECK_EQUAL(value, 7u);
+    BOOST_CHECK(!reader.read(value));
+}
+
+BOOST_AUTO_TEST_CASE(checkpoint_writer__not_committed__leaves_no_file)
+{
+    const auto path = (std::filesystem::path(checkpoint_directory) /
+        "abandoned.dat").string();
+    std::filesystem::create_directories(checkpoint_directory);
+
+    {
+        checkpoint_writer writer(path);
+        BOOST_REQUIRE(writer.open(1, 0));
+    }
+
+    BOOST_CHECK(!std::filesystem::exists(path));
+    BOOST_CHECK(!std::filesystem::exists(path + ".tmp"));
+}
+
+BOOST_AUTO_TEST_CASE(checkpointer__load__no_checkpoint__replay_all)
+{
+    auto log = make_log();
+    checkpointer instance(log);
+    BOOST_REQUIRE(instance.create());
+
+    size_t segment = 42;
+    auto called = false;
+    BOOST_REQUIRE(instance.load([&called](checkpoint_reader&)
+    {
+        called = true;
+        return true;
+    }, segment));
+
+    BOOST_CHECK(!called);
+    BOOST_CHECK_EQUAL(segment, 0u);
+    BOOST_REQUIRE(log->close());
+}
+
+BOOST_AUTO_TEST_CASE(checkpointer__checkpoint__truncates_log__success)
+{
+    auto log = make_log();
+    checkpointer instance(log);
+    BOOST_REQUIRE(instance.create());
+    transaction_manager manager(log);
+
+    system::data_chunk payload;
+    write_redo_record(payload, table_id::block, redo_operation::insert,
+        uint32_t(1), uint64_t(10));
+    log->append(2, payload);
+
+    timestamp_t saved_snapshot = 0;
+    BOOST_REQUIRE(instance.checkpoint(manager,
+        [&saved_snapshot](checkpoint_writer& writer, timestamp_t snapshot)
+        {
+            saved_snapshot = snapshot;
+            return writer.write(uint32_t(7));
+        }));
+
+    // the frame logged before the checkpoint is gone with its segment
+    BOOST_CHECK(!std::filesystem::exists(log->segment_path(0)));
+    BOOST_CHECK(std::filesystem::exists(instance.checkpoint_path(1)));
+    BOOST_REQUIRE(log->close());
+
+    size_t segment;
+    uint32_t value = 0;
+    BOOST_REQUIRE(instance.load([&value](checkpoint_reader& reader)
+    {
+        return reader.read(value);
+    }, segment));
+
+    BOOST_CHECK_EQUAL(value, 7u);
+    BOOST_CHECK_EQUAL(segment, 1u);
+    BOOST_CHECK(saved_snapshot > durability::recovery_timestamp);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
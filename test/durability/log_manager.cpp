@@ -0,0 +1,196 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <filesystem>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+#include <bitcoin/system.hpp>
+#include <bitcoin/database/durability/log_manager.hpp>
+#include <bitcoin/database/durability/redo_record.hpp>
+
+using namespace bc;
+using namespace bc::database;
+using namespace bc::database::durability;
+
+static const std::string log_directory = (std::filesystem::temp_directory_path()
+    / "libbitcoin_mvcc_log_manager_tests").string();
+
+static system::data_chunk make_payload(uint32_t key, uint64_t value)
+{
+    system::data_chunk payload;
+    write_redo_record(payload, table_id::block, redo_operation::insert, key,
+        value);
+    return payload;
+}
+
+static std::vector<uint64_t> replay_values(const log_manager& log,
+    size_t from_segment=0)
+{
+    std::vector<uint64_t> values;
+    BOOST_REQUIRE(log.replay(from_segment,
+        [&values](timestamp_t, const redo_record& record)
+        {
+            uint64_t value;
+            BOOST_REQUIRE(record.read_value(value));
+            values.push_back(value);
+        }));
+    return values;
+}
+
+BOOST_AUTO_TEST_SUITE(log_manager_tests)
+
+BOOST_AUTO_TEST_CASE(log_manager__append__flush__replays_in_order)
+{
+    log_manager log(log_directory, std::chrono::microseconds(1000), 4096,
+        false);
+    BOOST_REQUIRE(log.create());
+
+    log.append(1, make_payload(1, 10));
+    const auto lsn = log.append(2, make_payload(2, 20));
+    log.flush();
+
+    BOOST_CHECK_EQUAL(log.durable_lsn(), lsn);
+    BOOST_REQUIRE(log.close());
+
+    const auto values = replay_values(log);
+    BOOST_REQUIRE_EQUAL(values.size(), 2u);
+    BOOST_CHECK_EQUAL(values[0], 10u);
+    BOOST_CHECK_EQUAL(values[1], 20u);
+}
+
+BOOST_AUTO_TEST_CASE(log_manager__wait__synchronous__durable)
+{
+    log_manager log(log_directory, std::chrono::microseconds(100), 4096,
+        true);
+    BOOST_REQUIRE(log.create());
+
+    const auto lsn = log.append(1, make_payload(1, 10));
+    log.wait(lsn);
+
+    BOOST_CHECK(log.durable_lsn() >= lsn);
+    BOOST_REQUIRE(log.close());
+}
+
+BOOST_AUTO_TEST_CASE(log_manager__replay__torn_tail__stops_at_last_frame)
+{
+    log_manager log(log_directory, std::chrono::microseconds(1000), 4096,
+        false);
+    BOOST_REQUIRE(log.create());
+    log.append(1, make_payload(1, 10));
+    BOOST_REQUIRE(log.close());
+
+    // Half written frame at the end of the segment.
+    {
+        std::ofstream file(log.segment_path(0),
+            std::ios::binary | std::ios::app);
+        const char torn[] = { 8, 0, 0, 0, 1, 2 };
+        file.write(torn, sizeof(torn));
+    }
+
+    const auto values = replay_values(log);
+    BOOST_REQUIRE_EQUAL(values.size(), 1u);
+    BOOST_CHECK_EQUAL(values[0], 10u);
+}
+
+BOOST_AUTO_TEST_CASE(log_manager__open__appends_to_new_segment)
+{
+    log_manager log(log_directory, std::chrono::microseconds(1000), 4096,
+        false);
+    BOOST_REQUIRE(log.create());
+    log.append(1, make_payload(1, 10));
+    BOOST_REQUIRE(log.close());
+
+    BOOST_REQUIRE(log.open());
+    log.append(2, make_payload(2, 20));
+    BOOST_REQUIRE(log.close());
+
+    BOOST_CHECK(std::filesystem::exists(log.segment_path(1)));
+    BOOST_CHECK_EQUAL(replay_values(log).size(), 2u);
+
+    const auto tail = replay_values(log, 1);
+    BOOST_REQUIRE_EQUAL(tail.size(), 1u);
+    BOOST_CHECK_EQUAL(tail[0], 20u);
+}
+
+BOOST_AUTO_TEST_CASE(log_manager__wait__write_fails__returns_false)
+{
+    log_manager log(log_directory, std::chrono::microseconds(100), 4096,
+        true);
+    BOOST_REQUIRE(log.create());
+    const auto durable = log.append(1, make_payload(1, 10));
+    BOOST_REQUIRE(log.wait(durable));
+
+    // Every write to the next segment fails with no space left.
+    std::filesystem::create_symlink("/dev/full", log.segment_path(1));
+    BOOST_REQUIRE_EQUAL(log.rotate(), 1u);
+
+    const auto lsn = log.append(2, make_payload(2, 20));
+    BOOST_CHECK(!log.wait(lsn));
+    BOOST_CHECK(log.is_failed());
+    BOOST_CHECK_EQUAL(log.durable_lsn(), durable);
+
+    // Later frames are refused, not buffered after the failed one.
+    BOOST_CHECK_EQUAL(log.append(3, make_payload(3, 30)), 0u);
+    BOOST_CHECK(!log.close());
+
+    std::filesystem::remove(log.segment_path(1));
+    BOOST_CHECK_EQUAL(replay_values(log).size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(log_manager__replay__partitioned__key_order_preserved)
+{
+    log_manager log(log_directory, std::chrono::microseconds(1000), 4096,
+        false);
+    BOOST_REQUIRE(log.create());
+
+    static const uint32_t keys = 16;
+    static const uint64_t updates = 8;
+    for (uint64_t value = 0; value < updates; ++value)
+        for (uint32_t key = 0; key < keys; ++key)
+            log.append(value + 1, make_payload(key, value));
+
+    BOOST_REQUIRE(log.close());
+
+    std::mutex mutex;
+    std::vector<std::vector<uint64_t>> values(keys);
+    BOOST_REQUIRE(log.replay(0,
+        [&](timestamp_t, const redo_record& record)
+        {
+            uint32_t key;
+            uint64_t value;
+            std::memcpy(&key, record.key, sizeof(key));
+            BOOST_REQUIRE(record.read_value(value));
+
+            std::lock_guard<std::mutex> lock(mutex);
+            values[key].push_back(value);
+        }, 4));
+
+    for (const auto& key_values: values)
+    {
+        BOOST_REQUIRE_EQUAL(key_values.size(), updates);
+        for (uint64_t value = 0; value < updates; ++value)
+            BOOST_CHECK_EQUAL(key_values[value], value);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,77 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include <bitcoin/database/durability/parallel_for.hpp>
+
+using namespace bc::database::durability;
+
+BOOST_AUTO_TEST_SUITE(parallel_for_tests)
+
+BOOST_AUTO_TEST_CASE(parallel_for__ranges__every_index_once)
+{
+    static const size_t count = 1000;
+    std::vector<std::atomic<size_t>> calls(count);
+
+    // Called repeatedly, on the workers started by the first call.
+    for (size_t threads = 1; threads <= 8; ++threads)
+        parallel_for(count, threads, [&](size_t begin, size_t end)
+        {
+            for (auto index = begin; index < end; ++index)
+                ++calls[index];
+        });
+
+    for (const auto& called: calls)
+        BOOST_REQUIRE_EQUAL(called.load(), 8u);
+}
+
+BOOST_AUTO_TEST_CASE(parallel_for__nested__completes)
+{
+    std::atomic<size_t> total(0);
+    const auto size = thread_pool::shared().size();
+
+    // Each outer range may hold a worker while its inner call runs.
+    parallel_for(size + 2, size + 2, [&](size_t begin, size_t end)
+    {
+        for (auto outer = begin; outer < end; ++outer)
+            parallel_for(100, 4, [&](size_t inner, size_t last)
+            {
+                total += last - inner;
+            });
+    });
+
+    BOOST_CHECK_EQUAL(total.load(), (size + 2) * 100);
+}
+
+BOOST_AUTO_TEST_CASE(parallel_for__empty__no_calls)
+{
+    auto called = false;
+    parallel_for(0, 4, [&](size_t, size_t)
+    {
+        called = true;
+    });
+
+    BOOST_CHECK(!called);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
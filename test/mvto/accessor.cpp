@@ -19,6 +19,7 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <bitcoin/database/durability/log_manager.hpp>
 #include <bitcoin/database/mvto/accessor.hpp>
 #include <bitcoin/database/transaction_management/transaction_context.hpp>
 #include <bitcoin/database/transaction_management/transaction_manager.hpp>
@@ -308,4 +309,149 @@ BOOST_AUTO_TEST_CASE(accessor__get__third_version__success)
     BOOST_CHECK_EQUAL(read_result->state, 1);
 }
 
+BOOST_AUTO_TEST_CASE(accessor__update__abort__undo__success)
+{
+    const uint64_t size_limit = 1;
+    const uint64_t reuse_limit = 1;
+
+    const block_pool_ptr block_store_pool = std::make_shared<block_pool>(size_limit, reuse_limit);
+    auto block_store_ptr = std::make_shared<store<block_mvcc_record>>(block_store_pool);
+
+    // delta storage
+    const block_pool_ptr delta_store_pool = std::make_shared<block_pool>(size_limit, reuse_limit);
+    auto delta_store_ptr = std::make_shared<store<block_delta_mvcc_record>>(delta_store_pool);
+
+    block_mvto_accessor instance{block_store_ptr, delta_store_ptr};
+
+    transaction_manager manager;
+    auto context = manager.begin_transaction();
+
+    auto record_data = std::make_shared<block_tuple>();
+    record_data->height = 1010;
+    record_data->state = 5;
+
+    auto result = instance.put(context, record_data);
+    BOOST_REQUIRE(result);
+    context.commit();
+
+    auto record_ptr = block_store_ptr->get_bytes_at(result);
+    const auto end_ts = record_ptr->get_end_timestamp();
+
+    // two updates in the same transaction, then abort
+    auto context2 = manager.begin_transaction();
+    auto delta_data = std::make_shared<block_tuple_delta>();
+    delta_data->state = 10;
+    BOOST_REQUIRE(instance.update(context2, result, delta_data));
+    delta_data = std::make_shared<block_tuple_delta>();
+    delta_data->state = 11;
+    BOOST_REQUIRE(instance.update(context2, result, delta_data));
+    context2.abort();
+
+    BOOST_CHECK(record_ptr->get_next() == block_mvcc_record::no_next);
+    BOOST_CHECK_EQUAL(record_ptr->get_end_timestamp(), end_ts);
+    BOOST_CHECK(!record_ptr->is_latched_by(context2));
+
+    auto context3 = manager.begin_transaction();
+    auto read_result = instance.get(context3, result, block_tuple::read_from_delta);
+    BOOST_CHECK_EQUAL(read_result->state, 5);
+
+    // the record can be updated again
+    delta_data = std::make_shared<block_tuple_delta>();
+    delta_data->state = 12;
+    BOOST_REQUIRE(instance.update(context3, result, delta_data));
+    context3.commit();
+
+    auto context4 = manager.begin_transaction();
+    read_result = instance.get(context4, result, block_tuple::read_from_delta);
+    BOOST_CHECK_EQUAL(read_result->state, 12);
+}
+
+BOOST_AUTO_TEST_CASE(accessor__put__abort__released_unreadable__success)
+{
+    const uint64_t size_limit = 1;
+    const uint64_t reuse_limit = 1;
+
+    const block_pool_ptr block_store_pool = std::make_shared<block_pool>(size_limit, reuse_limit);
+    auto block_store_ptr = std::make_shared<store<block_mvcc_record>>(block_store_pool);
+
+    // delta storage
+    const block_pool_ptr delta_store_pool = std::make_shared<block_pool>(size_limit, reuse_limit);
+    auto delta_store_ptr = std::make_shared<store<block_delta_mvcc_record>>(delta_store_pool);
+
+    block_mvto_accessor instance{block_store_ptr, delta_store_ptr};
+
+    transaction_manager manager;
+    auto context = manager.begin_transaction();
+
+    auto record_data = std::make_shared<block_tuple>();
+    record_data->height = 1010;
+
+    auto result = instance.put(context, record_data);
+    BOOST_REQUIRE(result);
+
+    auto delta_data = std::make_shared<block_tuple_delta>();
+    delta_data->state = 10;
+    BOOST_REQUIRE(instance.update(context, result, delta_data));
+    context.abort();
+
+    // aborted insert is released, not leaked latched
+    const auto record = block_store_ptr->get_bytes_at(result);
+    BOOST_CHECK_EQUAL(record->get_txn_id(), not_latched);
+    BOOST_CHECK_EQUAL(record->get_begin_timestamp(), infinity);
+
+    // and is never readable by later transactions or snapshots
+    auto context2 = manager.begin_transaction();
+    auto read_result = instance.get(context2, result, block_tuple::read_from_delta);
+    BOOST_CHECK(read_result == block_mvcc_record::not_found);
+    BOOST_CHECK(record->read_snapshot(context2.get_timestamp(),
+        block_tuple::read_from_delta) == block_mvcc_record::not_found);
+}
+
+BOOST_AUTO_TEST_CASE(accessor__update__abort_same_timestamp_as_insert__released)
+{
+    const uint64_t size_limit = 1;
+    const uint64_t reuse_limit = 1;
+
+    const block_pool_ptr block_store_pool = std::make_shared<block_pool>(size_limit, reuse_limit);
+    auto block_store_ptr = std::make_shared<store<block_mvcc_record>>(block_store_pool);
+
+    // delta storage
+    const block_pool_ptr delta_store_pool = std::make_shared<block_pool>(size_limit, reuse_limit);
+    auto delta_store_ptr = std::make_shared<store<block_delta_mvcc_record>>(delta_store_pool);
+
+    block_mvto_accessor instance{block_store_ptr, delta_store_ptr};
+
+    // Recovery contexts all share one timestamp.
+    transaction_context context(durability::recovery_timestamp, state::active);
+    auto record_data = std::make_shared<block_tuple>();
+    record_data->height = 1010;
+    record_data->state = 5;
+
+    auto result = instance.put(context, record_data);
+    BOOST_REQUIRE(result);
+    context.commit();
+
+    const auto record = block_store_ptr->get_bytes_at(result);
+    const auto end_ts = record->get_end_timestamp();
+
+    // An update by another context of that timestamp, aborted.
+    transaction_context context2(durability::recovery_timestamp,
+        state::active);
+    auto delta_data = std::make_shared<block_tuple_delta>();
+    delta_data->state = 10;
+    BOOST_REQUIRE(instance.update(context2, result, delta_data));
+    context2.abort();
+
+    BOOST_CHECK_EQUAL(record->get_txn_id(), not_latched);
+    BOOST_CHECK_EQUAL(record->get_end_timestamp(), end_ts);
+    BOOST_CHECK(record->get_next() == block_mvcc_record::no_next);
+
+    transaction_context context3(durability::recovery_timestamp,
+        state::active);
+    const auto read_result = instance.get(context3, result,
+        block_tuple::read_from_delta);
+    BOOST_REQUIRE(read_result != block_mvcc_record::not_found);
+    BOOST_CHECK_EQUAL(read_result->state, 5);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
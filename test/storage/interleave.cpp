@@ -0,0 +1,101 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+
+#include <bitcoin/database/storage/interleave.hpp>
+
+using namespace libbitcoin::database::storage;
+
+namespace {
+
+// Takes steps steps, logging which lookup ran at each.
+struct counted_lookup
+{
+    bool step()
+    {
+        log->push_back(index);
+        return --remaining != 0;
+    }
+
+    size_t index;
+    size_t remaining;
+    std::vector<size_t>* log;
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(interleave_tests)
+
+BOOST_AUTO_TEST_CASE(interleave__no_lookups__none_started)
+{
+    size_t started = 0;
+    interleave<counted_lookup>(0, 4, [&](size_t, counted_lookup&)
+    {
+        ++started;
+    });
+
+    BOOST_CHECK_EQUAL(started, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(interleave__width_one__sequential)
+{
+    std::vector<size_t> log;
+    interleave<counted_lookup>(3, 1, [&](size_t index, counted_lookup& lookup)
+    {
+        lookup = { index, 2, &log };
+    });
+
+    const std::vector<size_t> expected{ 0, 0, 1, 1, 2, 2 };
+    BOOST_CHECK_EQUAL_COLLECTIONS(log.begin(), log.end(), expected.begin(),
+        expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(interleave__width_two__round_robin_refilled)
+{
+    std::vector<size_t> log;
+    interleave<counted_lookup>(3, 2, [&](size_t index, counted_lookup& lookup)
+    {
+        // The first lookup takes one step, the others two.
+        lookup = { index, index == 0 ? 1u : 2u, &log };
+    });
+
+    // Lookup 2 takes the place of lookup 0 once it is done.
+    const std::vector<size_t> expected{ 0, 1, 2, 1, 2 };
+    BOOST_CHECK_EQUAL_COLLECTIONS(log.begin(), log.end(), expected.begin(),
+        expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(interleave__width_above_count__all_done)
+{
+    std::vector<size_t> log;
+    interleave<counted_lookup>(5, 64, [&](size_t index, counted_lookup& lookup)
+    {
+        lookup = { index, index + 1, &log };
+    });
+
+    BOOST_CHECK_EQUAL(log.size(), 1u + 2u + 3u + 4u + 5u);
+    for (size_t index = 0; index < 5; ++index)
+        BOOST_CHECK_EQUAL(std::count(log.begin(), log.end(), index),
+            int(index + 1));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
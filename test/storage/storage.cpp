@@ -17,6 +17,8 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <vector>
 #include <boost/test/unit_test.hpp>
 
 #include <bitcoin/database/storage/storage.hpp>
@@ -30,6 +32,7 @@ using namespace bc;
 using namespace bc::database;
 using namespace bc::database::storage;
 using namespace bc::database::tuples;
+using namespace bc::system;
 
 BOOST_AUTO_TEST_SUITE(storage_tests)
 
@@ -557,4 +560,85 @@ BOOST_AUTO_TEST_CASE(storage__update_abort__undo__success)
   BOOST_REQUIRE_EQUAL(read_result->state, 0);
 }
 
+BOOST_AUTO_TEST_CASE(storage__cold_column__does_not_overlap_records__success)
+{
+  const uint64_t size_limit = 10;
+  const uint64_t reuse_limit = 1;
+  const block_pool_ptr pool = std::make_shared<block_pool>(size_limit, reuse_limit);
+
+  store<block_mvcc_record> instance{pool, sizeof(hash_digest)};
+
+  transaction_manager manager;
+  auto context = manager.begin_transaction();
+
+  // Enough records to fill the first block and move to the next.
+  const size_t count = BLOCK_SIZE / (sizeof(block_mvcc_record) + sizeof(hash_digest)) + 10;
+  std::vector<slot> slots;
+  for (size_t index = 0; index < count; ++index)
+  {
+    block_mvcc_record record(context);
+    record.get_data().height = index;
+    const auto at_slot = instance.insert(context, record);
+
+    hash_digest hash{};
+    hash[0] = uint8_t(index);
+    hash[31] = uint8_t(index >> 8);
+    *instance.get_cold_at<hash_digest>(at_slot) = hash;
+    slots.push_back(at_slot);
+  }
+
+  BOOST_REQUIRE(slots.front().get_block() != slots.back().get_block());
+
+  for (size_t index = 0; index < count; ++index)
+  {
+    BOOST_REQUIRE_EQUAL(instance.get_bytes_at(slots[index])->get_data().height, index);
+    const auto& hash = *instance.get_cold_at<hash_digest>(slots[index]);
+    BOOST_REQUIRE_EQUAL(hash[0], uint8_t(index));
+    BOOST_REQUIRE_EQUAL(hash[31], uint8_t(index >> 8));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(storage__insert__full_block__records_follow_slot_bitmap__success)
+{
+  const uint64_t size_limit = 10;
+  const uint64_t reuse_limit = 1;
+  const block_pool_ptr pool = std::make_shared<block_pool>(size_limit, reuse_limit);
+
+  store<block_delta_mvcc_record> instance{pool};
+
+  transaction_manager manager;
+  auto context = manager.begin_transaction();
+
+  // Small records, so the bitmap of a block spans many words. Each
+  // allocation sets a bitmap bit, none may land in a record.
+  const size_t count = BLOCK_SIZE / sizeof(block_delta_mvcc_record) + 10;
+  std::vector<slot> slots;
+  for (size_t index = 0; index < count; ++index)
+  {
+    block_delta_mvcc_record record(context);
+    slots.push_back(instance.insert(context, record));
+  }
+
+  BOOST_REQUIRE(slots.front().get_block() != slots.back().get_block());
+
+  const auto first = slots.front().get_block();
+  const auto in_first = std::count_if(slots.begin(), slots.end(),
+      [first](const slot& at_slot) { return at_slot.get_block() == first; });
+
+  const auto start = reinterpret_cast<uintptr_t>(first);
+  const auto records = reinterpret_cast<uintptr_t>(
+      instance.get_bytes_at(slots.front()));
+  BOOST_CHECK_GE(records - start,
+      sizeof(uint64_t) + raw_bitmap::size_in_bytes(in_first));
+  BOOST_CHECK_LE(records - start + in_first * sizeof(block_delta_mvcc_record),
+      size_t(BLOCK_SIZE));
+
+  for (const auto& at_slot: slots)
+  {
+    const auto record = instance.get_bytes_at(at_slot);
+    BOOST_REQUIRE_EQUAL(record->get_begin_timestamp(), context.get_timestamp());
+    BOOST_REQUIRE(record->get_next() == block_delta_mvcc_record::no_next);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
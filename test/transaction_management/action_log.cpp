@@ -0,0 +1,83 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <bitcoin/database/transaction_management/action_log.hpp>
+
+using namespace bc;
+using namespace bc::database;
+
+BOOST_AUTO_TEST_SUITE(action_log_tests)
+
+BOOST_AUTO_TEST_CASE(action_log__constructor__empty__success)
+{
+    action_log instance;
+    BOOST_CHECK(instance.empty());
+    BOOST_CHECK_EQUAL(instance.size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(action_log__push_back__beyond_inline_capacity__success)
+{
+    action_log instance;
+    const size_t count = action_log::inline_capacity +
+        2 * action_log::chunk_capacity + 3;
+
+    for (size_t index = 0; index < count; ++index)
+        instance.push_back({ nullptr, nullptr, nullptr, index,
+            action_type::append });
+
+    BOOST_REQUIRE_EQUAL(instance.size(), count);
+    for (size_t index = 0; index < count; ++index)
+        BOOST_CHECK_EQUAL(instance[index].old_end_timestamp, index);
+}
+
+BOOST_AUTO_TEST_CASE(action_log__copy__beyond_inline_capacity__success)
+{
+    action_log instance;
+    const size_t count = action_log::inline_capacity + 5;
+
+    for (size_t index = 0; index < count; ++index)
+        instance.push_back({ nullptr, nullptr, nullptr, index,
+            action_type::insert });
+
+    action_log copy(instance);
+    instance[count - 1].old_end_timestamp = 0;
+
+    BOOST_REQUIRE_EQUAL(copy.size(), count);
+    BOOST_CHECK_EQUAL(copy[count - 1].old_end_timestamp, count - 1);
+}
+
+BOOST_AUTO_TEST_CASE(action_log__clear__reuse__success)
+{
+    action_log instance;
+    const size_t count = action_log::inline_capacity + 1;
+
+    for (size_t index = 0; index < count; ++index)
+        instance.push_back({ nullptr, nullptr, nullptr, index,
+            action_type::insert });
+
+    instance.clear();
+    BOOST_CHECK(instance.empty());
+
+    instance.push_back({ nullptr, nullptr, nullptr, 42, action_type::insert });
+    BOOST_REQUIRE_EQUAL(instance.size(), 1);
+    BOOST_CHECK_EQUAL(instance[0].old_end_timestamp, 42);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -18,6 +18,11 @@
  */
 #include <boost/test/unit_test.hpp>
 
+#include <chrono>
+#include <filesystem>
+
+#include <bitcoin/database/durability/log_manager.hpp>
+#include <bitcoin/database/durability/redo_record.hpp>
 #include <bitcoin/database/transaction_management/transaction_manager.hpp>
 
 using namespace bc;
@@ -56,4 +61,49 @@ BOOST_AUTO_TEST_CASE(transaction_manager__remove_transaction__active__fails)
     BOOST_CHECK(!manager.is_active(context));
 }
 
+BOOST_AUTO_TEST_CASE(transaction_manager__oldest_active__removed__next_oldest)
+{
+    transaction_manager manager;
+    BOOST_CHECK_EQUAL(manager.oldest_active(), 1u);
+
+    auto first = manager.begin_transaction();
+    auto second = manager.begin_transaction();
+    BOOST_CHECK_EQUAL(manager.oldest_active(), first.get_timestamp());
+
+    manager.commit_transaction(first);
+    manager.remove_transaction(first);
+    BOOST_CHECK_EQUAL(manager.oldest_active(), second.get_timestamp());
+
+    manager.commit_transaction(second);
+    manager.remove_transaction(second);
+    BOOST_CHECK_EQUAL(manager.oldest_active(), second.get_timestamp() + 1);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_manager__commit_transaction__log_closed__fails)
+{
+    const auto log = std::make_shared<durability::log_manager>(
+        (std::filesystem::temp_directory_path() /
+            "libbitcoin_mvcc_transaction_manager_tests").string(),
+        std::chrono::microseconds(1000), 4096, true);
+    BOOST_REQUIRE(log->create());
+
+    transaction_manager manager(log);
+    auto context = manager.begin_transaction();
+    context.register_redo(durability::table_id::block,
+        durability::redo_operation::insert, uint32_t(1), uint32_t(2));
+    BOOST_CHECK(manager.commit_transaction(context));
+
+    // A closed log refuses the frame, the commit is not durable.
+    BOOST_REQUIRE(log->close());
+    context = manager.begin_transaction();
+    context.register_redo(durability::table_id::block,
+        durability::redo_operation::insert, uint32_t(1), uint32_t(3));
+    BOOST_CHECK(!manager.commit_transaction(context));
+    BOOST_CHECK(context.get_state() == state::committed);
+
+    // Nothing to log is trivially durable.
+    context = manager.begin_transaction();
+    BOOST_CHECK(manager.commit_transaction(context));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -174,6 +174,42 @@ BOOST_AUTO_TEST_CASE(mvcc_record__read__visible__success)
     BOOST_CHECK_EQUAL(delta->get_read_timestamp(), context2.get_timestamp());
 }
 
+BOOST_AUTO_TEST_CASE(mvcc_record__read_snapshot__uncommitted_delta__skipped)
+{
+    transaction_manager manager;
+    auto context = manager.begin_transaction();
+
+    auto record = std::make_shared<block_mvcc_record>(context);
+    record->get_data().state = 1;
+    record->install(context);
+    context.register_insert_action(record.get());
+    context.commit();
+
+    auto snapshot = manager.begin_transaction();
+    BOOST_CHECK(record->read_snapshot(context.get_timestamp() - 1,
+        block_tuple::read_from_delta) == block_mvcc_record::not_found);
+
+    // a writer that began before the snapshot has not committed yet
+    auto writer = manager.begin_transaction();
+    auto delta = record->allocate_next(writer);
+    delta->get_data().state = 2;
+    BOOST_REQUIRE(record->install_next_version(delta, writer));
+
+    auto result = record->read_snapshot(snapshot.get_timestamp(),
+        block_tuple::read_from_delta);
+    BOOST_CHECK_EQUAL(result->state, 1);
+
+    // the snapshot read leaves the writer free to commit
+    BOOST_CHECK_EQUAL(record->get_read_timestamp(), none_read);
+    writer.register_append_action(record.get(), delta.get(), infinity,
+        block_mvcc_record::no_next);
+    writer.commit();
+
+    result = record->read_snapshot(writer.get_timestamp(),
+        block_tuple::read_from_delta);
+    BOOST_CHECK_EQUAL(result->state, 2);
+}
+
 // TODO: A test to capture a transaction with id less than a record's
 // read_timestamp should not be able to commit
 